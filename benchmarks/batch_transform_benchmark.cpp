@@ -0,0 +1,98 @@
+// Compares element-wise transform/and_then over a span of expected with the branchless batch algorithms,
+// across error rates.
+
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/expected_batch.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+enum class ErrorCode { Success, InvalidArgument, OtherError };
+
+using Sample = expected<int, ErrorCode>;
+using Scaled = expected<float, ErrorCode>;
+
+std::vector<Sample> make_samples(std::size_t count, double error_rate) {
+    std::mt19937 rng(7);
+    std::bernoulli_distribution fails(error_rate);
+    std::vector<Sample> samples;
+    samples.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        samples.push_back(fails(rng) ? Sample{unexpected{ErrorCode::InvalidArgument}} : Sample{static_cast<int>(rng() % 4096)});
+    }
+    return samples;
+}
+
+float scale(int raw) {
+    return static_cast<float>(raw) * 0.25f - 12.0f;
+}
+
+Scaled checked_scale(int raw) {
+    if (raw > 4000) {
+        return unexpected{ErrorCode::OtherError};
+    }
+    return scale(raw);
+}
+
+void run(std::size_t count, double error_rate) {
+    const std::vector<Sample> samples = make_samples(count, error_rate);
+    std::vector<Scaled> expected_out(count);
+    std::vector<Scaled> batch_out(count);
+    const std::span<const Sample> in(samples);
+
+    const double transform_loop = bench::measure_ns([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            expected_out[i] = samples[i].transform(scale);
+        }
+        bench::do_not_optimize(expected_out.data());
+    }, count);
+    const double transform_batch = bench::measure_ns([&] {
+        std::experimental::batch_transform(in, std::span<Scaled>(batch_out), scale);
+        bench::do_not_optimize(batch_out.data());
+    }, count);
+    if (expected_out != batch_out) {
+        std::printf("batch_transform mismatch\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const double and_then_loop = bench::measure_ns([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            expected_out[i] = samples[i].and_then(checked_scale);
+        }
+        bench::do_not_optimize(expected_out.data());
+    }, count);
+    const double and_then_batch = bench::measure_ns([&] {
+        std::experimental::batch_and_then(in, std::span<Scaled>(batch_out), checked_scale);
+        bench::do_not_optimize(batch_out.data());
+    }, count);
+    if (expected_out != batch_out) {
+        std::printf("batch_and_then mismatch\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "transform/%g%% errors", error_rate * 100);
+    bench::print_row(name, transform_loop, transform_batch);
+    std::snprintf(name, sizeof(name), "and_then/%g%% errors", error_rate * 100);
+    bench::print_row(name, and_then_loop, and_then_batch);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 20;
+
+    std::printf("%zu elements, expected<int, ErrorCode> -> expected<float, ErrorCode> (ns per element)\n\n", count);
+    bench::print_header("operation/error rate", "member loop", "batch");
+    for (const double error_rate : {0.0, 0.01, 0.05, 0.1, 0.5}) {
+        run(count, error_rate);
+    }
+}
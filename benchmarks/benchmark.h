@@ -0,0 +1,164 @@
+#pragma once
+
+// Minimal timing harness shared by the benchmarks: no dependencies beyond the standard library.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+// Keeps the compiler from discarding a computed value or the stores that produced it.
+template <class T>
+inline void do_not_optimize(const T& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const void* volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+// Runs setup() then body() repeatedly, timing only body(), which performs ops_per_run operations.
+// Returns the best observed ns per operation.
+template <class Setup, class Body>
+double measure_ns(Setup&& setup, Body&& body, std::size_t ops_per_run, int repetitions = 7) {
+    using clock = std::chrono::steady_clock;
+
+    double best = 1e300;
+    for (int rep = 0; rep <= repetitions; ++rep) {
+        setup();
+        const auto start = clock::now();
+        body();
+        const auto stop = clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        if (rep != 0) { // the first run only warms up caches and the allocator
+            best = (std::min)(best, ns / static_cast<double>(ops_per_run));
+        }
+    }
+    return best;
+}
+
+template <class Body>
+double measure_ns(Body&& body, std::size_t ops_per_run, int repetitions = 7) {
+    return measure_ns([] {}, body, ops_per_run, repetitions);
+}
+
+enum class hardware_event { instructions, branch_misses };
+
+// Counts a hardware event of the calling thread in user mode through perf_event_open. available() is false
+// on other platforms and where the kernel refuses (perf_event_paranoid, containers, VMs without a PMU).
+class event_counter {
+public:
+    explicit event_counter(hardware_event event) noexcept {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = event == hardware_event::instructions ? PERF_COUNT_HW_INSTRUCTIONS : PERF_COUNT_HW_BRANCH_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void) event;
+#endif
+    }
+
+    event_counter(const event_counter&) = delete;
+    event_counter& operator=(const event_counter&) = delete;
+
+    ~event_counter() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    bool available() const noexcept {
+        return fd_ >= 0;
+    }
+
+    void start() noexcept {
+#if defined(__linux__)
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    std::uint64_t stop() noexcept {
+        std::uint64_t count = 0;
+#if defined(__linux__)
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+            count = 0;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// Like measure_ns, but returns the fewest events per operation, or a negative value when counting is unavailable.
+template <class Setup, class Body>
+double measure_events(event_counter& counter, Setup&& setup, Body&& body, std::size_t ops_per_run, int repetitions = 7) {
+    if (!counter.available()) {
+        return -1;
+    }
+
+    double best = 1e300;
+    for (int rep = 0; rep <= repetitions; ++rep) {
+        setup();
+        counter.start();
+        body();
+        const std::uint64_t events = counter.stop();
+        if (rep != 0) {
+            best = (std::min)(best, static_cast<double>(events) / static_cast<double>(ops_per_run));
+        }
+    }
+    return best;
+}
+
+template <class Body>
+double measure_events(event_counter& counter, Body&& body, std::size_t ops_per_run, int repetitions = 7) {
+    return measure_events(counter, [] {}, body, ops_per_run, repetitions);
+}
+
+// Formats an event count from measure_events, or "n/a"
+inline const char* format_events(char (&buffer)[32], double events) {
+    if (events < 0) {
+        std::snprintf(buffer, sizeof(buffer), "n/a");
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.3f", events);
+    }
+    return buffer;
+}
+
+inline void print_header(const char* first_column, const char* baseline, const char* candidate) {
+    std::printf("%-52s %14s %14s %9s\n", first_column, baseline, candidate, "speedup");
+}
+
+inline void print_row(const char* name, double baseline_ns, double candidate_ns) {
+    std::printf("%-52s %11.2f ns %11.2f ns %8.2fx\n", name, baseline_ns, candidate_ns, baseline_ns / candidate_ns);
+}
+
+} // namespace bench
@@ -0,0 +1,87 @@
+// Produces and then consumes a buffer of expected<int, E> whose error is a message plus a code, once with the
+// error held inline and once boxed (expected<int, boxed_error<E>>), at failure rates from 0.1% to 10%. The inline
+// form is 40 bytes per result and the boxed form 16, so the boxed buffer takes less than half the cache.
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/expected_boxed.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::boxed_error;
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+struct RichError {
+    std::string message;
+    int code;
+};
+
+template <class E>
+[[gnu::noinline]] expected<int, E> parse(int input, bool fails) {
+    if (fails) {
+        return unexpected{RichError{"input rejected by the validator", input}};
+    }
+    return input * 3;
+}
+
+template <class E>
+int error_code_of(const E& error) {
+    if constexpr (std::is_same_v<E, RichError>) {
+        return error.code;
+    } else {
+        return error->code;
+    }
+}
+
+template <class E>
+double measure(const std::vector<int>& inputs, const std::vector<bool>& failures) {
+    std::vector<expected<int, E>> results;
+    results.reserve(inputs.size());
+    return bench::measure_ns(
+        [&] { results.clear(); },
+        [&] {
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                results.push_back(parse<E>(inputs[i], failures[i]));
+            }
+            long long sum = 0;
+            for (const expected<int, E>& result : results) {
+                sum += result ? *result : error_code_of(result.error());
+            }
+            bench::do_not_optimize(sum);
+        },
+        inputs.size());
+}
+
+void run(std::size_t count, double failure_rate) {
+    std::mt19937 rng(3);
+    std::bernoulli_distribution fails(failure_rate);
+    std::vector<int> inputs(count);
+    std::vector<bool> failures(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs[i]   = static_cast<int>(rng() % 1000);
+        failures[i] = fails(rng);
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%g%% failing", failure_rate * 100);
+    bench::print_row(name, measure<RichError>(inputs, failures), measure<boxed_error<RichError>>(inputs, failures));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+
+    std::printf("sizeof(expected<int, E>) %zu, sizeof(expected<int, boxed_error<E>>) %zu\n",
+        sizeof(expected<int, RichError>), sizeof(expected<int, boxed_error<RichError>>));
+    std::printf("%zu results per run, ns per result\n\n", count);
+    bench::print_header("failure rate", "inline error", "boxed error");
+    for (const double failure_rate : {0.001, 0.01, 0.1}) {
+        run(count, failure_rate);
+    }
+}
@@ -0,0 +1,135 @@
+// Compares accessors that branch on has_value() with value_or_select/error_or_select, and a comparison built on
+// value_or_select, across failure probabilities from 0% to 50%.
+// Branch misses are counted with perf_event_open where the kernel allows it, and reported as n/a otherwise.
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+using Result = expected<int, int>;
+
+std::vector<Result> make_results(std::size_t count, double failure_rate) {
+    std::mt19937 rng(11);
+    std::bernoulli_distribution fails(failure_rate);
+    std::vector<Result> results;
+    results.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        results.push_back(fails(rng) ? Result{unexpected{static_cast<int>(rng() % 64)}} : Result{static_cast<int>(rng() % 4096)});
+    }
+    return results;
+}
+
+// The accessors as value_or, error_or and operator== read: test has_value(), then take one alternative.
+[[gnu::noinline]] long long branchy_value_or(const std::vector<Result>& results, int fallback) {
+    long long sum = 0;
+    for (const Result& result : results) {
+        if (result.has_value()) {
+            sum += *result;
+        } else {
+            sum += fallback;
+        }
+    }
+    return sum;
+}
+
+[[gnu::noinline]] long long branchy_error_or(const std::vector<Result>& results, int fallback) {
+    long long sum = 0;
+    for (const Result& result : results) {
+        if (result.has_value()) {
+            sum += fallback;
+        } else {
+            sum += result.error();
+        }
+    }
+    return sum;
+}
+
+[[gnu::noinline]] long long branchy_equals(const std::vector<Result>& results, int value) {
+    long long matches = 0;
+    for (const Result& result : results) {
+        if (result.has_value()) {
+            matches += *result == value;
+        }
+    }
+    return matches;
+}
+
+[[gnu::noinline]] long long select_value_or(const std::vector<Result>& results, int fallback) {
+    long long sum = 0;
+    for (const Result& result : results) {
+        sum += result.value_or_select(fallback);
+    }
+    return sum;
+}
+
+[[gnu::noinline]] long long select_error_or(const std::vector<Result>& results, int fallback) {
+    long long sum = 0;
+    for (const Result& result : results) {
+        sum += result.error_or_select(fallback);
+    }
+    return sum;
+}
+
+[[gnu::noinline]] long long select_equals(const std::vector<Result>& results, int value) {
+    long long matches = 0;
+    for (const Result& result : results) {
+        matches += result.value_or_select(value + 1) == value; // the fallback never matches
+    }
+    return matches;
+}
+
+using Kernel = long long (*)(const std::vector<Result>&, int);
+
+void run(const char* accessor, const std::vector<Result>& results, double failure_rate, Kernel baseline,
+    Kernel candidate, int argument, bench::event_counter& misses) {
+    if (baseline(results, argument) != candidate(results, argument)) {
+        std::printf("%s mismatch\n", accessor);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const std::size_t count = results.size();
+    const auto time = [&](Kernel kernel) {
+        return bench::measure_ns([&] { bench::do_not_optimize(kernel(results, argument)); }, count);
+    };
+    const auto count_misses = [&](Kernel kernel) {
+        return bench::measure_events(misses, [&] { bench::do_not_optimize(kernel(results, argument)); }, count);
+    };
+
+    const double baseline_ns = time(baseline);
+    const double candidate_ns = time(candidate);
+    char baseline_misses[32];
+    char candidate_misses[32];
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s/%g%% failures", accessor, failure_rate * 100);
+    std::printf("%-28s %11.2f ns %11.2f ns %8.2fx %12s %12s\n", name, baseline_ns, candidate_ns,
+        baseline_ns / candidate_ns, bench::format_events(baseline_misses, count_misses(baseline)),
+        bench::format_events(candidate_misses, count_misses(candidate)));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+    bench::event_counter misses(bench::hardware_event::branch_misses);
+
+    std::printf("%zu elements of expected<int, int> (ns and branch misses per element)\n", count);
+    if (!misses.available()) {
+        std::printf("perf_event_open is not available here; branch misses are not reported\n");
+    }
+    std::printf("\n%-28s %14s %14s %9s %12s %12s\n", "accessor/failure rate", "branchy", "select", "speedup",
+        "branchy miss", "select miss");
+    for (const double failure_rate : {0.0, 0.05, 0.1, 0.2, 0.3, 0.4, 0.5}) {
+        const std::vector<Result> results = make_results(count, failure_rate);
+        run("value_or", results, failure_rate, branchy_value_or, select_value_or, -1, misses);
+        run("error_or", results, failure_rate, branchy_error_or, select_error_or, 0, misses);
+        run("operator==", results, failure_rate, branchy_equals, select_equals, 42, misses);
+    }
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# Compiles copy_codegen_probe.cpp and checks that std::copy and std::move over expected with trivially copyable
+# alternatives compile to a call to memmove, which needs expected itself to be trivially copyable.
+#
+# usage: check_copy_codegen.sh [compiler] [extra flags...]
+# Exits nonzero on a regression. Needs objdump.
+
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+cxx=${1:-${CXX:-c++}}
+[ $# -gt 0 ] && shift
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+"$cxx" -std=c++20 -O2 "$@" -c "$here/copy_codegen_probe.cpp" -o "$work/probe.o"
+objdump -dr --no-show-raw-insn "$work/probe.o" > "$work/probe.s"
+
+status=0
+
+# check <function>
+check() {
+    body=$(awk -v name="<$1>:" '$2 == name { found = 1; next } found && /^$/ { exit } found' "$work/probe.s")
+    if [ -z "$body" ]; then
+        echo "FAIL $1: not found in the disassembly"
+        status=1
+    elif printf '%s\n' "$body" | grep -q 'memmove'; then
+        echo "ok   $1: calls memmove"
+    else
+        echo "FAIL $1: the copy does not call memmove"
+        status=1
+    fi
+}
+
+check probe_copy_int
+check probe_copy_void
+check probe_copy_struct
+check probe_move_int
+
+exit $status
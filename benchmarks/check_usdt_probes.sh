@@ -0,0 +1,76 @@
+#!/bin/sh
+# Builds usdt_probe_sites.cpp with _EXPECTED_PROBES=1 and checks the USDT probes of [expected.probes] in the
+# program: each probe has a .note.stapsdt note for provider cpp20_expected with three arguments, each probe
+# address holds a nop, and the program runs. Built without _EXPECTED_PROBES, the program must have no notes.
+#
+# usage: check_usdt_probes.sh [compiler] [extra flags...]
+# Exits nonzero on a regression. Needs readelf and objdump, and an ELF target on x86-64 or AArch64.
+
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+cxx=${1:-${CXX:-c++}}
+[ $# -gt 0 ] && shift
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+"$cxx" -std=c++20 -O2 "$@" -D_EXPECTED_PROBES=1 "$here/usdt_probe_sites.cpp" -o "$work/probes"
+"$cxx" -std=c++20 -O2 "$@" "$here/usdt_probe_sites.cpp" -o "$work/no_probes"
+readelf -n "$work/probes" > "$work/notes"
+objdump -d --no-show-raw-insn "$work/probes" > "$work/probes.s"
+
+status=0
+
+# check <probe name>
+check() {
+    sites=$(awk -v name="$1" '
+        /Provider:/ { provider = $2 }
+        /Name:/ { probe = $2 }
+        /Location:/ { location = $2; sub(",", "", location) }
+        /Arguments:/ && provider == "cpp20_expected" && probe == name {
+            print location, NF - 1
+        }' "$work/notes")
+    if [ -z "$sites" ]; then
+        echo "FAIL $1: no probe note"
+        status=1
+        return
+    fi
+
+    count=0
+    failed=0
+    while read -r location arguments; do
+        count=$((count + 1))
+        address=$(printf '%x' "$((location))")
+        if [ "$arguments" -ne 3 ]; then
+            echo "FAIL $1: the probe at 0x$address has $arguments arguments, expected 3"
+            failed=1
+        elif ! grep -q "^ *$address:	nop" "$work/probes.s"; then
+            echo "FAIL $1: the probe at 0x$address is not a nop"
+            failed=1
+        fi
+    done <<SITES
+$sites
+SITES
+    if [ $failed -ne 0 ]; then
+        status=1
+    else
+        echo "ok   $1: $count probe sites"
+    fi
+}
+
+check unexpected
+check expected_error
+check bad_access
+
+if readelf -n "$work/no_probes" | grep -q stapsdt; then
+    echo "FAIL probes are emitted without _EXPECTED_PROBES"
+    status=1
+fi
+
+if ! "$work/probes"; then
+    echo "FAIL the program with probes failed"
+    status=1
+fi
+
+exit $status
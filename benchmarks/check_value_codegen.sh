@@ -0,0 +1,53 @@
+#!/bin/sh
+# Compiles value_codegen_probe.cpp and checks that the hot path of value() stays a test, a branch to the
+# out-of-line throw routine and a load: no exception allocation, no register saves, few instructions.
+#
+# usage: check_value_codegen.sh [compiler] [extra flags...]
+# Exits nonzero on a regression. Needs objdump; x86-64 and AArch64 are expected to pass the limits below.
+
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+cxx=${1:-${CXX:-c++}}
+[ $# -gt 0 ] && shift
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+"$cxx" -std=c++20 -O2 "$@" -c "$here/value_codegen_probe.cpp" -o "$work/probe.o"
+objdump -dr --no-show-raw-insn "$work/probe.o" > "$work/probe.s"
+
+status=0
+
+# check <function> <max instructions>
+check() {
+    body=$(awk -v name="<$1>:" '$2 == name { found = 1; next } found && /^$/ { exit } found' "$work/probe.s")
+    if [ -z "$body" ]; then
+        echo "FAIL $1: not found in the disassembly"
+        status=1
+        return
+    fi
+
+    instructions=$(printf '%s\n' "$body" | grep -c '^ *[0-9a-f]*:' || true)
+    if printf '%s\n' "$body" | grep -q '__cxa_allocate_exception\|__cxa_throw\|bad_expected_access.*C[12]E'; then
+        echo "FAIL $1: exception construction is inlined into the hot path"
+        status=1
+    elif printf '%s\n' "$body" | grep -q '	push\|	stp	'; then
+        echo "FAIL $1: the hot path saves registers for the failure path"
+        status=1
+    elif [ "$instructions" -gt "$2" ]; then
+        echo "FAIL $1: $instructions instructions, expected at most $2"
+        status=1
+    else
+        echo "ok   $1: $instructions instructions"
+    fi
+}
+
+check probe_value_int 8
+check probe_value_error_code 8
+check probe_value_string_error 8
+check probe_value_moved_string_error 8
+check probe_value_sum 24
+
+size "$work/probe.o" | awk 'NR == 2 { print "text size of the probe object: " $1 " bytes" }'
+exit $status
@@ -0,0 +1,89 @@
+// Returns expected<int, E> from a non-inlined function and handles the errors at the call site, with E being
+// std::error_code (16 bytes, compared with errc through a virtual call, message() builds a std::string) and
+// compact_error (32 bits, compared as an integer, message() is a string_view). About one call in ten fails.
+
+#include <cstdlib>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/compact_error.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::compact_error;
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+template <class E>
+[[gnu::noinline]] expected<int, E> read_sensor(int input) {
+    if (input % 10 == 0) {
+        return unexpected{E{std::make_error_code(input % 20 == 0 ? std::errc::timed_out : std::errc::io_error)}};
+    }
+    return input + 1;
+}
+
+template <>
+[[gnu::noinline]] expected<int, compact_error> read_sensor(int input) {
+    if (input % 10 == 0) {
+        return unexpected{compact_error{input % 20 == 0 ? std::errc::timed_out : std::errc::io_error}};
+    }
+    return input + 1;
+}
+
+// retries timeouts, gives up on anything else
+template <class E>
+double measure_handling(const std::vector<int>& inputs) {
+    return bench::measure_ns(
+        [&] {
+            long long sum = 0;
+            for (const int input : inputs) {
+                const expected<int, E> result = read_sensor<E>(input);
+                if (result) {
+                    sum += *result;
+                } else if (result.error() == std::errc::timed_out) {
+                    sum += 1;
+                }
+            }
+            bench::do_not_optimize(sum);
+        },
+        inputs.size());
+}
+
+template <class E>
+double measure_messages(const std::vector<int>& inputs) {
+    return bench::measure_ns(
+        [&] {
+            std::size_t length = 0;
+            for (const int input : inputs) {
+                const expected<int, E> result = read_sensor<E>(input);
+                if (!result) {
+                    length += result.error().message().size();
+                }
+            }
+            bench::do_not_optimize(length);
+        },
+        inputs.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+
+    std::mt19937 rng(19);
+    std::vector<int> inputs(count);
+    for (int& input : inputs) {
+        input = static_cast<int>(rng() % 100000);
+    }
+
+    std::printf("sizeof(expected<int, error_code>) %zu, sizeof(expected<int, compact_error>) %zu\n",
+        sizeof(expected<int, std::error_code>), sizeof(expected<int, compact_error>));
+    std::printf("%zu calls per run, ns per call\n\n", count);
+    bench::print_header("operation", "error_code", "compact_error");
+    bench::print_row(
+        "return, test, compare", measure_handling<std::error_code>(inputs), measure_handling<compact_error>(inputs));
+    bench::print_row(
+        "return, test, message()", measure_messages<std::error_code>(inputs), measure_messages<compact_error>(inputs));
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Builds the demo (cpp20_expected.cpp) and value_loop_benchmark.cpp once with exceptions and once with
+# -fno-exceptions, then compares the stripped binary sizes and the hot-loop timings.
+#
+# usage: compare_no_exceptions.sh [compiler] [extra flags...]
+# Pass -D_EXPECTED_FAILURE_POLICY=_EXPECTED_FAILURE_TRAP to measure the trapping policy instead of abort.
+
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+cxx=${1:-${CXX:-c++}}
+[ $# -gt 0 ] && shift
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+for mode in exceptions no-exceptions; do
+    flags="-std=c++20 -O2 -DNDEBUG"
+    [ "$mode" = no-exceptions ] && flags="$flags -fno-exceptions"
+    # shellcheck disable=SC2086 # $flags is a list of flags
+    "$cxx" $flags "$@" "$here/../cpp20_expected/cpp20_expected.cpp" -o "$work/demo-$mode"
+    # shellcheck disable=SC2086
+    "$cxx" $flags "$@" "$here/value_loop_benchmark.cpp" -o "$work/loop-$mode"
+    strip "$work/demo-$mode" "$work/loop-$mode"
+    "$work/loop-$mode" > "$work/times-$mode"
+done
+
+bytes() {
+    wc -c < "$1" | tr -d ' '
+}
+
+printf '%-32s %14s %14s\n' "stripped size (bytes)" "exceptions" "no-exceptions"
+printf '%-32s %14s %14s\n' "cpp20_expected" "$(bytes "$work/demo-exceptions")" "$(bytes "$work/demo-no-exceptions")"
+printf '%-32s %14s %14s\n' "value_loop_benchmark" "$(bytes "$work/loop-exceptions")" "$(bytes "$work/loop-no-exceptions")"
+
+printf '\n%-32s %14s %14s\n' "hot loop (ns per element)" "exceptions" "no-exceptions"
+# the two runs print the same rows in the same order; join them on the row number
+awk 'NR == FNR { time[FNR] = $NF; next }
+     { name = $0; sub(/[ ]+[^ ]+$/, "", name); printf "%-32s %14s %14s\n", name, time[FNR], $NF }' \
+    "$work/times-exceptions" "$work/times-no-exceptions"
+
+"$work/demo-no-exceptions" > /dev/null
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Compiles pipe_chain_benchmark.cpp and compares the code size of each member call chain with the pipe
+# expression computing the same result, then runs the benchmark for the timings.
+#
+# usage: compare_pipe_codegen.sh [compiler] [extra flags...]
+# Needs nm from binutils or LLVM.
+
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+cxx=${1:-${CXX:-c++}}
+[ $# -gt 0 ] && shift
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+"$cxx" -std=c++20 -O2 -DNDEBUG "$@" "$here/pipe_chain_benchmark.cpp" -o "$work/pipe_chain"
+# addresses without leading zeros, so that the symbol table and the disassembly agree
+nm -S "$work/pipe_chain" | awk 'NF == 4 { sub(/^0+/, "", $1); print $1, $2 }' > "$work/sizes"
+nm -C "$work/pipe_chain" | awk '{ sub(/^0+/, "", $1); print }' > "$work/names"
+objdump -d --no-show-raw-insn "$work/pipe_chain" > "$work/disassembly"
+
+# size <function>: the bytes of code of the function and of everything it calls, directly or not, within the
+# program (not through the PLT), since the compiler may leave parts of either chain out of line
+size() {
+    start=$(awk -v name="$1(" 'index($3, name) == 1 { print $1; exit }' "$work/names")
+    if [ -z "$start" ]; then
+        echo "?"
+        return
+    fi
+    total=0
+    for bytes in $(awk -v root="$start" '
+        FILENAME == ARGV[1] { size[$1] = $2; next }
+        /^[0-9a-f]+ <.*>:$/ { current = $1; sub(/^0+/, "", current); next }
+        /\tcall +[0-9a-f]+ </ && !/@plt>/ {
+            for (i = 1; i < NF; ++i) {
+                if ($i ~ /^[0-9a-f]+$/ && $(i + 1) ~ /^</) {
+                    calls[current] = calls[current] " " $i
+                }
+            }
+        }
+        END {
+            queue[0] = root; seen[root] = 1; n = 1
+            for (k = 0; k < n; ++k) {
+                count = split(calls[queue[k]], callees, " ")
+                for (c = 1; c <= count; ++c) {
+                    if (!(callees[c] in seen) && (callees[c] in size)) {
+                        seen[callees[c]] = 1
+                        queue[n++] = callees[c]
+                    }
+                }
+            }
+            for (f in seen) {
+                print size[f]
+            }
+        }' "$work/sizes" "$work/disassembly"); do
+        total=$((total + 0x$bytes))
+    done
+    echo "$total"
+}
+
+printf '%-32s %14s %14s\n' "code size (bytes)" "member chain" "pipe"
+for stages in 4 8 16; do
+    printf '%-32s %14s %14s\n' "$stages stages" "$(size "member_chain_$stages")" "$(size "pipe_chain_$stages")"
+done
+
+echo
+"$work/pipe_chain"
@@ -0,0 +1,34 @@
+// Probe functions for check_copy_codegen.sh. Each one copies a range of expected with trivially copyable
+// alternatives; the script disassembles them and checks that the copy is a call to memmove, not a loop.
+
+#include <algorithm>
+#include <cstddef>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+
+struct Point {
+    int x;
+    int y;
+};
+
+extern "C" {
+
+void probe_copy_int(const expected<int, int>* first, std::size_t count, expected<int, int>* out) {
+    std::copy(first, first + count, out);
+}
+
+void probe_copy_void(const expected<void, int>* first, std::size_t count, expected<void, int>* out) {
+    std::copy(first, first + count, out);
+}
+
+void probe_copy_struct(const expected<Point, long>* first, std::size_t count, expected<Point, long>* out) {
+    std::copy(first, first + count, out);
+}
+
+void probe_move_int(expected<int, int>* first, std::size_t count, expected<int, int>* out) {
+    std::move(first, first + count, out);
+}
+
+} // extern "C"
@@ -0,0 +1,129 @@
+// Formats the errors of failed requests into a log line, once with a hand-written switch streamed to an
+// ostringstream (as the demo's operator<< did) and once with error_enum_name() appended to a std::string, and
+// counts them by code, once in a switch over counters and once in error_enum_counters.
+
+#include <atomic>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/error_enum.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::error_enum_count;
+using std::experimental::error_enum_counters;
+using std::experimental::error_enum_name;
+using std::experimental::error_enum_values;
+
+enum class RequestError {
+    Timeout,
+    ConnectionRefused,
+    ConnectionReset,
+    HostUnreachable,
+    InvalidHeader,
+    PayloadTooLarge,
+    Unauthorized,
+    Forbidden,
+    NotFound,
+    RateLimited,
+    UpstreamFailure,
+    Cancelled,
+};
+
+[[gnu::noinline]] std::ostream& write_switch(std::ostream& os, RequestError error) {
+    switch (error) {
+    case RequestError::Timeout: return os << "Timeout";
+    case RequestError::ConnectionRefused: return os << "ConnectionRefused";
+    case RequestError::ConnectionReset: return os << "ConnectionReset";
+    case RequestError::HostUnreachable: return os << "HostUnreachable";
+    case RequestError::InvalidHeader: return os << "InvalidHeader";
+    case RequestError::PayloadTooLarge: return os << "PayloadTooLarge";
+    case RequestError::Unauthorized: return os << "Unauthorized";
+    case RequestError::Forbidden: return os << "Forbidden";
+    case RequestError::NotFound: return os << "NotFound";
+    case RequestError::RateLimited: return os << "RateLimited";
+    case RequestError::UpstreamFailure: return os << "UpstreamFailure";
+    case RequestError::Cancelled: return os << "Cancelled";
+    }
+    return os << "Unknown";
+}
+
+[[gnu::noinline]] void count_switch(std::atomic<std::uint64_t>* counts, RequestError error) {
+    switch (error) {
+    case RequestError::Timeout: counts[0].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::ConnectionRefused: counts[1].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::ConnectionReset: counts[2].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::HostUnreachable: counts[3].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::InvalidHeader: counts[4].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::PayloadTooLarge: counts[5].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::Unauthorized: counts[6].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::Forbidden: counts[7].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::NotFound: counts[8].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::RateLimited: counts[9].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::UpstreamFailure: counts[10].fetch_add(1, std::memory_order_relaxed); break;
+    case RequestError::Cancelled: counts[11].fetch_add(1, std::memory_order_relaxed); break;
+    default: counts[12].fetch_add(1, std::memory_order_relaxed); break;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+
+    static_assert(error_enum_count<RequestError> == 12);
+
+    std::mt19937 rng(20);
+    std::vector<RequestError> errors(count);
+    for (RequestError& error : errors) {
+        error = error_enum_values<RequestError>[rng() % error_enum_count<RequestError>];
+    }
+
+    const double switch_ostream = bench::measure_ns(
+        [&] {
+            std::ostringstream line;
+            for (const RequestError error : errors) {
+                line.str({});
+                line << "request failed: ";
+                write_switch(line, error);
+                bench::do_not_optimize(line);
+            }
+        },
+        count);
+    const double table_string = bench::measure_ns(
+        [&] {
+            std::string line;
+            for (const RequestError error : errors) {
+                line.assign("request failed: ");
+                line += error_enum_name(error);
+                bench::do_not_optimize(line);
+            }
+        },
+        count);
+
+    std::atomic<std::uint64_t> switch_counts[error_enum_count<RequestError> + 1]{};
+    error_enum_counters<RequestError> counters;
+    const double switch_count = bench::measure_ns(
+        [&] {
+            for (const RequestError error : errors) {
+                count_switch(switch_counts, error);
+            }
+        },
+        count);
+    const double table_count = bench::measure_ns(
+        [&] {
+            for (const RequestError error : errors) {
+                counters.record(error);
+            }
+        },
+        count);
+
+    std::printf("%zu errors per run, ns per error\n\n", count);
+    bench::print_header("operation", "switch", "error_enum");
+    bench::print_row("format a log line", switch_ostream, table_string);
+    bench::print_row("count by code", switch_count, table_count);
+}
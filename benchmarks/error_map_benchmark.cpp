@@ -0,0 +1,215 @@
+// Carries failed storage reads up through four layer boundaries, each translating the error into the next
+// layer's domain with transform_error: once with a switch in a lambda at every boundary, once with an error_map.
+// Each boundary is a separate non-inlined function, as it would be between modules.
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../cpp20_expected/error_map.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::error_enum_count;
+using std::experimental::error_enum_values;
+using std::experimental::error_map;
+using std::experimental::expected;
+using std::experimental::unexpect;
+
+enum class StorageError {
+    NotFound,
+    PermissionDenied,
+    Corrupted,
+    ChecksumMismatch,
+    DiskFull,
+    QuotaExceeded,
+    ReadOnly,
+    Locked,
+    Timeout,
+    Busy,
+    Unavailable,
+    Cancelled,
+};
+
+enum class ServiceError { Missing, Denied, Invalid, Exhausted, Conflict, Transient, Aborted };
+
+enum class RpcStatus : unsigned char { NotFound, PermissionDenied, DataLoss, ResourceExhausted, Aborted, Unavailable };
+
+enum class HttpStatus : unsigned short {
+    Forbidden = 403,
+    NotFound = 404,
+    Conflict = 409,
+    TooMany = 429,
+    Internal = 500,
+    Unavailable = 503,
+};
+
+using Read = expected<int, StorageError>;
+
+[[gnu::noinline]] expected<int, ServiceError> service_switch(const Read& read) {
+    return read.transform_error([](StorageError error) {
+        switch (error) {
+        case StorageError::NotFound: return ServiceError::Missing;
+        case StorageError::PermissionDenied: return ServiceError::Denied;
+        case StorageError::Corrupted: return ServiceError::Invalid;
+        case StorageError::ChecksumMismatch: return ServiceError::Invalid;
+        case StorageError::DiskFull: return ServiceError::Exhausted;
+        case StorageError::QuotaExceeded: return ServiceError::Exhausted;
+        case StorageError::ReadOnly: return ServiceError::Denied;
+        case StorageError::Locked: return ServiceError::Conflict;
+        case StorageError::Timeout: return ServiceError::Transient;
+        case StorageError::Busy: return ServiceError::Transient;
+        case StorageError::Unavailable: return ServiceError::Transient;
+        case StorageError::Cancelled: return ServiceError::Aborted;
+        }
+        return ServiceError::Invalid;
+    });
+}
+
+[[gnu::noinline]] expected<int, RpcStatus> rpc_switch(const expected<int, ServiceError>& result) {
+    return result.transform_error([](ServiceError error) {
+        switch (error) {
+        case ServiceError::Missing: return RpcStatus::NotFound;
+        case ServiceError::Denied: return RpcStatus::PermissionDenied;
+        case ServiceError::Invalid: return RpcStatus::DataLoss;
+        case ServiceError::Exhausted: return RpcStatus::ResourceExhausted;
+        case ServiceError::Conflict: return RpcStatus::Aborted;
+        case ServiceError::Transient: return RpcStatus::Unavailable;
+        case ServiceError::Aborted: return RpcStatus::Aborted;
+        }
+        return RpcStatus::DataLoss;
+    });
+}
+
+[[gnu::noinline]] expected<int, HttpStatus> http_switch(const expected<int, RpcStatus>& result) {
+    return result.transform_error([](RpcStatus status) {
+        switch (status) {
+        case RpcStatus::NotFound: return HttpStatus::NotFound;
+        case RpcStatus::PermissionDenied: return HttpStatus::Forbidden;
+        case RpcStatus::DataLoss: return HttpStatus::Internal;
+        case RpcStatus::ResourceExhausted: return HttpStatus::TooMany;
+        case RpcStatus::Aborted: return HttpStatus::Conflict;
+        case RpcStatus::Unavailable: return HttpStatus::Unavailable;
+        }
+        return HttpStatus::Internal;
+    });
+}
+
+[[gnu::noinline]] expected<int, int> response_switch(const expected<int, HttpStatus>& result) {
+    return result.transform_error([](HttpStatus status) {
+        switch (status) {
+        case HttpStatus::NotFound: return 1;
+        case HttpStatus::Forbidden: return 1;
+        case HttpStatus::Conflict: return 2;
+        case HttpStatus::TooMany: return 3;
+        case HttpStatus::Internal: return 4;
+        case HttpStatus::Unavailable: return 3;
+        }
+        return 4;
+    });
+}
+
+constexpr error_map<StorageError, ServiceError> to_service{{
+    {StorageError::NotFound, ServiceError::Missing},
+    {StorageError::PermissionDenied, ServiceError::Denied},
+    {StorageError::Corrupted, ServiceError::Invalid},
+    {StorageError::ChecksumMismatch, ServiceError::Invalid},
+    {StorageError::DiskFull, ServiceError::Exhausted},
+    {StorageError::QuotaExceeded, ServiceError::Exhausted},
+    {StorageError::ReadOnly, ServiceError::Denied},
+    {StorageError::Locked, ServiceError::Conflict},
+    {StorageError::Timeout, ServiceError::Transient},
+    {StorageError::Busy, ServiceError::Transient},
+    {StorageError::Unavailable, ServiceError::Transient},
+    {StorageError::Cancelled, ServiceError::Aborted},
+}, ServiceError::Invalid};
+
+constexpr error_map<ServiceError, RpcStatus> to_rpc{{
+    {ServiceError::Missing, RpcStatus::NotFound},
+    {ServiceError::Denied, RpcStatus::PermissionDenied},
+    {ServiceError::Invalid, RpcStatus::DataLoss},
+    {ServiceError::Exhausted, RpcStatus::ResourceExhausted},
+    {ServiceError::Conflict, RpcStatus::Aborted},
+    {ServiceError::Transient, RpcStatus::Unavailable},
+    {ServiceError::Aborted, RpcStatus::Aborted},
+}, RpcStatus::DataLoss};
+
+constexpr error_map<RpcStatus, HttpStatus> to_http{{
+    {RpcStatus::NotFound, HttpStatus::NotFound},
+    {RpcStatus::PermissionDenied, HttpStatus::Forbidden},
+    {RpcStatus::DataLoss, HttpStatus::Internal},
+    {RpcStatus::ResourceExhausted, HttpStatus::TooMany},
+    {RpcStatus::Aborted, HttpStatus::Conflict},
+    {RpcStatus::Unavailable, HttpStatus::Unavailable},
+}, HttpStatus::Internal};
+
+} // namespace
+
+// HttpStatus spans 403..503: widen the range that error_enum.h scans
+template <>
+struct std::experimental::error_enum_range<HttpStatus> {
+    static constexpr long long min = 400;
+    static constexpr long long max = 511;
+};
+
+namespace {
+
+constexpr error_map<HttpStatus, int> to_response{{
+    {HttpStatus::NotFound, 1},
+    {HttpStatus::Forbidden, 1},
+    {HttpStatus::Conflict, 2},
+    {HttpStatus::TooMany, 3},
+    {HttpStatus::Internal, 4},
+    {HttpStatus::Unavailable, 3},
+}, 4};
+
+[[gnu::noinline]] expected<int, ServiceError> service_map(const Read& read) {
+    return read.transform_error(to_service);
+}
+
+[[gnu::noinline]] expected<int, RpcStatus> rpc_map(const expected<int, ServiceError>& result) {
+    return result.transform_error(to_rpc);
+}
+
+[[gnu::noinline]] expected<int, HttpStatus> http_map(const expected<int, RpcStatus>& result) {
+    return result.transform_error(to_http);
+}
+
+[[gnu::noinline]] expected<int, int> response_map(const expected<int, HttpStatus>& result) {
+    return result.transform_error(to_response);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+
+    static_assert(error_enum_count<HttpStatus> == 6);
+
+    std::mt19937 rng(21);
+    std::vector<Read> reads;
+    reads.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        reads.emplace_back(unexpect, error_enum_values<StorageError>[rng() % error_enum_count<StorageError>]);
+    }
+
+    const double switches = bench::measure_ns(
+        [&] {
+            for (const Read& read : reads) {
+                bench::do_not_optimize(response_switch(http_switch(rpc_switch(service_switch(read)))));
+            }
+        },
+        count);
+    const double maps = bench::measure_ns(
+        [&] {
+            for (const Read& read : reads) {
+                bench::do_not_optimize(response_map(http_map(rpc_map(service_map(read)))));
+            }
+        },
+        count);
+
+    std::printf("%zu failed reads per run, random codes, ns per read\n\n", count);
+    bench::print_header("operation", "switch", "error_map");
+    bench::print_row("translate across 4 boundaries", switches, maps);
+}
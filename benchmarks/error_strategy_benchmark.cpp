@@ -0,0 +1,295 @@
+// Implements the shapes of the demo (fun() returning a string, testVoid() returning nothing, testPair() returning
+// a pair) plus a large trivially copyable payload four ways, and propagates their failures through 1 to 32 frames:
+//   expected        expected<T, error_code>, checked and forwarded by every frame
+//   exceptions      thrown at the leaf, caught at the top
+//   error_code&     an out-parameter, checked by every frame
+//   optional+errno  optional<T>, with the error code in a thread_local side channel
+// Reports ns per call and, where perf_event_open is available, instructions per call.
+
+#include <cerrno>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+struct Blob {
+    unsigned char bytes[256];
+};
+
+template <class T>
+T make_payload(std::size_t i) {
+    if constexpr (std::is_same_v<T, std::pair<int, char>>) {
+        return {static_cast<int>(i), 'c'};
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return std::string(32, static_cast<char>('a' + i % 26)); // beyond the small string buffer
+    } else {
+        Blob blob{};
+        blob.bytes[i % sizeof(blob.bytes)] = static_cast<unsigned char>(i);
+        return blob;
+    }
+}
+
+template <class T>
+std::uint64_t digest(const T& payload) {
+    if constexpr (std::is_same_v<T, std::pair<int, char>>) {
+        return static_cast<std::uint64_t>(payload.first) + static_cast<std::uint64_t>(payload.second);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return payload.size() + static_cast<unsigned char>(payload[0]);
+    } else {
+        return payload.bytes[0] + payload.bytes[sizeof(payload.bytes) - 1];
+    }
+}
+
+std::error_code failure() {
+    return std::make_error_code(std::errc::invalid_argument);
+}
+
+// Each frame keeps depth alive across the nested call, so that every level is a real frame and no strategy
+// collapses into a loop or a tail call.
+struct ExpectedStrategy {
+    template <class T>
+    [[gnu::noinline]] static expected<T, std::error_code> call(int depth, bool fail, std::size_t i) {
+        if (depth == 1) {
+            if (fail) {
+                return unexpected{failure()};
+            }
+            if constexpr (std::is_void_v<T>) {
+                return {};
+            } else {
+                return make_payload<T>(i);
+            }
+        }
+
+        expected<T, std::error_code> result = call<T>(depth - 1, fail, i);
+        bench::do_not_optimize(depth);
+        if (!result) {
+            return unexpected{result.error()};
+        }
+        return result;
+    }
+
+    template <class T>
+    static std::uint64_t top(int depth, bool fail, std::size_t i) {
+        const expected<T, std::error_code> result = call<T>(depth, fail, i);
+        if (!result) {
+            return static_cast<std::uint64_t>(result.error().value());
+        }
+        if constexpr (std::is_void_v<T>) {
+            return 1;
+        } else {
+            return digest(*result);
+        }
+    }
+};
+
+// Carries only the error_code, so that the comparison measures unwinding rather than message formatting.
+struct Failure : std::exception {
+    explicit Failure(std::error_code code) noexcept : code(code) {}
+    const char* what() const noexcept override {
+        return "failure";
+    }
+    std::error_code code;
+};
+
+struct ExceptionStrategy {
+    template <class T>
+    [[gnu::noinline]] static T call(int depth, bool fail, std::size_t i) {
+        if (depth == 1) {
+            if (fail) {
+                throw Failure{failure()};
+            }
+            if constexpr (std::is_void_v<T>) {
+                return;
+            } else {
+                return make_payload<T>(i);
+            }
+        }
+
+        if constexpr (std::is_void_v<T>) {
+            call<T>(depth - 1, fail, i);
+            bench::do_not_optimize(depth);
+        } else {
+            T result = call<T>(depth - 1, fail, i);
+            bench::do_not_optimize(depth);
+            return result;
+        }
+    }
+
+    template <class T>
+    static std::uint64_t top(int depth, bool fail, std::size_t i) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                call<T>(depth, fail, i);
+                return 1;
+            } else {
+                return digest(call<T>(depth, fail, i));
+            }
+        } catch (const Failure& failure) {
+            return static_cast<std::uint64_t>(failure.code.value());
+        }
+    }
+};
+
+struct ErrorCodeStrategy {
+    template <class T>
+    [[gnu::noinline]] static T call(int depth, bool fail, std::size_t i, std::error_code& ec) {
+        if (depth == 1) {
+            if (fail) {
+                ec = failure();
+                return T();
+            }
+            if constexpr (std::is_void_v<T>) {
+                return;
+            } else {
+                return make_payload<T>(i);
+            }
+        }
+
+        if constexpr (std::is_void_v<T>) {
+            call<T>(depth - 1, fail, i, ec);
+            bench::do_not_optimize(depth);
+        } else {
+            T result = call<T>(depth - 1, fail, i, ec);
+            bench::do_not_optimize(depth);
+            if (ec) {
+                return T();
+            }
+            return result;
+        }
+    }
+
+    template <class T>
+    static std::uint64_t top(int depth, bool fail, std::size_t i) {
+        std::error_code ec;
+        if constexpr (std::is_void_v<T>) {
+            call<T>(depth, fail, i, ec);
+            return ec ? static_cast<std::uint64_t>(ec.value()) : 1;
+        } else {
+            const T result = call<T>(depth, fail, i, ec);
+            return ec ? static_cast<std::uint64_t>(ec.value()) : digest(result);
+        }
+    }
+};
+
+thread_local int last_error = 0;
+
+struct OptionalErrnoStrategy {
+    template <class T>
+    using Result = std::optional<std::conditional_t<std::is_void_v<T>, std::monostate, T>>;
+
+    template <class T>
+    [[gnu::noinline]] static Result<T> call(int depth, bool fail, std::size_t i) {
+        if (depth == 1) {
+            if (fail) {
+                last_error = EINVAL;
+                return std::nullopt;
+            }
+            if constexpr (std::is_void_v<T>) {
+                return std::monostate{};
+            } else {
+                return make_payload<T>(i);
+            }
+        }
+
+        Result<T> result = call<T>(depth - 1, fail, i);
+        bench::do_not_optimize(depth);
+        if (!result) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    template <class T>
+    static std::uint64_t top(int depth, bool fail, std::size_t i) {
+        const Result<T> result = call<T>(depth, fail, i);
+        if (!result) {
+            return static_cast<std::uint64_t>(last_error);
+        }
+        if constexpr (std::is_void_v<T>) {
+            return 1;
+        } else {
+            return digest(*result);
+        }
+    }
+};
+
+struct Sweep {
+    std::size_t calls;
+    std::vector<unsigned char> fails;
+    bench::event_counter instructions{bench::hardware_event::instructions};
+};
+
+template <class Strategy, class T>
+void measure(Sweep& sweep, int depth, char (&cell)[64]) {
+    const auto body = [&] {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < sweep.calls; ++i) {
+            sum += Strategy::template top<T>(depth, sweep.fails[i] != 0, i);
+        }
+        bench::do_not_optimize(sum);
+    };
+    const double ns = bench::measure_ns(body, sweep.calls);
+    char instructions[32];
+    bench::format_events(instructions, bench::measure_events(sweep.instructions, body, sweep.calls));
+    std::snprintf(cell, sizeof(cell), "%9.2f / %-7s", ns, instructions);
+}
+
+template <class T>
+void run(Sweep& sweep, const char* payload, int depth, double failure_rate) {
+    std::mt19937 rng(3);
+    std::bernoulli_distribution fails(failure_rate);
+    for (unsigned char& fail : sweep.fails) {
+        fail = fails(rng);
+    }
+
+    char cells[4][64];
+    measure<ExpectedStrategy, T>(sweep, depth, cells[0]);
+    measure<ExceptionStrategy, T>(sweep, depth, cells[1]);
+    measure<ErrorCodeStrategy, T>(sweep, depth, cells[2]);
+    measure<OptionalErrnoStrategy, T>(sweep, depth, cells[3]);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s/depth %d/%g%%", payload, depth, failure_rate * 100);
+    std::printf("%-32s %s %s %s %s\n", name, cells[0], cells[1], cells[2], cells[3]);
+}
+
+template <class T>
+void run_payload(Sweep& sweep, const char* payload) {
+    for (const int depth : {1, 4, 16, 32}) {
+        for (const double failure_rate : {0.0, 0.001, 0.01, 0.1, 0.5}) {
+            run<T>(sweep, payload, depth, failure_rate);
+        }
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Sweep sweep;
+    sweep.calls = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+    sweep.fails.resize(sweep.calls);
+
+    std::printf("%zu calls per run; each cell is ns per call / instructions per call\n", sweep.calls);
+    if (!sweep.instructions.available()) {
+        std::printf("perf_event_open is not available here; instructions are not reported\n");
+    }
+    std::printf("\n%-32s %19s %19s %19s %19s\n", "payload/depth/failure rate", "expected", "exceptions",
+        "error_code&", "optional+errno");
+    run_payload<void>(sweep, "void");
+    run_payload<std::pair<int, char>>(sweep, "pair<int, char>");
+    run_payload<std::string>(sweep, "string(32)");
+    run_payload<Blob>(sweep, "blob<256>");
+}
@@ -0,0 +1,112 @@
+// The cost of sampled error traces, see [expected.traces] in expected_error_traces.h. Built with
+// _EXPECTED_ERROR_TRACES=1 and frame pointers; every call fails eight frames deep, so each operation creates one
+// error. Prints ns per error with one error in 100 and every error captured, against the same code with sampling
+// set to 0, with one thread and with several. The threads take the traces out of the ring themselves every 128
+// errors, so that the ring does not fill up and the time includes capturing and copying out every sampled trace.
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+enum class lookup_error { not_found = 1, timed_out };
+
+[[gnu::noinline]] expected<int, lookup_error> fetch(int key) {
+    if (key >= 0) {
+        return unexpected(key % 2 == 0 ? lookup_error::not_found : lookup_error::timed_out);
+    }
+    return key;
+}
+
+// Seven more frames between the caller and the error, each passing it up
+template <int Depth>
+[[gnu::noinline]] expected<int, lookup_error> resolve(int key) {
+    if constexpr (Depth == 0) {
+        return fetch(key);
+    } else {
+        return resolve<Depth - 1>(key).transform([](int value) { return value + Depth; });
+    }
+}
+
+constexpr int errors_per_thread = 1 << 20;
+constexpr int errors_per_take   = 128;
+
+struct trace_totals {
+    std::uint64_t captured = 0;
+    std::uint64_t dropped  = 0;
+};
+
+std::mutex totals_mtx;
+
+void take_traces(trace_totals& totals) {
+    const auto snapshot = std::experimental::take_error_traces();
+    std::lock_guard lock{totals_mtx};
+    totals.captured += snapshot.traces.size();
+    totals.dropped += snapshot.dropped;
+}
+
+double measure(std::uint_least32_t sampling, unsigned threads, trace_totals& totals) {
+    std::experimental::set_error_trace_sampling(sampling);
+    (void) std::experimental::take_error_traces();
+
+    return bench::measure_ns(
+        [&] {
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&] {
+                    int failures = 0;
+                    for (int key = 0; key < errors_per_thread; ++key) {
+                        failures += !resolve<7>(key).has_value();
+                        if (key % errors_per_take == errors_per_take - 1) {
+                            take_traces(totals);
+                        }
+                    }
+                    bench::do_not_optimize(failures);
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        },
+        static_cast<std::size_t>(errors_per_thread) * threads, 3);
+}
+
+void run(unsigned threads) {
+    char title[64];
+    std::snprintf(title, sizeof(title), "%u thread%s, ns per error", threads, threads == 1 ? "" : "s");
+    bench::print_header(title, "0% sampled", "sampled");
+
+    trace_totals unsampled;
+    const double baseline = measure(0, threads, unsampled);
+    bench::print_row("0% (never captured)", baseline, baseline);
+
+    trace_totals totals[2];
+    const std::uint_least32_t samplings[] = {100, 1};
+    const char* const names[]             = {"1% (one error in 100)", "100% (every error)"};
+    for (int i = 0; i < 2; ++i) {
+        bench::print_row(names[i], baseline, measure(samplings[i], threads, totals[i]));
+    }
+    for (int i = 0; i < 2; ++i) {
+        std::printf("  %-50s %llu traces captured, %llu dropped with the ring full\n", names[i],
+            static_cast<unsigned long long>(totals[i].captured), static_cast<unsigned long long>(totals[i].dropped));
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("sampled error traces: %d errors per thread and run, %zu frames at most, ring of %zu traces\n\n",
+        errors_per_thread, std::experimental::error_trace_depth, std::experimental::error_trace_capacity);
+    run(1);
+    std::printf("\n");
+    run(std::thread::hardware_concurrency() > 4 ? 4 : 2);
+}
@@ -0,0 +1,86 @@
+// Compares scanning std::vector<expected<T, E>> for errors with the bitmap kernels of expected_vector.
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/expected_vector.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::expected_vector;
+using std::experimental::unexpect;
+
+using Result = expected<double, std::error_code>;
+
+struct Batch {
+    std::vector<Result> aos;
+    expected_vector<double, std::error_code> soa;
+};
+
+// Errors appear with probability error_rate; a nonzero last_error forces the final element to be an error,
+// which makes find_first_error() scan the whole batch.
+Batch make_batch(std::size_t count, double error_rate, bool last_error) {
+    std::mt19937_64 rng(42);
+    std::bernoulli_distribution fails(error_rate);
+    Batch batch;
+    batch.aos.reserve(count);
+    batch.soa.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool error = fails(rng) || (last_error && i + 1 == count);
+        const Result result =
+            error ? Result{unexpect, std::make_error_code(std::errc::result_out_of_range)} : Result{i * 0.5};
+        batch.aos.push_back(result);
+        batch.soa.push_back(result);
+    }
+    return batch;
+}
+
+void run(const char* scenario, std::size_t count, double error_rate, bool last_error) {
+    const Batch batch = make_batch(count, error_rate, last_error);
+    const auto is_error = [](const Result& result) { return !result.has_value(); };
+
+    if (static_cast<std::size_t>(std::count_if(batch.aos.begin(), batch.aos.end(), is_error))
+            != batch.soa.count_errors()
+        || static_cast<std::size_t>(std::find_if(batch.aos.begin(), batch.aos.end(), is_error) - batch.aos.begin())
+               != batch.soa.find_first_error()) {
+        std::printf("mismatch in %s\n", scenario);
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::string name;
+    name = std::string("count_errors/") + scenario;
+    bench::print_row(name.c_str(), bench::measure_ns([&] {
+        bench::do_not_optimize(std::count_if(batch.aos.begin(), batch.aos.end(), is_error));
+    }, 1),
+        bench::measure_ns([&] { bench::do_not_optimize(batch.soa.count_errors()); }, 1));
+
+    name = std::string("find_first_error/") + scenario;
+    bench::print_row(name.c_str(), bench::measure_ns([&] {
+        bench::do_not_optimize(std::find_if(batch.aos.begin(), batch.aos.end(), is_error));
+    }, 1),
+        bench::measure_ns([&] { bench::do_not_optimize(batch.soa.find_first_error()); }, 1));
+
+    name = std::string("all_ok/") + scenario;
+    bench::print_row(name.c_str(), bench::measure_ns([&] {
+        bench::do_not_optimize(std::none_of(batch.aos.begin(), batch.aos.end(), is_error));
+    }, 1),
+        bench::measure_ns([&] { bench::do_not_optimize(batch.soa.all_ok()); }, 1));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+    std::printf("%zu elements of expected<double, error_code> (ns per call)\n\n", count);
+    bench::print_header("kernel/scenario", "vector<expected>", "expected_vector");
+    run("no errors", count, 0.0, false);
+    run("last element fails", count, 0.0, true);
+    run("1% errors", count, 0.01, false);
+}
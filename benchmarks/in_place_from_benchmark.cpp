@@ -0,0 +1,84 @@
+// Builds multi-kilobyte values inside expected from a factory function, once through the value constructor and
+// emplace(), which move the factory's result into place, and once through in_place_from and emplace_from(),
+// which let the factory construct the contained value directly.
+
+#include <cstdlib>
+#include <system_error>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::in_place_from;
+
+template <std::size_t Size>
+struct Report {
+    unsigned char bytes[Size];
+};
+
+template <std::size_t Size>
+[[gnu::noinline]] Report<Size> make_report(std::size_t seed) noexcept {
+    Report<Size> report;
+    for (std::size_t i = 0; i < Size; i += 64) {
+        report.bytes[i] = static_cast<unsigned char>(seed + i);
+    }
+    return report;
+}
+
+template <std::size_t Size>
+void run(const char* name, std::size_t count) {
+    using Result = expected<Report<Size>, std::error_code>;
+    char row[64];
+
+    const double construct = bench::measure_ns(
+        [&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                Result result{make_report<Size>(i)};
+                bench::do_not_optimize(result);
+            }
+        },
+        count);
+    const double construct_from = bench::measure_ns(
+        [&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                Result result{in_place_from, make_report<Size>, i};
+                bench::do_not_optimize(result);
+            }
+        },
+        count);
+    std::snprintf(row, sizeof(row), "%s/construct", name);
+    bench::print_row(row, construct, construct_from);
+
+    Result result{in_place_from, make_report<Size>, 0};
+    const double emplace = bench::measure_ns(
+        [&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                result.emplace(make_report<Size>(i));
+                bench::do_not_optimize(result);
+            }
+        },
+        count);
+    const double emplace_from = bench::measure_ns(
+        [&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                result.emplace_from(make_report<Size>, i);
+                bench::do_not_optimize(result);
+            }
+        },
+        count);
+    std::snprintf(row, sizeof(row), "%s/emplace", name);
+    bench::print_row(row, emplace, emplace_from);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+
+    bench::print_header("value size/operation", "moved in", "from result");
+    run<512>("512 bytes", count);
+    run<4096>("4 KiB", count);
+    run<16384>("16 KiB", count);
+}
@@ -0,0 +1,129 @@
+// Dispatches protocol responses, half of them values and half random error codes, to a handler per outcome:
+// once with `if (!r)` followed by a switch on r.error(), once with match(), which folds both into one switch.
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../cpp20_expected/expected_match.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::error_enum_count;
+using std::experimental::error_enum_values;
+using std::experimental::expected;
+using std::experimental::match;
+using std::experimental::on_error;
+using std::experimental::unexpect;
+
+enum class ResponseError {
+    Timeout,
+    ConnectionRefused,
+    ConnectionReset,
+    HostUnreachable,
+    InvalidHeader,
+    PayloadTooLarge,
+    Unauthorized,
+    Forbidden,
+    NotFound,
+    RateLimited,
+    UpstreamFailure,
+    Cancelled,
+};
+
+using Response = expected<std::uint32_t, ResponseError>;
+
+// What a handler does with each outcome: enough distinct work per case that the switch stays a jump table
+struct Session {
+    std::uint64_t bytes   = 0;
+    std::uint32_t retries = 0;
+    std::uint32_t resets  = 0;
+    std::uint32_t denied  = 0;
+    std::uint32_t missing = 0;
+    std::uint32_t backoff = 1;
+    std::uint32_t aborted = 0;
+    std::uint32_t invalid = 0;
+};
+
+[[gnu::noinline]] void handle_switch(Session& s, const Response& r) {
+    if (r) {
+        s.bytes += *r;
+        return;
+    }
+
+    switch (r.error()) {
+    case ResponseError::Timeout: s.retries += 1; break;
+    case ResponseError::ConnectionRefused: s.backoff = s.backoff * 2 + 1; break;
+    case ResponseError::ConnectionReset: s.resets += 1; s.retries += 1; break;
+    case ResponseError::HostUnreachable: s.backoff += 7; break;
+    case ResponseError::InvalidHeader: s.invalid += 1; break;
+    case ResponseError::PayloadTooLarge: s.bytes -= 1; s.invalid += 2; break;
+    case ResponseError::Unauthorized: s.denied += 1; s.backoff = 1; break;
+    case ResponseError::Forbidden: s.denied += 2; break;
+    case ResponseError::NotFound: s.missing += 1; break;
+    case ResponseError::RateLimited: s.backoff <<= 1; break;
+    case ResponseError::UpstreamFailure: s.retries += 2; s.backoff += 1; break;
+    case ResponseError::Cancelled: s.aborted += 1; break;
+    default: s.invalid += 3; break;
+    }
+}
+
+[[gnu::noinline]] void handle_match(Session& s, const Response& r) {
+    match(r,
+        [&](std::uint32_t size) { s.bytes += size; },
+        on_error<ResponseError::Timeout>([&] { s.retries += 1; }),
+        on_error<ResponseError::ConnectionRefused>([&] { s.backoff = s.backoff * 2 + 1; }),
+        on_error<ResponseError::ConnectionReset>([&] { s.resets += 1; s.retries += 1; }),
+        on_error<ResponseError::HostUnreachable>([&] { s.backoff += 7; }),
+        on_error<ResponseError::InvalidHeader>([&] { s.invalid += 1; }),
+        on_error<ResponseError::PayloadTooLarge>([&] { s.bytes -= 1; s.invalid += 2; }),
+        on_error<ResponseError::Unauthorized>([&] { s.denied += 1; s.backoff = 1; }),
+        on_error<ResponseError::Forbidden>([&] { s.denied += 2; }),
+        on_error<ResponseError::NotFound>([&] { s.missing += 1; }),
+        on_error<ResponseError::RateLimited>([&] { s.backoff <<= 1; }),
+        on_error<ResponseError::UpstreamFailure>([&] { s.retries += 2; s.backoff += 1; }),
+        on_error<ResponseError::Cancelled>([&] { s.aborted += 1; }),
+        on_error([&] { s.invalid += 3; }));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+
+    std::mt19937 rng(22);
+    std::vector<Response> responses;
+    responses.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (rng() % 2 == 0) {
+            responses.emplace_back(rng() % 4096);
+        } else {
+            responses.emplace_back(unexpect, error_enum_values<ResponseError>[rng() % error_enum_count<ResponseError>]);
+        }
+    }
+
+    Session by_switch;
+    Session by_match;
+    const double switches = bench::measure_ns(
+        [&] {
+            for (const Response& r : responses) {
+                handle_switch(by_switch, r);
+            }
+            bench::do_not_optimize(by_switch);
+        },
+        count);
+    const double matches = bench::measure_ns(
+        [&] {
+            for (const Response& r : responses) {
+                handle_match(by_match, r);
+            }
+            bench::do_not_optimize(by_match);
+        },
+        count);
+
+    std::printf("%zu responses per run, half errors with random codes, ns per response\n\n", count);
+    bench::print_header("operation", "if + switch", "match");
+    bench::print_row("dispatch a response", switches, matches);
+}
@@ -0,0 +1,356 @@
+// Differential test and benchmark of std::experimental::expected against the native std::expected of the standard
+// library (C++23). The scenarios are those of cpp20_expected.cpp. For each one it compares
+//   - sizeof and the triviality traits of the types involved,
+//   - the observable results,
+//   - the size of the generated code (ELF only: every kernel is flattened into a section of its own),
+//   - the runtime,
+// and exits with 1 when the copy regresses: a larger type, a lost trivial or nothrow trait, a different result,
+// or code size / runtime above native times the given threshold. --no-timing skips the runtime, which is too noisy
+// on shared machines to gate a test on, and keeps the exact checks.
+//
+// usage: parity_benchmark [--no-timing] [--runtime-threshold=1.25] [--size-threshold=1.10] [elements]
+
+#include <expected>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "../cpp20_expected/expected_compat.h"
+#include "benchmark.h"
+
+#ifndef __cpp_lib_expected
+#error parity_benchmark needs a standard library with std::expected (C++23)
+#endif
+
+static_assert(std::experimental::compat::is_native);
+static_assert(std::is_same_v<std::experimental::compat::expected<int, int>, std::expected<int, int>>);
+
+// The niche the demo declares for ErrorCode. The demo no longer declares one for error_code, so the two match.
+enum class ErrorCode { Success, InvalidArgument, OtherError };
+
+template <>
+struct std::experimental::niche_traits<ErrorCode>
+    : std::experimental::value_niche_traits<ErrorCode, static_cast<ErrorCode>(-1)> {};
+
+namespace {
+
+struct NoDefault {
+    NoDefault(int value) : value(value) {}
+    operator int() const {
+        return value;
+    }
+    int value;
+};
+
+struct Native {
+    template <class T, class E>
+    using expected = std::expected<T, E>;
+    template <class E>
+    using unexpected = std::unexpected<E>;
+};
+
+struct Experimental {
+    template <class T, class E>
+    using expected = std::experimental::expected<T, E>;
+    template <class E>
+    using unexpected = std::experimental::unexpected<E>;
+};
+
+bool failed = false;
+
+void report_failure(const char* what, const char* scenario) {
+    std::printf("REGRESSION %s: %s\n", scenario, what);
+    failed = true;
+}
+
+// [layout and traits]
+
+template <class T, class E>
+void compare_traits(const char* scenario) {
+    using N = std::expected<T, E>;
+    using X = std::experimental::expected<T, E>;
+
+    std::printf("%-40s %7zu %7zu\n", scenario, sizeof(N), sizeof(X));
+    if (sizeof(X) > sizeof(N)) {
+        report_failure("sizeof is larger than native", scenario);
+    }
+
+    const auto check = [&](bool native, bool experimental, const char* trait) {
+        if (native && !experimental) {
+            report_failure(trait, scenario);
+        }
+    };
+    check(std::is_trivially_copy_constructible_v<N>, std::is_trivially_copy_constructible_v<X>,
+        "lost is_trivially_copy_constructible");
+    check(std::is_trivially_move_constructible_v<N>, std::is_trivially_move_constructible_v<X>,
+        "lost is_trivially_move_constructible");
+    check(std::is_trivially_copy_assignable_v<N>, std::is_trivially_copy_assignable_v<X>,
+        "lost is_trivially_copy_assignable");
+    check(std::is_trivially_move_assignable_v<N>, std::is_trivially_move_assignable_v<X>,
+        "lost is_trivially_move_assignable");
+    check(std::is_trivially_destructible_v<N>, std::is_trivially_destructible_v<X>,
+        "lost is_trivially_destructible");
+    check(std::is_trivially_copyable_v<N>, std::is_trivially_copyable_v<X>, "lost is_trivially_copyable");
+    check(std::is_nothrow_move_constructible_v<N>, std::is_nothrow_move_constructible_v<X>,
+        "lost is_nothrow_move_constructible");
+    check(std::is_nothrow_move_assignable_v<N>, std::is_nothrow_move_assignable_v<X>,
+        "lost is_nothrow_move_assignable");
+    check(std::is_nothrow_swappable_v<N>, std::is_nothrow_swappable_v<X>, "lost is_nothrow_swappable");
+}
+
+// [kernels]
+// Each kernel runs one scenario of the demo over a batch of inputs, of which about one in eight fails.
+
+using Inputs = std::vector<unsigned char>;
+
+template <class Impl>
+typename Impl::template expected<std::string, std::error_code> fun(bool ok) {
+    if (!ok) {
+        return typename Impl::template unexpected<std::error_code>(std::make_error_code(std::errc::invalid_argument));
+    }
+    return "Hello, expected World!";
+}
+
+template <class Impl>
+typename Impl::template expected<void, std::error_code> test_void(bool ok) {
+    if (!ok) {
+        return typename Impl::template unexpected<std::error_code>(std::make_error_code(std::errc::invalid_argument));
+    }
+    return {};
+}
+
+template <class Impl>
+typename Impl::template expected<std::pair<int, char>, std::error_code> test_pair(bool ok) {
+    if (!ok) {
+        return typename Impl::template unexpected<std::error_code>(std::make_error_code(std::errc::invalid_argument));
+    }
+    return std::make_pair(2, 'c');
+}
+
+template <class Impl>
+typename Impl::template expected<int, ErrorCode> test_error_code(bool ok, int value) {
+    if (!ok) {
+        return typename Impl::template unexpected<ErrorCode>(ErrorCode::OtherError);
+    }
+    return value;
+}
+
+template <class Impl>
+std::uint64_t string_kernel(const Inputs& inputs) {
+    std::uint64_t sum = 0;
+    for (const unsigned char ok : inputs) {
+        sum += fun<Impl>(ok != 0).value_or("not OK").size();
+    }
+    return sum;
+}
+
+template <class Impl>
+std::uint64_t void_kernel(const Inputs& inputs) {
+    std::uint64_t sum = 0;
+    for (const unsigned char ok : inputs) {
+        const auto result = test_void<Impl>(ok != 0);
+        sum += result.has_value() ? 1 : static_cast<std::uint64_t>(result.error().value());
+    }
+    return sum;
+}
+
+template <class Impl>
+std::uint64_t pair_kernel(const Inputs& inputs) {
+    std::uint64_t sum = 0;
+    for (const unsigned char ok : inputs) {
+        const auto result = test_pair<Impl>(ok != 0);
+        if (result) {
+            const auto [i, c] = result.value();
+            sum += static_cast<std::uint64_t>(i + c);
+        }
+    }
+    return sum;
+}
+
+template <class Impl>
+std::uint64_t no_default_kernel(const Inputs& inputs) {
+    using Result = typename Impl::template expected<NoDefault, int>;
+    std::uint64_t sum = 0;
+    for (const unsigned char ok : inputs) {
+        const Result result = ok ? Result{20} : Result{typename Impl::template unexpected<int>(-1)};
+        sum += static_cast<std::uint64_t>(result.has_value() ? int(result.value()) : result.error());
+    }
+    return sum;
+}
+
+template <class Impl>
+std::uint64_t error_code_kernel(const Inputs& inputs) {
+    std::uint64_t sum = 0;
+    int value = 0;
+    for (const unsigned char ok : inputs) {
+        const auto result = test_error_code<Impl>(ok != 0, ++value);
+        sum += result ? static_cast<std::uint64_t>(*result) : static_cast<std::uint64_t>(result.error());
+    }
+    return sum;
+}
+
+// The monadic operations arrived in the native type later than the type itself (__cpp_lib_expected 202211)
+#if __cpp_lib_expected >= 202211L
+template <class Impl>
+std::uint64_t monadic_kernel(const Inputs& inputs) {
+    std::uint64_t sum = 0;
+    int value = 0;
+    for (const unsigned char ok : inputs) {
+        sum += static_cast<std::uint64_t>(test_error_code<Impl>(ok != 0, ++value)
+                                              .and_then([](int v) { return test_error_code<Impl>(v % 3 != 0, v); })
+                                              .transform([](int v) { return v * 2; })
+                                              .transform_error([](ErrorCode e) { return static_cast<int>(e); })
+                                              .value_or(-1));
+    }
+    return sum;
+}
+#endif // __cpp_lib_expected >= 202211L
+
+// Every kernel is instantiated once per implementation into a section of its own, whose bounds the linker
+// publishes as __start_<section> and __stop_<section>.
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+#define PARITY_HAS_CODE_SIZE 1
+#define PARITY_INSTANTIATE(kernel, impl)                                                        \
+    extern "C" const char __start_parity_##kernel##_##impl[];                                   \
+    extern "C" const char __stop_parity_##kernel##_##impl[];                                    \
+    __attribute__((section("parity_" #kernel "_" #impl), noinline, flatten)) std::uint64_t     \
+        kernel##_##impl(const Inputs& inputs) {                                                 \
+        return kernel<impl>(inputs);                                                            \
+    }                                                                                           \
+    std::size_t kernel##_##impl##_size() {                                                      \
+        return static_cast<std::size_t>(__stop_parity_##kernel##_##impl - __start_parity_##kernel##_##impl); \
+    }
+#else // ^^^ ELF / other vvv
+#define PARITY_HAS_CODE_SIZE 0
+#define PARITY_INSTANTIATE(kernel, impl)                 \
+    std::uint64_t kernel##_##impl(const Inputs& inputs) { \
+        return kernel<impl>(inputs);                      \
+    }                                                     \
+    std::size_t kernel##_##impl##_size() {                \
+        return 0;                                         \
+    }
+#endif // ^^^ other ^^^
+
+#define PARITY_KERNEL(kernel)               \
+    PARITY_INSTANTIATE(kernel, Native)       \
+    PARITY_INSTANTIATE(kernel, Experimental)
+
+PARITY_KERNEL(string_kernel)
+PARITY_KERNEL(void_kernel)
+PARITY_KERNEL(pair_kernel)
+PARITY_KERNEL(no_default_kernel)
+PARITY_KERNEL(error_code_kernel)
+#if __cpp_lib_expected >= 202211L
+PARITY_KERNEL(monadic_kernel)
+#endif // __cpp_lib_expected >= 202211L
+
+struct Kernel {
+    const char* name;
+    std::uint64_t (*native)(const Inputs&);
+    std::uint64_t (*experimental)(const Inputs&);
+    std::size_t (*native_size)();
+    std::size_t (*experimental_size)();
+};
+
+#define PARITY_ENTRY(kernel, scenario) \
+    Kernel{scenario, kernel##_Native, kernel##_Experimental, kernel##_Native_size, kernel##_Experimental_size}
+
+double parse_option(int argc, char** argv, const char* option, double fallback) {
+    const std::size_t length = std::strlen(option);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], option, length) == 0 && argv[i][length] == '=') {
+            return std::strtod(argv[i] + length + 1, nullptr);
+        }
+    }
+    return fallback;
+}
+
+bool has_flag(int argc, char** argv, const char* flag) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], flag) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double runtime_threshold = parse_option(argc, argv, "--runtime-threshold", 1.25);
+    const double size_threshold = parse_option(argc, argv, "--size-threshold", 1.10);
+    const bool timing = !has_flag(argc, argv, "--no-timing");
+    std::size_t count = 1 << 16;
+    if (argc > 1 && argv[argc - 1][0] != '-') {
+        count = std::strtoull(argv[argc - 1], nullptr, 10);
+    }
+
+    std::printf("%-40s %7s %7s\n", "sizeof", "std", "exp");
+    compare_traits<std::string, std::error_code>("expected<string, error_code> (fun)");
+    compare_traits<void, std::error_code>("expected<void, error_code> (testVoid)");
+    compare_traits<std::pair<int, char>, std::error_code>("expected<pair<int, char>, error_code>");
+    compare_traits<NoDefault, int>("expected<NoDefault, int>");
+    compare_traits<int, ErrorCode>("expected<int, ErrorCode>");
+    compare_traits<void, ErrorCode>("expected<void, ErrorCode>");
+    compare_traits<int, int>("expected<int, int>");
+
+    Inputs inputs(count);
+    std::mt19937 rng(5);
+    for (unsigned char& ok : inputs) {
+        ok = rng() % 8 != 0;
+    }
+
+    const Kernel kernels[] = {
+        PARITY_ENTRY(string_kernel, "fun/value_or"),
+        PARITY_ENTRY(void_kernel, "testVoid/has_value"),
+        PARITY_ENTRY(pair_kernel, "testPair/value"),
+        PARITY_ENTRY(no_default_kernel, "NoDefault/value"),
+        PARITY_ENTRY(error_code_kernel, "ErrorCode/error"),
+#if __cpp_lib_expected >= 202211L
+        PARITY_ENTRY(monadic_kernel, "ErrorCode/and_then"),
+#endif // __cpp_lib_expected >= 202211L
+    };
+
+    std::printf("\n%-24s %10s %10s %12s %12s\n", "code size (bytes)", "std", "exp", "std ns", "exp ns");
+    for (const Kernel& kernel : kernels) {
+        if (kernel.native(inputs) != kernel.experimental(inputs)) {
+            report_failure("results differ from native", kernel.name);
+        }
+
+        const std::size_t native_size = kernel.native_size();
+        const std::size_t experimental_size = kernel.experimental_size();
+        // alternate the two, so that both see the same frequency and cache conditions, and keep the best of each
+        double native_ns = 1e300;
+        double experimental_ns = 1e300;
+        for (int round = 0; timing && round < 5; ++round) {
+            native_ns = (std::min)(native_ns,
+                bench::measure_ns([&] { bench::do_not_optimize(kernel.native(inputs)); }, count));
+            experimental_ns = (std::min)(experimental_ns,
+                bench::measure_ns([&] { bench::do_not_optimize(kernel.experimental(inputs)); }, count));
+        }
+        if (timing) {
+            std::printf("%-24s %10zu %10zu %12.2f %12.2f\n", kernel.name, native_size, experimental_size, native_ns,
+                experimental_ns);
+        } else {
+            std::printf("%-24s %10zu %10zu %12s %12s\n", kernel.name, native_size, experimental_size, "-", "-");
+        }
+
+        if (PARITY_HAS_CODE_SIZE && static_cast<double>(experimental_size) > size_threshold * static_cast<double>(native_size)) {
+            report_failure("code size above the threshold", kernel.name);
+        }
+        if (timing && experimental_ns > runtime_threshold * native_ns) {
+            report_failure("runtime above the threshold", kernel.name);
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+// Evaluates and_then/transform chains of 4, 8 and 16 stages closed by an or_else, once as a member call chain
+// (every call builds, tests and destroys an expected) and once as a pipe expression (e | and_then(f) | ...,
+// one fused pass). Each chain is its own non-inlined function, so that compare_pipe_codegen.sh can report the
+// code size of both; this program reports ns per chain over a range of failure rates.
+
+#include <cstdlib>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/expected_pipeline.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+using Result = expected<int, std::error_code>;
+
+// fails on about one value in 97, so that errors also start in the middle of a chain
+constexpr auto step = [](int x) -> Result {
+    if (x % 97 == 0) {
+        return unexpected{std::make_error_code(std::errc::result_out_of_range)};
+    }
+    return x + 3;
+};
+
+constexpr auto scale = [](int x) { return x * 5 % 100003; };
+
+// out-of-range results are replaced, any other error is passed on
+constexpr auto fallback = [](const std::error_code& error) -> Result {
+    if (error == std::errc::result_out_of_range) {
+        return -1;
+    }
+    return unexpected{error};
+};
+
+template <int Stages>
+Result member_stages(const Result& source) {
+    if constexpr (Stages == 2) {
+        return source.and_then(step).transform(scale);
+    } else {
+        return member_stages<Stages - 2>(source).and_then(step).transform(scale);
+    }
+}
+
+template <int Stages>
+constexpr auto pipe_stages() {
+    using std::experimental::and_then;
+    using std::experimental::transform;
+    if constexpr (Stages == 2) {
+        return and_then(step) | transform(scale);
+    } else {
+        return pipe_stages<Stages - 2>() | and_then(step) | transform(scale);
+    }
+}
+
+} // namespace
+
+// external and out of line, so that the script finds them by name
+#define CHAIN_PAIR(stages)                                                              \
+    [[gnu::noinline]] Result member_chain_##stages(const Result& source) {              \
+        return member_stages<stages>(source).or_else(fallback);                         \
+    }                                                                                   \
+    [[gnu::noinline]] Result pipe_chain_##stages(const Result& source) {                \
+        return source | pipe_stages<stages>() | std::experimental::or_else(fallback);   \
+    }
+
+CHAIN_PAIR(4)
+CHAIN_PAIR(8)
+CHAIN_PAIR(16)
+
+#undef CHAIN_PAIR
+
+namespace {
+
+template <Result (*Chain)(const Result&)>
+double measure(const std::vector<Result>& sources) {
+    return bench::measure_ns(
+        [&] {
+            long long sum = 0;
+            for (const Result& source : sources) {
+                const Result result = Chain(source);
+                sum += result ? *result : result.error().value();
+            }
+            bench::do_not_optimize(sum);
+        },
+        sources.size());
+}
+
+template <Result (*Member)(const Result&), Result (*Pipe)(const Result&)>
+void run(int stages, std::size_t count, double failure_rate) {
+    std::mt19937 rng(11);
+    std::bernoulli_distribution fails(failure_rate);
+    std::uniform_int_distribution<int> values(1, 100000);
+    std::vector<Result> sources;
+    sources.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (fails(rng)) {
+            sources.emplace_back(unexpected{std::make_error_code(std::errc::invalid_argument)});
+        } else {
+            sources.emplace_back(values(rng));
+        }
+        // both forms must agree before either is timed
+        if (Member(sources.back()) != Pipe(sources.back())) {
+            std::printf("FAIL %d stages: the member chain and the pipe disagree\n", stages);
+            std::exit(1);
+        }
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%d stages/%g%% failing", stages, failure_rate * 100);
+    bench::print_row(name, measure<Member>(sources), measure<Pipe>(sources));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+
+    std::printf("%zu chains per run, ns per chain\n\n", count);
+    bench::print_header("stages/source failure rate", "member chain", "pipe");
+    for (const double failure_rate : {0.0, 0.1, 0.5}) {
+        run<member_chain_4, pipe_chain_4>(4, count, failure_rate);
+        run<member_chain_8, pipe_chain_8>(8, count, failure_rate);
+        run<member_chain_16, pipe_chain_16>(16, count, failure_rate);
+    }
+}
@@ -0,0 +1,184 @@
+// Runs an eight stage and_then/transform chain over a buffer of expected<int, E> whose errors are large, three ways:
+//   stepwise   each stage's result in a named local, as code that inspects or logs intermediates does;
+//              every stage copies the error
+//   fluent     one member call chain; the first stage copies the error, every later one moves it
+//   pipeline   pipeline(e).then(...).map(...).run(); the error is copied once, into the result
+// First prints how often each style copies and moves an instrumented error, then ns per chain for each payload.
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/expected_pipeline.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::pipeline;
+using std::experimental::unexpect;
+
+struct InlineError {
+    char message[512];
+};
+
+struct CountedError {
+    static inline int copies = 0;
+    static inline int moves = 0;
+
+    CountedError() = default;
+    CountedError(const CountedError&) {
+        ++copies;
+    }
+    CountedError(CountedError&&) noexcept {
+        ++moves;
+    }
+    CountedError& operator=(const CountedError&) = default;
+    CountedError& operator=(CountedError&&) = default;
+};
+
+template <class E>
+E make_error(std::size_t i) {
+    if constexpr (std::is_same_v<E, std::string>) {
+        return std::string(256, static_cast<char>('a' + i % 26));
+    } else if constexpr (std::is_same_v<E, InlineError>) {
+        InlineError error;
+        std::memset(error.message, 'a' + static_cast<int>(i % 26), sizeof(error.message));
+        return error;
+    } else {
+        return E{};
+    }
+}
+
+template <class E>
+std::size_t digest(const E& error) {
+    if constexpr (std::is_same_v<E, std::string>) {
+        return error.size();
+    } else if constexpr (std::is_same_v<E, InlineError>) {
+        return static_cast<unsigned char>(error.message[0]);
+    } else {
+        return 1;
+    }
+}
+
+// Function objects rather than functions: a pipeline stores its stages, and GCC does not inline a call
+// through a stored function pointer.
+template <class E>
+constexpr auto step = [](int x) -> expected<int, E> { return x + 1; };
+
+constexpr auto twice = [](int x) { return x * 2; };
+
+struct Stepwise {
+    template <class E>
+    static expected<int, E> chain(const expected<int, E>& source) {
+        const auto r1 = source.and_then(step<E>);
+        const auto r2 = r1.transform(twice);
+        const auto r3 = r2.and_then(step<E>);
+        const auto r4 = r3.transform(twice);
+        const auto r5 = r4.and_then(step<E>);
+        const auto r6 = r5.transform(twice);
+        const auto r7 = r6.and_then(step<E>);
+        return r7.transform(twice);
+    }
+};
+
+struct Fluent {
+    template <class E>
+    static expected<int, E> chain(const expected<int, E>& source) {
+        return source.and_then(step<E>)
+            .transform(twice)
+            .and_then(step<E>)
+            .transform(twice)
+            .and_then(step<E>)
+            .transform(twice)
+            .and_then(step<E>)
+            .transform(twice);
+    }
+};
+
+struct Pipeline {
+    template <class E>
+    static expected<int, E> chain(const expected<int, E>& source) {
+        return pipeline(source)
+            .then(step<E>)
+            .map(twice)
+            .then(step<E>)
+            .map(twice)
+            .then(step<E>)
+            .map(twice)
+            .then(step<E>)
+            .map(twice)
+            .run();
+    }
+};
+
+template <class Style>
+void print_counts(const char* name) {
+    const expected<int, CountedError> source{unexpect};
+    CountedError::copies = 0;
+    CountedError::moves  = 0;
+    bench::do_not_optimize(Style::chain(source));
+    std::printf("%-12s %6d %6d\n", name, CountedError::copies, CountedError::moves);
+}
+
+template <class Style, class E>
+double measure(const std::vector<expected<int, E>>& sources) {
+    return bench::measure_ns(
+        [&] {
+            std::size_t sum = 0;
+            for (const expected<int, E>& source : sources) {
+                const expected<int, E> result = Style::chain(source);
+                sum += result ? static_cast<std::size_t>(*result) : digest(result.error());
+            }
+            bench::do_not_optimize(sum);
+        },
+        sources.size());
+}
+
+template <class E>
+void run(const char* payload, std::size_t count, double failure_rate) {
+    std::mt19937 rng(7);
+    std::bernoulli_distribution fails(failure_rate);
+    std::vector<expected<int, E>> sources;
+    sources.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (fails(rng)) {
+            sources.emplace_back(unexpect, make_error<E>(i));
+        } else {
+            sources.emplace_back(static_cast<int>(i));
+        }
+    }
+
+    const double stepwise = measure<Stepwise>(sources);
+    const double fluent   = measure<Fluent>(sources);
+    const double piped    = measure<Pipeline>(sources);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s/%g%%", payload, failure_rate * 100);
+    std::printf("%-28s %11.2f ns %11.2f ns %11.2f ns %8.2fx %8.2fx\n", name, stepwise, fluent, piped,
+        stepwise / piped, fluent / piped);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+
+    std::printf("error copies and moves per chain of 8 stages, failing at the source\n\n");
+    std::printf("%-12s %6s %6s\n", "style", "copies", "moves");
+    print_counts<Stepwise>("stepwise");
+    print_counts<Fluent>("fluent");
+    print_counts<Pipeline>("pipeline");
+
+    std::printf("\n%zu chains per run\n\n", count);
+    std::printf("%-28s %14s %14s %14s %9s %9s\n", "payload/failure rate", "stepwise", "fluent", "pipeline",
+        "vs step", "vs fluent");
+    for (const double failure_rate : {0.0, 0.1, 0.5, 1.0}) {
+        run<std::string>("string(256)", count, failure_rate);
+    }
+    for (const double failure_rate : {0.0, 0.1, 0.5, 1.0}) {
+        run<InlineError>("inline error<512>", count, failure_rate);
+    }
+}
@@ -0,0 +1,136 @@
+// Handles "requests" that each fail 64 lookups, building every error message from parts and then attaching
+// context to it, once with expected<int, std::string> (every message is a global heap allocation) and once with
+// expected<int, pmr::string> constructed by uses-allocator construction on a per-request monotonic arena, which is
+// released in one step when the request ends. Prints global allocations per request, then ns per request with one
+// thread and with several threads handling requests at once.
+
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+thread_local std::size_t allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* const block = std::malloc(size == 0 ? 1 : size)) {
+        return block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpect;
+
+constexpr int lookups_per_request = 64;
+
+// Fails every lookup, so that each request is an error storm
+template <class String, class Alloc>
+expected<int, String> lookup(int key, const Alloc& alloc) {
+    String message(alloc);
+    message += "no entry for key ";
+    message += std::to_string(key);
+    message += " in the routing table";
+    return expected<int, String>{std::allocator_arg, alloc, unexpect, std::move(message)};
+}
+
+// attaches the caller's context, as an error travelling up the stack does
+template <class String>
+void add_context(expected<int, String>& result) {
+    if (!result) {
+        result.error() += " (while resolving the upstream for this request)";
+    }
+}
+
+std::size_t handle_heap(int request) {
+    std::size_t total = 0;
+    for (int i = 0; i < lookups_per_request; ++i) {
+        expected<int, std::string> result = lookup<std::string>(request + i, std::allocator<char>{});
+        add_context(result);
+        total += result ? 0 : result.error().size();
+    }
+    return total;
+}
+
+std::size_t handle_arena(int request) {
+    alignas(std::max_align_t) std::byte buffer[16384];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    const std::pmr::polymorphic_allocator<char> alloc(&arena);
+
+    std::size_t total = 0;
+    for (int i = 0; i < lookups_per_request; ++i) {
+        expected<int, std::pmr::string> result = lookup<std::pmr::string>(request + i, alloc);
+        add_context(result);
+        total += result ? 0 : result.error().size();
+    }
+    return total; // the arena, and every message in it, is released here
+}
+
+template <std::size_t (*Handle)(int)>
+double allocations_per_request(int requests) {
+    const std::size_t before = allocations;
+    std::size_t sum = 0;
+    for (int request = 0; request < requests; ++request) {
+        sum += Handle(request);
+    }
+    bench::do_not_optimize(sum);
+    return static_cast<double>(allocations - before) / requests;
+}
+
+template <std::size_t (*Handle)(int)>
+double measure(int requests, unsigned threads) {
+    return bench::measure_ns(
+        [&] {
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([=] {
+                    std::size_t sum = 0;
+                    for (int request = 0; request < requests; ++request) {
+                        sum += Handle(request);
+                    }
+                    bench::do_not_optimize(sum);
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        },
+        static_cast<std::size_t>(requests) * threads, 3);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const unsigned cores = std::thread::hardware_concurrency();
+    const unsigned threads = cores < 2 ? 2 : (cores > 8 ? 8 : cores);
+
+    std::printf("%d failed lookups per request\n", lookups_per_request);
+    std::printf("global allocations per request: std::string %.1f, pmr::string on an arena %.1f\n\n",
+        allocations_per_request<handle_heap>(requests), allocations_per_request<handle_arena>(requests));
+
+    bench::print_header("threads", "std::string", "arena");
+    bench::print_row("1 thread", measure<handle_heap>(requests, 1), measure<handle_arena>(requests, 1));
+    char name[32];
+    std::snprintf(name, sizeof(name), "%u threads", threads);
+    bench::print_row(name, measure<handle_heap>(requests, threads), measure<handle_arena>(requests, threads));
+}
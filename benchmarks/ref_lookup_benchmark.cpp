@@ -0,0 +1,90 @@
+// Looks records up in a table and reads one field of each, once through a lookup returning expected<Record, E>
+// (a copy of the record) and once through one returning expected<Record&, E> (a pointer to it). Records are
+// 256 bytes to 16 KiB, and about one lookup in eight misses.
+
+#include <cstdlib>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+template <std::size_t Size>
+struct Record {
+    unsigned char bytes[Size];
+};
+
+template <std::size_t Size>
+class Table {
+public:
+    explicit Table(std::size_t count) : records_(count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            records_[i].bytes[0] = static_cast<unsigned char>(i);
+        }
+    }
+
+    [[gnu::noinline]] expected<Record<Size>, std::error_code> copy(std::size_t key) const {
+        if (key >= records_.size()) {
+            return unexpected{std::make_error_code(std::errc::invalid_argument)};
+        }
+        return records_[key];
+    }
+
+    [[gnu::noinline]] expected<const Record<Size>&, std::error_code> find(std::size_t key) const {
+        if (key >= records_.size()) {
+            return unexpected{std::make_error_code(std::errc::invalid_argument)};
+        }
+        return records_[key];
+    }
+
+private:
+    std::vector<Record<Size>> records_;
+};
+
+template <std::size_t Size>
+void run(const char* name, std::size_t count) {
+    constexpr std::size_t records = 256;
+    const Table<Size> table(records);
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<std::size_t> keys(0, records + records / 7);
+    std::vector<std::size_t> lookups(count);
+    for (std::size_t& key : lookups) {
+        key = keys(rng);
+    }
+
+    const auto measure = [&](auto lookup) {
+        return bench::measure_ns(
+            [&] {
+                std::size_t sum = 0;
+                for (const std::size_t key : lookups) {
+                    const auto result = lookup(key);
+                    sum += result ? result->bytes[0] : 1;
+                }
+                bench::do_not_optimize(sum);
+            },
+            count);
+    };
+
+    const double by_copy = measure([&](std::size_t key) { return table.copy(key); });
+    const double by_ref  = measure([&](std::size_t key) { return table.find(key); });
+    bench::print_row(name, by_copy, by_ref);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+
+    bench::print_header("record size", "expected<T, E>", "expected<T&, E>");
+    run<256>("256 bytes", count);
+    run<1024>("1 KiB", count);
+    run<4096>("4 KiB", count);
+    run<16384>("16 KiB", count);
+}
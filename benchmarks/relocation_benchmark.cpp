@@ -0,0 +1,156 @@
+// Compares std::vector with relocating_vector when growing, inserting into and erasing from
+// large buffers of expected results.
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/relocating_vector.h"
+#include "benchmark.h"
+
+// unique_ptr owns a plain pointer and nothing points back at it, so its bytes can simply be moved.
+template <class T>
+struct std::experimental::is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::relocating_vector;
+using std::experimental::unexpected;
+
+struct Payload {
+    long long id;
+    double score;
+};
+
+using PlainResult = expected<long long, std::error_code>; // trivially copyable
+using OwningResult = expected<std::unique_ptr<Payload>, std::error_code>; // trivially relocatable by opt-in
+using StringResult = expected<std::string, std::error_code>; // neither; relocating_vector falls back to moves
+
+static_assert(std::is_trivially_copyable_v<PlainResult>);
+static_assert(!std::is_trivially_copyable_v<OwningResult>);
+static_assert(std::experimental::is_trivially_relocatable_v<OwningResult>);
+
+template <class Result>
+Result make_result(long long i) {
+    const bool ok = i % 8 != 0;
+    if constexpr (std::is_same_v<Result, PlainResult>) {
+        return ok ? Result{i} : Result{unexpected{std::make_error_code(std::errc::invalid_argument)}};
+    } else if constexpr (std::is_same_v<Result, OwningResult>) {
+        return ok ? Result{std::make_unique<Payload>(Payload{i, 0.5})}
+                  : Result{unexpected{std::make_error_code(std::errc::invalid_argument)}};
+    } else {
+        // long enough to defeat the small string optimization
+        return ok ? Result{std::string(32, 'r') + std::to_string(i)}
+                  : Result{unexpected{std::make_error_code(std::errc::invalid_argument)}};
+    }
+}
+
+template <class Vector>
+Vector make_filled(std::size_t count) {
+    Vector results;
+    results.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        results.push_back(make_result<typename Vector::value_type>(static_cast<long long>(i)));
+    }
+    return results;
+}
+
+// Grows from empty without reserve(); the elements are prebuilt so that only reallocation is timed.
+template <class Vector>
+double bench_reallocation(std::size_t count) {
+    std::vector<typename Vector::value_type> source = make_filled<std::vector<typename Vector::value_type>>(count);
+    Vector results;
+
+    return bench::measure_ns(
+        [&] {
+            // hand the elements back so that every run moves the same values
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                source[i] = std::move(results[i]);
+            }
+            results = Vector{};
+        },
+        [&] {
+            for (auto& result : source) {
+                results.push_back(std::move(result));
+            }
+            bench::do_not_optimize(results.data());
+        },
+        count);
+}
+
+// Inserts near the front, shifting almost the whole buffer each time.
+template <class Vector>
+double bench_insert(std::size_t count, std::size_t operations) {
+    using Result = typename Vector::value_type;
+    Vector results = make_filled<Vector>(count);
+    results.reserve(count + operations);
+    std::vector<Result> inserted;
+
+    return bench::measure_ns(
+        [&] {
+            results.erase(results.begin(), results.begin() + static_cast<std::ptrdiff_t>(results.size() - count));
+            inserted.clear();
+            for (std::size_t i = 0; i < operations; ++i) {
+                inserted.push_back(make_result<Result>(-static_cast<long long>(i)));
+            }
+        },
+        [&] {
+            for (std::size_t i = 0; i < operations; ++i) {
+                results.insert(results.begin() + static_cast<std::ptrdiff_t>(i), std::move(inserted[i]));
+            }
+            bench::do_not_optimize(results.data());
+        },
+        operations);
+}
+
+// Erases single elements near the front, shifting almost the whole buffer each time.
+template <class Vector>
+double bench_erase(std::size_t count, std::size_t operations) {
+    using Result = typename Vector::value_type;
+    Vector results = make_filled<Vector>(count + operations);
+
+    return bench::measure_ns(
+        [&] {
+            for (std::size_t i = results.size(); i < count + operations; ++i) {
+                results.push_back(make_result<Result>(static_cast<long long>(i)));
+            }
+        },
+        [&] {
+            for (std::size_t i = 0; i < operations; ++i) {
+                results.erase(results.begin() + static_cast<std::ptrdiff_t>(i % 16));
+            }
+            bench::do_not_optimize(results.data());
+        },
+        operations);
+}
+
+template <class Result>
+void run_all(const char* element, std::size_t count, std::size_t operations) {
+    using Std = std::vector<Result>;
+    using Reloc = relocating_vector<Result>;
+
+    std::string name;
+    name = std::string("reallocation/") + element;
+    bench::print_row(name.c_str(), bench_reallocation<Std>(count), bench_reallocation<Reloc>(count));
+    name = std::string("insert/") + element;
+    bench::print_row(name.c_str(), bench_insert<Std>(count, operations), bench_insert<Reloc>(count, operations));
+    name = std::string("erase/") + element;
+    bench::print_row(name.c_str(), bench_erase<Std>(count, operations), bench_erase<Reloc>(count, operations));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const std::size_t operations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+
+    std::printf("%zu elements, %zu insert/erase operations per run (ns per element or operation)\n\n", count,
+        operations);
+    bench::print_header("operation/element", "std::vector", "relocating");
+    run_all<PlainResult>("expected<long long, error_code>", count, operations);
+    run_all<OwningResult>("expected<unique_ptr<Payload>, error_code>", count, operations);
+    run_all<StringResult>("expected<string, error_code>", count, operations);
+}
@@ -0,0 +1,50 @@
+// Probe sites for check_usdt_probes.sh. Built with _EXPECTED_PROBES=1, each function below creates an error
+// or fails a value(); the script reads the .note.stapsdt notes of the linked program and checks that every
+// probe of [expected.probes] is there, with its three arguments, at a nop.
+
+#include <string>
+#include <system_error>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+
+enum class probe_error { none, timeout = 7 };
+
+extern "C" {
+
+__attribute__((noinline)) expected<int, probe_error> probe_enum_error(int fail) {
+    if (fail) {
+        return unexpected(probe_error::timeout);
+    }
+    return 1;
+}
+
+__attribute__((noinline)) expected<void, std::string> probe_string_error(int fail) {
+    if (fail) {
+        return expected<void, std::string>(unexpect, "failed");
+    }
+    return {};
+}
+
+__attribute__((noinline)) int probe_bad_access(const expected<int, int>& result) {
+    return result.value();
+}
+
+}
+
+int main(int argc, char**) {
+    int failures = !probe_enum_error(argc).has_value() + !probe_string_error(argc).has_value();
+#ifdef __cpp_exceptions
+    try {
+        (void) probe_bad_access(unexpected(argc));
+    } catch (const std::experimental::bad_expected_access<int>&) {
+        ++failures;
+    }
+#else // ^^^ exceptions / no exceptions vvv
+    ++failures;
+#endif // ^^^ no exceptions ^^^
+    return failures == 3 ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+// Probe functions for check_value_codegen.sh. Each one reads a value through value() on the hot path; the
+// script disassembles them and checks that no exception-construction code was inlined into them.
+
+#include <string>
+#include <system_error>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+
+extern "C" {
+
+int probe_value_int(const expected<int, int>& result) {
+    return result.value();
+}
+
+int probe_value_error_code(const expected<int, std::error_code>& result) {
+    return result.value();
+}
+
+std::size_t probe_value_string_error(const expected<std::size_t, std::string>& result) {
+    return result.value();
+}
+
+std::size_t probe_value_moved_string_error(expected<std::size_t, std::string>& result) {
+    return std::move(result).value();
+}
+
+long long probe_value_sum(const expected<int, std::string>* results, std::size_t count) {
+    long long sum = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        sum += results[i].value();
+    }
+    return sum;
+}
+
+}
@@ -0,0 +1,78 @@
+// Hot loops over value(), operator* and the monadic members on results that rarely fail. Built once with and
+// once without exceptions by compare_no_exceptions.sh; it prints one "name ns" row per loop so that the two
+// runs can be joined.
+
+#include <cstdlib>
+#include <system_error>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+#include "benchmark.h"
+
+namespace {
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+using Result = expected<int, std::error_code>;
+
+std::vector<Result> make_results(std::size_t count) {
+    std::vector<Result> results;
+    results.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        results.push_back(static_cast<int>(i % 1000));
+    }
+    return results;
+}
+
+Result halve(int value) {
+    if (value < 0) {
+        return unexpected{std::make_error_code(std::errc::invalid_argument)};
+    }
+    return value / 2;
+}
+
+void report(const char* name, double ns) {
+    std::printf("%-32s %8.2f\n", name, ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+    const std::vector<Result> results = make_results(count);
+
+    report("value()", bench::measure_ns([&] {
+        long long sum = 0;
+        for (const Result& result : results) {
+            sum += result.value();
+        }
+        bench::do_not_optimize(sum);
+    }, count));
+
+    report("operator*", bench::measure_ns([&] {
+        long long sum = 0;
+        for (const Result& result : results) {
+            if (result) {
+                sum += *result;
+            }
+        }
+        bench::do_not_optimize(sum);
+    }, count));
+
+    report("and_then(halve).value()", bench::measure_ns([&] {
+        long long sum = 0;
+        for (const Result& result : results) {
+            sum += result.and_then(halve).value();
+        }
+        bench::do_not_optimize(sum);
+    }, count));
+
+    report("transform(+1).value_or(0)", bench::measure_ns([&] {
+        long long sum = 0;
+        for (const Result& result : results) {
+            sum += result.transform([](int value) { return value + 1; }).value_or(0);
+        }
+        bench::do_not_optimize(sum);
+    }, count));
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+// compact_error experimental header
+
+#ifndef _COMPACT_ERROR_
+#define _COMPACT_ERROR_
+#include "expected.h"
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [compact.error] (extension)
+    // compact_error is a 32-bit stand-in for error_code: the top byte names a domain and the low 24 bits hold the
+    // code, so expected<int, compact_error> is 8 bytes and is returned in one register. Handles compare as integers,
+    // with the meaning of error_code == error_code (same category and value), and message() returns a string_view
+    // into storage that lives as long as the program.
+    // A domain is a constant compact_error_domain holding an id chosen by its author (1 to 254), a name and a table
+    // of messages. It is registered once, before the messages or error_codes of its errors are needed, for instance
+    // by the initializer of a namespace-scope variable. errc values use the built-in generic domain (id 0), so
+    // compact_error{} is success, as error_code{} is.
+    // Conversion to and from error_code is lossless. A domain with an error_category converts to codes of that
+    // category and the other domains to codes of compact_error_category(). error_codes of any other category, or
+    // with values beyond 24 bits, are interned in a process-wide table (id 255) whose entries are never freed.
+
+    _EXPORT_STD struct compact_error_message {
+        int code;
+        string_view text;
+    };
+
+    _EXPORT_STD class compact_error_domain {
+    public:
+        using category_function = const error_category& (*)() noexcept;
+
+        template <size_t _Size>
+        constexpr compact_error_domain(const uint8_t _Id_, const string_view _Name_,
+            const compact_error_message (&_Messages_)[_Size], const category_function _Category_ = nullptr) noexcept
+            : _Id(_Id_), _Name(_Name_), _Messages(_Messages_), _Count(_Size), _Category(_Category_) {}
+
+        compact_error_domain(const compact_error_domain&) = delete;
+        compact_error_domain& operator=(const compact_error_domain&) = delete;
+
+        _NODISCARD constexpr uint8_t id() const noexcept {
+            return _Id;
+        }
+
+        _NODISCARD constexpr string_view name() const noexcept {
+            return _Name;
+        }
+
+        _NODISCARD constexpr string_view message(const int _Code) const noexcept {
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                if (_Messages[_Idx].code == _Code) {
+                    return _Messages[_Idx].text;
+                }
+            }
+
+            return "unknown error";
+        }
+
+        // the error_category whose codes this domain stands for, or null
+        _NODISCARD const error_category* category() const noexcept {
+            return _Category ? _STD addressof(_Category()) : nullptr;
+        }
+
+    private:
+        uint8_t _Id;
+        string_view _Name;
+        const compact_error_message* _Messages;
+        size_t _Count;
+        category_function _Category;
+    };
+
+    // registered domains by id; ids 0 and 255 are the generic and interned domains
+    inline atomic<const compact_error_domain*> _Compact_error_domains[256]{};
+
+    // the registered domains that have a category, in registration order, for conversion from error_code
+    inline atomic<const compact_error_domain*> _Compact_error_category_domains[254]{};
+    inline atomic<size_t> _Compact_error_category_domain_count{0};
+
+    // Returns true if _Domain was registered by this call, false if it already was.
+    _EXPORT_STD inline bool register_compact_error_domain(const compact_error_domain& _Domain) noexcept {
+        _STL_VERIFY(_Domain.id() != 0 && _Domain.id() != 255, "compact_error domain ids 0 and 255 are reserved");
+
+        const compact_error_domain* _Registered = nullptr;
+        if (!_Compact_error_domains[_Domain.id()].compare_exchange_strong(
+                _Registered, _STD addressof(_Domain), memory_order_acq_rel)) {
+            _STL_VERIFY(_Registered == _STD addressof(_Domain), "two compact_error domains use the same id");
+            return false;
+        }
+
+        if (_Domain.category()) {
+            const size_t _Idx = _Compact_error_category_domain_count.fetch_add(1, memory_order_acq_rel);
+            _Compact_error_category_domains[_Idx].store(_STD addressof(_Domain), memory_order_release);
+        }
+
+        return true;
+    }
+
+    struct _Compact_error_interned {
+        const error_category* _Category;
+        int _Code;
+        string _Message;
+    };
+
+    // Entries live in chunks that are never moved or freed, so readers index them without locking.
+    class _Compact_error_intern_table {
+    public:
+        static constexpr uint32_t _Chunk_bits = 12;
+        static constexpr uint32_t _Chunk_size = uint32_t{1} << _Chunk_bits;
+        static constexpr uint32_t _Capacity = (uint32_t{1} << 24) - 1; // index 0xFFFFFF is never used
+
+        _NODISCARD static _Compact_error_intern_table& _Instance() {
+            // never destroyed: handles stay valid until the program has exited
+            static _Compact_error_intern_table& _Table = *new _Compact_error_intern_table;
+            return _Table;
+        }
+
+        _NODISCARD uint32_t _Intern(const error_code& _Ec) {
+            lock_guard<mutex> _Lock(_Mtx);
+            const auto [_It, _Inserted] = _Index[_STD addressof(_Ec.category())].try_emplace(_Ec.value(), _Size);
+            if (_Inserted) {
+                _STL_VERIFY(_Size < _Capacity, "too many distinct error_codes interned by compact_error");
+                atomic<_Compact_error_interned*>& _Chunk = _Chunks[_Size >> _Chunk_bits];
+                _Compact_error_interned* _First = _Chunk.load(memory_order_relaxed);
+                if (!_First) {
+                    _First = new _Compact_error_interned[_Chunk_size];
+                    _Chunk.store(_First, memory_order_release);
+                }
+
+                _First[_Size & (_Chunk_size - 1)] = {
+                    _STD addressof(_Ec.category()), _Ec.value(), _Ec.category().message(_Ec.value()) };
+                ++_Size;
+            }
+
+            return _It->second;
+        }
+
+        _NODISCARD const _Compact_error_interned& _Get(const uint32_t _Idx) const noexcept {
+            return _Chunks[_Idx >> _Chunk_bits].load(memory_order_acquire)[_Idx & (_Chunk_size - 1)];
+        }
+
+    private:
+        _Compact_error_intern_table() = default;
+
+        mutex _Mtx;
+        unordered_map<const error_category*, unordered_map<int, uint32_t>> _Index;
+        uint32_t _Size = 0;
+        atomic<_Compact_error_interned*> _Chunks[(_Capacity >> _Chunk_bits) + 1]{};
+    };
+
+    // The index in the intern table of the message of each errc value, plus one; 0 until it is first asked for.
+    // errno values are small, so this covers every errc of the common platforms.
+    inline atomic<uint32_t> _Compact_error_generic_messages[256]{};
+
+    _EXPORT_STD inline const error_category& compact_error_category() noexcept;
+
+    _EXPORT_STD class compact_error {
+    public:
+        static constexpr uint8_t generic_domain_id = 0;
+        static constexpr uint8_t interned_domain_id = 255;
+
+        compact_error() = default;
+
+        constexpr compact_error(const compact_error_domain& _Domain, const int _Code) noexcept
+            : _Handle(_Make(_Domain.id(), _Code)) {}
+
+        constexpr compact_error(const errc _Code) noexcept : _Handle(_Make(generic_domain_id, static_cast<int>(_Code))) {}
+
+        explicit compact_error(const error_code& _Ec) : _Handle(_From_error_code(_Ec)) {}
+
+        _NODISCARD static constexpr compact_error from_handle(const uint32_t _Handle) noexcept {
+            compact_error _Result;
+            _Result._Handle = _Handle;
+            return _Result;
+        }
+
+        _NODISCARD constexpr uint32_t handle() const noexcept {
+            return _Handle;
+        }
+
+        _NODISCARD constexpr uint8_t domain_id() const noexcept {
+            return static_cast<uint8_t>(_Handle >> 24);
+        }
+
+        _NODISCARD constexpr int value() const noexcept {
+            if (domain_id() == interned_domain_id) {
+                return _Interned()._Code;
+            }
+
+            return static_cast<int32_t>(_Handle << 8) >> 8; // sign-extends the low 24 bits
+        }
+
+        _NODISCARD constexpr explicit operator bool() const noexcept {
+            return value() != 0;
+        }
+
+        // allocates and locks once per distinct code of the generic domain, when its message is first asked for;
+        // later calls are two loads
+        _NODISCARD string_view message() const {
+            switch (domain_id()) {
+            case generic_domain_id:
+                return _Generic_message(value());
+            case interned_domain_id:
+                return _Interned()._Message;
+            default:
+                if (const compact_error_domain* const _Domain = _Registered_domain()) {
+                    return _Domain->message(value());
+                }
+
+                return "unregistered compact_error domain";
+            }
+        }
+
+        _NODISCARD string_view domain_name() const noexcept {
+            switch (domain_id()) {
+            case generic_domain_id:
+                return _STD generic_category().name();
+            case interned_domain_id:
+                return _Interned()._Category->name();
+            default:
+                if (const compact_error_domain* const _Domain = _Registered_domain()) {
+                    return _Domain->name();
+                }
+
+                return "unregistered";
+            }
+        }
+
+        _NODISCARD error_code to_error_code() const noexcept {
+            switch (domain_id()) {
+            case generic_domain_id:
+                return error_code(value(), _STD generic_category());
+            case interned_domain_id:
+                return error_code(_Interned()._Code, *_Interned()._Category);
+            default:
+                if (const compact_error_domain* const _Domain = _Registered_domain()) {
+                    if (const error_category* const _Category = _Domain->category()) {
+                        return error_code(value(), *_Category);
+                    }
+                }
+
+                return error_code(static_cast<int>(_Handle), compact_error_category());
+            }
+        }
+
+        _NODISCARD explicit operator error_code() const noexcept {
+            return to_error_code();
+        }
+
+        _NODISCARD_FRIEND constexpr bool operator==(compact_error, compact_error) noexcept = default;
+
+    private:
+        static constexpr int32_t _Min_code = -(int32_t{1} << 23);
+        static constexpr int32_t _Max_code = (int32_t{1} << 23) - 1;
+
+        _NODISCARD static constexpr bool _Fits(const int _Code) noexcept {
+            return _Code >= _Min_code && _Code <= _Max_code;
+        }
+
+        _NODISCARD static string_view _Generic_message(const int _Code) {
+            _Compact_error_intern_table& _Table = _Compact_error_intern_table::_Instance();
+            if (static_cast<unsigned int>(_Code) >= _STD size(_Compact_error_generic_messages)) {
+                return _Table._Get(_Table._Intern(error_code(_Code, _STD generic_category())))._Message;
+            }
+
+            // the release store publishes the entry written by _Intern to the threads that load the index
+            atomic<uint32_t>& _Cached = _Compact_error_generic_messages[_Code];
+            uint32_t _Idx_plus_one    = _Cached.load(memory_order_acquire);
+            if (_Idx_plus_one == 0) {
+                _Idx_plus_one = _Table._Intern(error_code(_Code, _STD generic_category())) + 1;
+                _Cached.store(_Idx_plus_one, memory_order_release);
+            }
+
+            return _Table._Get(_Idx_plus_one - 1)._Message;
+        }
+
+        _NODISCARD static constexpr uint32_t _Make(const uint8_t _Id, const int _Code) noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(_Fits(_Code), "compact_error codes must fit in 24 bits");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return (uint32_t{_Id} << 24) | (static_cast<uint32_t>(_Code) & 0xFFFFFF);
+        }
+
+        _NODISCARD static uint32_t _From_error_code(const error_code& _Ec) {
+            const error_category& _Category = _Ec.category();
+            const int _Val = _Ec.value();
+            if (_Category == compact_error_category()) {
+                return static_cast<uint32_t>(_Val);
+            }
+
+            if (_Fits(_Val)) {
+                if (_Category == _STD generic_category()) {
+                    return _Make(generic_domain_id, _Val);
+                }
+
+                const size_t _Count = _Compact_error_category_domain_count.load(memory_order_acquire);
+                for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                    const compact_error_domain* const _Domain =
+                        _Compact_error_category_domains[_Idx].load(memory_order_acquire);
+                    if (_Domain && *_Domain->category() == _Category) {
+                        return _Make(_Domain->id(), _Val);
+                    }
+                }
+            }
+
+            return (uint32_t{interned_domain_id} << 24) | _Compact_error_intern_table::_Instance()._Intern(_Ec);
+        }
+
+        _NODISCARD const compact_error_domain* _Registered_domain() const noexcept {
+            return _Compact_error_domains[domain_id()].load(memory_order_acquire);
+        }
+
+        _NODISCARD const _Compact_error_interned& _Interned() const noexcept {
+            return _Compact_error_intern_table::_Instance()._Get(_Handle & 0xFFFFFF);
+        }
+
+        uint32_t _Handle = 0;
+    };
+
+    // 0xFFFFFFFF would be the last entry of the interned domain, which is never used
+    template <>
+    struct niche_traits<compact_error> : value_niche_traits<uint32_t, 0xFFFFFFFFu> {};
+
+    // The category of error_codes converted from compact_errors of domains without a category of their own; the
+    // value of such an error_code is the compact_error handle.
+    class _Compact_error_category_impl final : public error_category {
+    public:
+        constexpr _Compact_error_category_impl() noexcept = default;
+
+        _NODISCARD const char* name() const noexcept override {
+            return "compact_error";
+        }
+
+        _NODISCARD string message(const int _Val) const override {
+            return string{ compact_error::from_handle(static_cast<uint32_t>(_Val)).message() };
+        }
+    };
+
+    _EXPORT_STD inline const error_category& compact_error_category() noexcept {
+        static const _Compact_error_category_impl _Category;
+        return _Category;
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _COMPACT_ERROR_
@@ -4,7 +4,11 @@
 #include <system_error>
 #include <iostream>
 
+#include "compact_error.h"
+#include "error_enum.h"
+#include "error_map.h"
 #include "expected.h"
+#include "expected_match.h"
 
 std::experimental::expected<std::string, std::error_code> fun(bool ay) {
     if (!ay)
@@ -27,6 +31,21 @@ std::experimental::expected<std::pair<int, char>, std::error_code> testPair(bool
 	return std::make_pair(2, 'c');
 }
 
+// The errors of a parser as a compact_error domain: a 32-bit handle, with its messages in this table
+constexpr std::experimental::compact_error_message parseMessages[] = {
+    { 1, "unexpected end of input" },
+    { 2, "number out of range" },
+};
+constexpr std::experimental::compact_error_domain parseErrors{ 1, "parse", parseMessages };
+const bool parseErrorsRegistered = std::experimental::register_compact_error_domain(parseErrors);
+
+static_assert(sizeof(std::experimental::expected<int, std::experimental::compact_error>) == 8);
+
+std::experimental::expected<int, std::experimental::compact_error> testCompact(bool ay) {
+    if (!ay)
+        return std::experimental::unexpected(std::experimental::compact_error{ parseErrors, 2 });
+    return 42;
+}
 
 enum class ErrorCode {
     Success,
@@ -34,20 +53,44 @@ enum class ErrorCode {
     OtherError
 };
 
+// -1 is outside the declared range of ErrorCode
+template <>
+struct std::experimental::niche_traits<ErrorCode>
+    : std::experimental::value_niche_traits<ErrorCode, static_cast<ErrorCode>(-1)> {};
+
+static_assert(sizeof(std::experimental::expected<void, ErrorCode>) == sizeof(ErrorCode));
+
+#ifndef _MSC_VER // the MSVC ABI does not reuse tail padding
+// The discriminant lives in the tail padding of the pair
+static_assert(sizeof(std::experimental::expected<std::pair<int, char>, ErrorCode>) == sizeof(std::pair<int, char>));
+#endif // _MSC_VER
+
+// The names come from the enum itself, so they cannot fall out of sync with it
+static_assert(std::experimental::error_enum_count<ErrorCode> == 3);
+static_assert(std::experimental::error_enum_name(ErrorCode::InvalidArgument) == "InvalidArgument");
+
 std::ostream& operator<<(std::ostream& os, ErrorCode ec)
 {
-    switch (ec) {
-    case ErrorCode::Success: return os << "Success";
-    case ErrorCode::InvalidArgument: return os << "Invalid Argument";
-    case ErrorCode::OtherError: return os << "Other Error";
-    }
-    return os << "Unknown error code";
+    const std::string_view name = std::experimental::error_enum_name(ec);
+    return os << (name.empty() ? std::string_view{ "Unknown error code" } : name);
 }
 
+// Translates ErrorCode at the boundary to code that speaks errc; leaving out an enumerator does not compile
+constexpr std::experimental::error_map<ErrorCode, std::errc> toErrc{ {
+    { ErrorCode::Success, std::errc{} },
+    { ErrorCode::InvalidArgument, std::errc::invalid_argument },
+    { ErrorCode::OtherError, std::errc::io_error },
+}, std::errc::state_not_recoverable };
+
 int main()
 {
     std::cout << std::boolalpha;
 
+#if _EXPECTED_ERROR_TRACES
+    // a demo makes few errors: capture all of them, not one in 100
+    std::experimental::set_error_trace_sampling(1);
+#endif // _EXPECTED_ERROR_TRACES
+
     // Similar interface to std::optional
     std::experimental::expected<int, int> v = 123;
 
@@ -86,10 +129,33 @@ int main()
 	else
 		std::cout << "testVoidResult is not OK" << testVoidResult.has_value() << std::endl;
 
+    auto compactResult = testCompact(false);
+    std::cout << "compactResult error " << compactResult.error().message() << std::endl;
+    // converts to error_code at an API boundary and back without loss
+    const std::error_code compactCode = compactResult.error().to_error_code();
+    std::cout << "as error_code " << compactCode.message() << ", round trip "
+              << (std::experimental::compact_error{ compactCode } == compactResult.error()) << std::endl;
+
     std::cout << fun(true).value() << std::endl;
     std::cout << fun(false).value_or("not OK") << std::endl;
     std::cout << "has value? " << v.has_value() << " : " << v.value() << std::endl;
     std::cout << "has value? " << e.has_value() << " : " << e.error() << std::endl;
+    std::cout << "as errc: " << std::make_error_code(e.transform_error(toErrc).error()).message() << std::endl;
+    // one switch over the value and every error code; a forgotten code would not compile
+    std::cout << "matched: " << std::experimental::match(e,
+        [](int) { return "a value"; },
+        std::experimental::on_error<ErrorCode::InvalidArgument>([] { return "a bad argument"; }),
+        std::experimental::on_error([](ErrorCode) { return "another error"; })) << std::endl;
     std::cout << "has value? " << m.has_value() << " : " << m.value() << std::endl;
     std::cout << "has value? " << n.has_value() << " : " << int(n.value()) << std::endl;
+
+#if _EXPECTED_ERROR_SITES
+    // where the errors above were created, merged across threads
+    std::cout << std::experimental::format_error_sites_text(std::experimental::take_error_site_snapshot());
+#endif // _EXPECTED_ERROR_SITES
+
+#if _EXPECTED_ERROR_TRACES
+    // return addresses only; feed the module+offset of each frame to addr2line to symbolize them
+    std::cout << std::experimental::format_error_traces_text(std::experimental::take_error_traces());
+#endif // _EXPECTED_ERROR_TRACES
 }
\ No newline at end of file
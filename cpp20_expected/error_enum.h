@@ -0,0 +1,232 @@
+#pragma once
+
+// error_enum experimental header
+
+#ifndef _ERROR_ENUM_
+#define _ERROR_ENUM_
+#include "expected.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <utility>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [error.enum] (extension)
+    // Compile-time metadata for enums used as error types, read from the compiler's spelling of each value of the
+    // enum in error_enum_range<E> (by default [-128, 127], or [0, 255] for an unsigned underlying type):
+    //   error_enum_count<E>     the number of enumerators
+    //   error_enum_values<E>    array<E, N> of the enumerators, in ascending order
+    //   error_enum_names<E>     array<string_view, N> of their unqualified names
+    //   error_enum_index(e)     the position of e in error_enum_values<E>, or N when e is not an enumerator
+    //   error_enum_name(e)      the name of e, or an empty string_view when e is not an enumerator
+    // error_enum_index and error_enum_name are one clamped table lookup each, without a branch; for enumerators
+    // with consecutive values error_enum_index is a clamped subtraction.
+    // error_enum_counters<E> keeps one relaxed atomic counter per enumerator, plus one for other values.
+    // Enumerators outside the range are treated as other values; specialize error_enum_range to widen it. When
+    // several enumerators share a value, the name of the one the compiler prints is used.
+
+    _EXPORT_STD template <class _Enum>
+        struct error_enum_range {
+        static constexpr long long min = is_signed_v<underlying_type_t<_Enum>> ? -128 : 0;
+        static constexpr long long max = is_signed_v<underlying_type_t<_Enum>> ? 127 : 255;
+    };
+
+    template <class _Ty>
+    _NODISCARD constexpr bool _Is_identifier_char(const _Ty _Ch) noexcept {
+        return (_Ch >= 'a' && _Ch <= 'z') || (_Ch >= 'A' && _Ch <= 'Z') || (_Ch >= '0' && _Ch <= '9') || _Ch == '_';
+    }
+
+    // The name of the enumerator _Val, or empty if _Val has none. Compilers print a named value as its qualified
+    // name and any other value as a cast of a number, such as (E)5 or (enum E)0x5.
+    template <auto _Val>
+    _NODISCARD consteval string_view _Error_enum_value_name() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+        constexpr string_view _Sig = __FUNCSIG__;
+        constexpr size_t _End = _Sig.rfind(">(void)");
+#else // ^^^ MSVC / GCC, Clang vvv
+        constexpr string_view _Sig = __PRETTY_FUNCTION__;
+        constexpr size_t _End = _Sig.find_first_of(";]", _Sig.find("_Val = "));
+#endif // ^^^ GCC, Clang ^^^
+        size_t _First = _End;
+        while (_First > 0 && _Is_identifier_char(_Sig[_First - 1])) {
+            --_First;
+        }
+
+        if (_First == _End || (_Sig[_First] >= '0' && _Sig[_First] <= '9')) {
+            return {};
+        }
+
+        return _Sig.substr(_First, _End - _First);
+    }
+
+    template <class _Enum>
+    struct _Error_enum_meta {
+        using _Under = underlying_type_t<_Enum>;
+
+        static constexpr long long _Min = (_STD max)(error_enum_range<_Enum>::min,
+            static_cast<long long>((numeric_limits<_Under>::min)()));
+        static constexpr long long _Max = (_STD min)(error_enum_range<_Enum>::max,
+            static_cast<long long>((numeric_limits<_Under>::max)()));
+        static_assert(_Min <= _Max, "error_enum_range<E> must not be empty.");
+        static_assert(_Max - _Min < 65536, "error_enum_range<E> may span at most 65536 values.");
+
+        static constexpr size_t _Span = static_cast<size_t>(_Max - _Min + 1);
+
+        template <size_t... _Offsets>
+        static consteval array<string_view, _Span> _Names_by_offset(index_sequence<_Offsets...>) noexcept {
+            return { _Error_enum_value_name<static_cast<_Enum>(
+                static_cast<_Under>(_Min + static_cast<long long>(_Offsets)))>()... };
+        }
+
+        static constexpr array<string_view, _Span> _All_names = _Names_by_offset(make_index_sequence<_Span>{});
+
+        static constexpr size_t _Count = [] {
+            size_t _Result = 0;
+            for (const string_view _Name : _All_names) {
+                _Result += !_Name.empty();
+            }
+            return _Result;
+        }();
+
+        static constexpr array<_Enum, _Count> _Values = [] {
+            array<_Enum, _Count> _Result{};
+            size_t _Idx = 0;
+            for (size_t _Offset = 0; _Offset < _Span; ++_Offset) {
+                if (!_All_names[_Offset].empty()) {
+                    _Result[_Idx++] = static_cast<_Enum>(static_cast<_Under>(_Min + static_cast<long long>(_Offset)));
+                }
+            }
+            return _Result;
+        }();
+
+        // the names of the enumerators, then an empty name for any other value
+        static constexpr array<string_view, _Count + 1> _Names = [] {
+            array<string_view, _Count + 1> _Result{};
+            size_t _Idx = 0;
+            for (const string_view _Name : _All_names) {
+                if (!_Name.empty()) {
+                    _Result[_Idx++] = _Name;
+                }
+            }
+            _Result[_Count] = string_view{}; // assigned, not only value-initialized: GCC 12 rejects reading it otherwise
+            return _Result;
+        }();
+
+        // whether the enumerators are consecutive values, so that an index is an offset from the first
+        static constexpr bool _Contiguous = [] {
+            for (size_t _Idx = 1; _Idx < _Count; ++_Idx) {
+                const long long _Next = static_cast<long long>(_Values[0]) + static_cast<long long>(_Idx);
+                if (static_cast<long long>(_Values[_Idx]) != _Next) {
+                    return false;
+                }
+            }
+            return true;
+        }();
+
+        static constexpr long long _First = _Count == 0 ? _Min : static_cast<long long>(_Values[0]);
+
+        using _Index_type = conditional_t<(_Count < 256), uint8_t, uint16_t>;
+
+        // the index of each value of the range, then _Count for any value outside it
+        static constexpr array<_Index_type, _Span + 1> _Indices = [] {
+            array<_Index_type, _Span + 1> _Result{};
+            size_t _Idx = 0;
+            for (size_t _Offset = 0; _Offset < _Span; ++_Offset) {
+                _Result[_Offset] = static_cast<_Index_type>(_All_names[_Offset].empty() ? _Count : _Idx++);
+            }
+            _Result[_Span] = static_cast<_Index_type>(_Count);
+            return _Result;
+        }();
+    };
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    inline constexpr size_t error_enum_count = _Error_enum_meta<_Enum>::_Count;
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    inline constexpr array<_Enum, error_enum_count<_Enum>> error_enum_values = _Error_enum_meta<_Enum>::_Values;
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    inline constexpr array<string_view, error_enum_count<_Enum>> error_enum_names = [] {
+        array<string_view, error_enum_count<_Enum>> _Result{};
+        for (size_t _Idx = 0; _Idx < _Result.size(); ++_Idx) {
+            _Result[_Idx] = _Error_enum_meta<_Enum>::_Names[_Idx];
+        }
+        return _Result;
+    }();
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    _NODISCARD constexpr size_t error_enum_index(const _Enum _Val) noexcept {
+        using _Meta = _Error_enum_meta<_Enum>;
+        const auto _Value = static_cast<long long>(static_cast<typename _Meta::_Under>(_Val));
+        // values below the range wrap around to large offsets, so one clamp covers both ends
+        if constexpr (_Meta::_Contiguous) { // the index is the offset, no table needed
+            const auto _Offset = static_cast<unsigned long long>(_Value - _Meta::_First);
+            return static_cast<size_t>((_STD min)(_Offset, static_cast<unsigned long long>(_Meta::_Count)));
+        }
+        else {
+            const auto _Offset = static_cast<unsigned long long>(_Value - _Meta::_Min);
+            return _Meta::_Indices[(_STD min)(_Offset, static_cast<unsigned long long>(_Meta::_Span))];
+        }
+    }
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    _NODISCARD constexpr string_view error_enum_name(const _Enum _Val) noexcept {
+        return _Error_enum_meta<_Enum>::_Names[_STD experimental::error_enum_index(_Val)];
+    }
+
+    _EXPORT_STD template <class _Enum>
+        requires is_enum_v<_Enum>
+    class error_enum_counters {
+        public:
+            void record(const _Enum _Val) noexcept {
+                _Counts[_STD experimental::error_enum_index(_Val)].fetch_add(1, memory_order_relaxed);
+            }
+
+            _NODISCARD uint64_t count(const _Enum _Val) const noexcept {
+                return _Counts[_STD experimental::error_enum_index(_Val)].load(memory_order_relaxed);
+            }
+
+            // the count of the enumerator error_enum_values<E>[_Idx], or of all other values when _Idx == N
+            _NODISCARD uint64_t count_at(const size_t _Idx) const noexcept {
+                return _Counts[_Idx].load(memory_order_relaxed);
+            }
+
+            void reset() noexcept {
+                for (atomic<uint64_t>& _Count : _Counts) {
+                    _Count.store(0, memory_order_relaxed);
+                }
+            }
+
+        private:
+            array<atomic<uint64_t>, error_enum_count<_Enum> + 1> _Counts{};
+    };
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _ERROR_ENUM_
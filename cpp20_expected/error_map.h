@@ -0,0 +1,113 @@
+#pragma once
+
+// error_map experimental header
+
+#ifndef _ERROR_MAP_
+#define _ERROR_MAP_
+#include "error_enum.h"
+#include <array>
+#include <cstddef>
+#include <utility>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [error.map] (extension)
+    // error_map<From, To> translates the codes of one error enum into values of another error type, as the
+    // switch in a transform_error lambda at a layer boundary would. It is declared as a constant list of
+    // {from, to} entries plus a fallback, checked when it is constructed to map every enumerator of From exactly
+    // once (enumerators as found by error_enum.h), and stored as a table indexed by error_enum_index: a call is
+    // one load, whatever the code. Values of From that are not enumerators get the fallback.
+    // An error_map is a function object, so it is passed to transform_error as is:
+    //     constexpr error_map<ErrorCode, errc> to_errc{{{ErrorCode::Timeout, errc::timed_out}, ...}, errc::io_error};
+    //     auto _Result = _Lookup().transform_error(to_errc);
+    // Mapping to an expected<T, G> serves or_else, recovering some codes as values and translating the rest:
+    //     constexpr error_map<ErrorCode, expected<int, errc>> recover{{{ErrorCode::NotFound, 0}, ...}, ...};
+    //     auto _Result = _Lookup().or_else(recover);
+
+    // Reaching a call to one of these functions during the construction of an error_map makes it ill-formed;
+    // the name of the function tells why.
+    void _Error_map_entry_source_is_not_an_enumerator();
+    void _Error_map_entry_source_is_mapped_twice();
+    void _Error_map_enumerator_is_not_mapped();
+
+    _EXPORT_STD template <class _From, class _To>
+        requires is_enum_v<_From>
+    class error_map {
+        public:
+            using source_type = _From;
+            using target_type = _To;
+
+            struct entry {
+                _From from;
+                _To to;
+            };
+
+            template <size_t _Size>
+            consteval error_map(const entry (&_Entries)[_Size], const _To& _Fallback)
+                : _Table(_Make_table(_Entries, _Fallback, make_index_sequence<error_enum_count<_From>>{})) {}
+
+            // by value: transform_error and or_else require an object type
+            _NODISCARD constexpr _To operator()(const _From _Code) const
+                noexcept(is_nothrow_copy_constructible_v<_To>) {
+                return _Table[_STD experimental::error_enum_index(_Code)];
+            }
+
+        private:
+            template <size_t _Size, size_t... _Indices>
+            static consteval array<_To, error_enum_count<_From> + 1> _Make_table(
+                const entry (&_Entries)[_Size], const _To& _Fallback, index_sequence<_Indices...>) {
+                array<size_t, error_enum_count<_From>> _Uses{};
+                for (const entry& _Entry : _Entries) {
+                    const size_t _Idx = _STD experimental::error_enum_index(_Entry.from);
+                    if (_Idx == error_enum_count<_From>) {
+                        _Error_map_entry_source_is_not_an_enumerator();
+                    }
+                    if (_Uses[_Idx]++ != 0) {
+                        _Error_map_entry_source_is_mapped_twice();
+                    }
+                }
+
+                for (const size_t _Count : _Uses) {
+                    if (_Count == 0) {
+                        _Error_map_enumerator_is_not_mapped();
+                    }
+                }
+
+                return { _Target_of(_Entries, error_enum_values<_From>[_Indices])..., _Fallback };
+            }
+
+            template <size_t _Size>
+            static consteval const _To& _Target_of(const entry (&_Entries)[_Size], const _From _Code) {
+                for (const entry& _Entry : _Entries) {
+                    if (_Entry.from == _Code) {
+                        return _Entry.to;
+                    }
+                }
+
+                _Error_map_enumerator_is_not_mapped();
+                return _Entries[0].to;
+            }
+
+            array<_To, error_enum_count<_From> + 1> _Table; // by error_enum_index, then the fallback
+    };
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _ERROR_MAP_
@@ -8,29 +8,144 @@
 #pragma once
 #ifndef _EXPECTED_
 #define _EXPECTED_
-#include <yvals.h>
+#include "expected_config.h"
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <initializer_list>
+#include <memory>
 #include <type_traits>
-#include <xutility>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> // for __fastfail
+#endif // ^^^ MSVC ^^^
 #if _STL_COMPILER_PREPROCESSOR
 #if !_HAS_CXX23 || !defined(__cpp_lib_concepts) // TRANSITION, GH-395
 // This project is to test if I can use expected in a c++20 project, via copying the code from C++23.
 //_EMIT_STL_WARNING(STL4038, "The contents of <expected> are available only with C++23 or later. This code is copied from C++23 to be used as experimental use.");
 #endif // ^^^ not supported / supported language mode vvv
 
+#ifdef _MSC_VER
 #pragma pack(push, _CRT_PACKING)
 #pragma warning(push, _STL_WARNING_LEVEL)
 #pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
 _STL_DISABLE_CLANG_WARNINGS
 #pragma push_macro("new")
 #undef new
 
+#ifndef _EXPECTED_COLD
+#if defined(__GNUC__) || defined(__clang__)
+#define _EXPECTED_COLD __attribute__((noinline, cold))
+#else // ^^^ GCC, Clang / MSVC vvv
+#define _EXPECTED_COLD __declspec(noinline)
+#endif // ^^^ MSVC ^^^
+#endif // _EXPECTED_COLD
+
+#ifndef _EXPECTED_NOINLINE
+#if defined(__GNUC__) || defined(__clang__)
+#define _EXPECTED_NOINLINE __attribute__((noinline))
+#else // ^^^ GCC, Clang / MSVC vvv
+#define _EXPECTED_NOINLINE __declspec(noinline)
+#endif // ^^^ MSVC ^^^
+#endif // _EXPECTED_NOINLINE
+
+// Whether value() and the containers throw. Without exceptions (-fno-exceptions, /EHs-c-, _HAS_EXCEPTIONS=0)
+// every throw site hands the exception object to _Expected_failure instead, see [expected.failure].
+#ifndef _EXPECTED_HAS_EXCEPTIONS
+#if (defined(__cpp_exceptions) || defined(_CPPUNWIND)) && (!defined(_HAS_EXCEPTIONS) || _HAS_EXCEPTIONS)
+#define _EXPECTED_HAS_EXCEPTIONS 1
+#else // ^^^ exceptions enabled / exceptions disabled vvv
+#define _EXPECTED_HAS_EXCEPTIONS 0
+#endif // ^^^ exceptions disabled ^^^
+#endif // _EXPECTED_HAS_EXCEPTIONS
+
+// What a failure does without exceptions when no handler is installed, or when the handler returns
+#define _EXPECTED_FAILURE_TRAP  0 // execute a trapping instruction; smallest code, no diagnostic
+#define _EXPECTED_FAILURE_ABORT 1 // print what() to stderr, then abort()
+#ifndef _EXPECTED_FAILURE_POLICY
+#define _EXPECTED_FAILURE_POLICY _EXPECTED_FAILURE_ABORT
+#endif // _EXPECTED_FAILURE_POLICY
+
+#if _EXPECTED_HAS_EXCEPTIONS
+#define _EXPECTED_THROW(...) throw __VA_ARGS__
+#else // ^^^ exceptions enabled / exceptions disabled vvv
+#define _EXPECTED_THROW(...) _STD experimental::_Expected_failure(__VA_ARGS__)
+#endif // ^^^ exceptions disabled ^^^
+
+// Whether the constructors of unexpected and expected that create an error count their call sites, see
+// [expected.sites] in expected_error_sites.h, and whether they capture sampled stack traces, see [expected.traces]
+// in expected_error_traces.h. The macros mark those constructors (_EXPECTED_SITE_PARAM,
+// _EXPECTED_SITE_DEFAULT_PARAM, _EXPECTED_RECORD_SITE) and the constructions of errors by expected itself, which
+// are not counted (_EXPECTED_UNTRACKED) or count the site of the constructor that delegates them
+// (_EXPECTED_PASS_SITE). Without either facility they expand to the code as it is without them.
+#ifndef _EXPECTED_ERROR_SITES
+#define _EXPECTED_ERROR_SITES 0
+#endif // _EXPECTED_ERROR_SITES
+
+#ifndef _EXPECTED_ERROR_TRACES
+#define _EXPECTED_ERROR_TRACES 0
+#endif // _EXPECTED_ERROR_TRACES
+
+#if _EXPECTED_ERROR_SITES || _EXPECTED_ERROR_TRACES
+#include "expected_error_sites.h"
+#define _EXPECTED_SITE_PARAM(_Tag_type, _Name) _STD experimental::_Error_site_tag<_Tag_type> _Name
+#define _EXPECTED_SITE_DEFAULT_PARAM(_Name) , const _STD source_location _Name = _STD source_location::current()
+#define _EXPECTED_RECORD_SITE(_Name)        _STD experimental::_Record_error_site(_Name)
+#define _EXPECTED_UNTRACKED(_Tag) \
+    _STD experimental::_Error_site_tag<_STD remove_const_t<decltype(_Tag)>>{ _STD experimental::_Untracked_error_site }
+#define _EXPECTED_PASS_SITE(_Name, _Tag) _STD experimental::_Error_site_tag<_STD remove_const_t<decltype(_Tag)>>{ _Name }
+#else // ^^^ error sites or traces / neither vvv
+#define _EXPECTED_SITE_PARAM(_Tag_type, _Name) _Tag_type
+#define _EXPECTED_SITE_DEFAULT_PARAM(_Name)
+#define _EXPECTED_RECORD_SITE(_Name)
+#define _EXPECTED_UNTRACKED(_Tag)        _Tag
+#define _EXPECTED_PASS_SITE(_Name, _Tag) _Tag
+#endif // ^^^ neither ^^^
+
+// Whether errors are constructed, and value() fails, at USDT probes, see [expected.probes] in expected_probes.h.
+// _EXPECTED_PROBE(name, error) marks those points; without probes it expands to nothing.
+#ifndef _EXPECTED_PROBES
+#define _EXPECTED_PROBES 0
+#endif // _EXPECTED_PROBES
+
+#if _EXPECTED_PROBES
+#include "expected_probes.h"
+#define _EXPECTED_PROBE(_Name, _Error) _STD experimental::_Probe_##_Name(_Error)
+#else // ^^^ probes / no probes vvv
+#define _EXPECTED_PROBE(_Name, _Error)
+#endif // ^^^ no probes ^^^
+
 namespace std::experimental {
      
     _EXPORT_STD template <class _Err>
         class unexpected;
 
+    // [expected.alloc] (extension)
+    // The allocator_arg_t constructors of unexpected and expected construct the value or error by uses-allocator
+    // construction (N4950 [allocator.uses.construction]): a payload that uses the allocator, such as a pmr::string
+    // given a polymorphic_allocator, is handed it, and any other payload ignores it. uses_allocator<expected<T, E>, A>
+    // holds when T or E uses A, so that allocator-aware containers such as pmr::vector pass their allocator on too.
+    // Errors built on a per-request monotonic_buffer_resource then cost no global allocation and are all freed by
+    // one release(); moves keep the resource, so copy an error that outlives the request onto another allocator
+    // with expected(allocator_arg, _Al, _Other).
+    template <class _Ty, class _Alloc, class... _Args>
+    concept _Is_uses_allocator_constructible = (uses_allocator_v<remove_cv_t<_Ty>, _Alloc>
+        ? (is_constructible_v<_Ty, allocator_arg_t, const _Alloc&, _Args...>
+              || is_constructible_v<_Ty, _Args..., const _Alloc&>)
+        : is_constructible_v<_Ty, _Args...>);
+
+    template <class _Ty>
+    struct _Make_obj_using_allocator_fn {
+        template <class _Alloc, class... _Args>
+        _NODISCARD constexpr _Ty operator()(const _Alloc& _Al, _Args&&... _Vals) const {
+            return _STD make_obj_using_allocator<_Ty>(_Al, _STD forward<_Args>(_Vals)...);
+        }
+    };
+
     template <class _Err>
     struct _Check_unexpected_argument : true_type {
         static_assert(is_object_v<_Err>, "E must be an object type. (N4950 [expected.un.general]/2)");
@@ -54,20 +169,41 @@ namespace std::experimental {
             template <class _UError = _Err>
                 requires (!is_same_v<remove_cvref_t<_UError>, unexpected> && !is_same_v<remove_cvref_t<_UError>, in_place_t>
             && is_constructible_v<_Err, _UError>)
-                constexpr explicit unexpected(_UError&& _Unex) noexcept(is_nothrow_constructible_v<_Err, _UError>) // strengthened
-                : _Unexpected(_STD forward<_UError>(_Unex)) {}
+                constexpr explicit unexpected(_UError&& _Unex _EXPECTED_SITE_DEFAULT_PARAM(_Site)) noexcept(
+                    is_nothrow_constructible_v<_Err, _UError>) // strengthened
+                : _Unexpected(_STD forward<_UError>(_Unex)) {
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(unexpected, _Unexpected);
+            }
 
             template <class... _Args>
                 requires is_constructible_v<_Err, _Args...>
-            constexpr explicit unexpected(in_place_t, _Args&&... _Vals) noexcept(
+            constexpr explicit unexpected(_EXPECTED_SITE_PARAM(in_place_t, _Site), _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Err, _Args...>) // strengthened
-                : _Unexpected(_STD forward<_Args>(_Vals)...) {}
+                : _Unexpected(_STD forward<_Args>(_Vals)...) {
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(unexpected, _Unexpected);
+            }
 
             template <class _Uty, class... _Args>
                 requires is_constructible_v<_Err, initializer_list<_Uty>&, _Args...>
-            constexpr explicit unexpected(in_place_t, initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
+            constexpr explicit unexpected(
+                _EXPECTED_SITE_PARAM(in_place_t, _Site), initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Err, initializer_list<_Uty>&, _Args...>) // strengthened
-                : _Unexpected(_Ilist, _STD forward<_Args>(_Vals)...) {}
+                : _Unexpected(_Ilist, _STD forward<_Args>(_Vals)...) {
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(unexpected, _Unexpected);
+            }
+
+            // [expected.alloc] (extension)
+            template <class _Alloc, class... _Args>
+                requires _Is_uses_allocator_constructible<_Err, _Alloc, _Args...>
+            constexpr explicit unexpected(
+                allocator_arg_t, const _Alloc& _Al, _EXPECTED_SITE_PARAM(in_place_t, _Site), _Args&&... _Vals)
+                : _Unexpected(_STD make_obj_using_allocator<_Err>(_Al, _STD forward<_Args>(_Vals)...)) {
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(unexpected, _Unexpected);
+            }
 
             // [expected.un.obs]
             _NODISCARD constexpr const _Err& error() const& noexcept {
@@ -127,11 +263,11 @@ namespace std::experimental {
         bad_expected_access& operator=(const bad_expected_access&) = default;
         bad_expected_access& operator=(bad_expected_access&&) = default;
 
-#if !_HAS_EXCEPTIONS
+#if defined(_CPPLIB_VER) && !_HAS_EXCEPTIONS
         void _Doraise() const override { // perform class-specific exception handling
             _RAISE(*this);
         }
-#endif // !_HAS_EXCEPTIONS
+#endif // defined(_CPPLIB_VER) && !_HAS_EXCEPTIONS
     };
 
     _EXPORT_STD template <class _Err>
@@ -157,12 +293,79 @@ namespace std::experimental {
             _Err _Unexpected;
     };
 
+    // [expected.failure] (extension)
+    // Without exceptions, value() on an error and the length checks of the containers call the installed failure
+    // handler with the exception they would have thrown. A handler that does not return (it may longjmp, log
+    // and exit, or terminate the process its own way) replaces the policy; if it returns, or none is installed,
+    // _EXPECTED_FAILURE_POLICY applies. With exceptions enabled the handler is never called.
+    _EXPORT_STD using expected_failure_handler = void (*)(const exception&);
+
+    inline atomic<expected_failure_handler> _Expected_failure_handler{ nullptr };
+
+    _EXPORT_STD inline expected_failure_handler set_expected_failure_handler(
+        const expected_failure_handler _Handler) noexcept {
+        return _Expected_failure_handler.exchange(_Handler);
+    }
+    _EXPORT_STD _NODISCARD inline expected_failure_handler get_expected_failure_handler() noexcept {
+        return _Expected_failure_handler.load();
+    }
+
+    [[noreturn]] _EXPECTED_COLD inline void _Expected_failure(const exception& _Exc) noexcept {
+        if (const expected_failure_handler _Handler = _Expected_failure_handler.load()) {
+            _Handler(_Exc);
+        }
+
+#if _EXPECTED_FAILURE_POLICY == _EXPECTED_FAILURE_TRAP
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_trap();
+#else // ^^^ GCC, Clang / MSVC vvv
+        __fastfail(7); // FAST_FAIL_FATAL_APP_EXIT
+#endif // ^^^ MSVC ^^^
+#elif _EXPECTED_FAILURE_POLICY == _EXPECTED_FAILURE_ABORT
+        _CSTD fprintf(stderr, "expected failure: %s\n", _Exc.what());
+        _CSTD abort();
+#else // ^^^ _EXPECTED_FAILURE_ABORT / unknown vvv
+#error _EXPECTED_FAILURE_POLICY must be _EXPECTED_FAILURE_TRAP or _EXPECTED_FAILURE_ABORT
+#endif // ^^^ unknown ^^^
+    }
+
+    // The failure path of value(). Kept out of line and cold so that value() inlines to a test and a load, and
+    // shared by every expected (and every value category of it) with the same error type.
+    template <class _Err>
+    [[noreturn]] _EXPECTED_COLD void _Throw_bad_expected_access(const _Err& _Unex) {
+        _EXPECTED_PROBE(bad_access, _Unex);
+        _EXPECTED_THROW(bad_expected_access<_Err>{ _Unex });
+    }
+    template <class _Err>
+    [[noreturn]] _EXPECTED_COLD void _Throw_bad_expected_access_moved(_Err& _Unex) {
+        _EXPECTED_PROBE(bad_access, _Unex);
+        _EXPECTED_THROW(bad_expected_access<_Err>{ _STD move(_Unex) });
+    }
+
     _EXPORT_STD struct unexpect_t {
         explicit unexpect_t() = default;
     };
 
     _EXPORT_STD inline constexpr unexpect_t unexpect{};
 
+    // [expected.from] (extension)
+    // expected(in_place_from, f, args...) and expected(unexpect_from, f, args...) initialize the value or the error
+    // with the result of invoke(f, args...), and emplace_from(f, args...) replaces the contents with it. When f
+    // returns a prvalue of the value (or error) type, that prvalue is the contained object: no move is made, as
+    // transform() already does for its result. The tail padding layout (see _Expected_flag_in_tail_padding) is the
+    // exception; there the result is moved once.
+    _EXPORT_STD struct in_place_from_t {
+        explicit in_place_from_t() = default;
+    };
+
+    _EXPORT_STD inline constexpr in_place_from_t in_place_from{};
+
+    _EXPORT_STD struct unexpect_from_t {
+        explicit unexpect_from_t() = default;
+    };
+
+    _EXPORT_STD inline constexpr unexpect_from_t unexpect_from{};
+
     struct _Construct_expected_from_invoke_result_tag {
         explicit _Construct_expected_from_invoke_result_tag() = default;
     };
@@ -173,6 +376,16 @@ namespace std::experimental {
             _STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Tys>(_Vals)...));
     };
 
+    // unlike is_constructible_v<_Ty, invoke_result_t<...>>, also true for a prvalue of an immovable _Ty
+    template <class _Ty, class _Fn, class... _Tys>
+    concept _Is_invoke_constructible_as = requires(_Fn && _Func, _Tys&&... _Vals) {
+        static_cast<_Ty>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Tys>(_Vals)...));
+    };
+
+    template <class _Ty, class _Fn, class... _Tys>
+    inline constexpr bool _Is_nothrow_invoke_constructible_as =
+        noexcept(static_cast<_Ty>(_STD invoke(_STD declval<_Fn>(), _STD declval<_Tys>()...)));
+
     template <class _Ty>
     struct _Check_expected_argument : true_type {
         static_assert(!is_reference_v<_Ty>, "T must not be a reference type. (N4950 [expected.object.general]/2)");
@@ -186,6 +399,237 @@ namespace std::experimental {
             "T must not be a (possibly cv-qualified) specialization of unexpected. (N4950 [expected.object.general]/2)");
     };
 
+    // [expected.niche] (extension)
+    // Specializing niche_traits<T> promises that T has a bit pattern (the niche) which no live T ever holds.
+    // expected<T, E> and expected<void, E> then encode their discriminant in that pattern instead of a bool.
+    // A specialization with has_niche == true provides:
+    //   static constexpr size_t niche_offset;         // bytes [0, niche_offset) are never read or written
+    //   static void set_niche(void* _Storage);         // writes the niche into storage holding no live T
+    //   static bool is_niche(const void* _Storage);    // true iff _Storage holds the niche
+    // The niche is used only when the other alternative fits in the first niche_offset bytes.
+    // Objects using a niche layout are not usable in constant expressions.
+    _EXPORT_STD template <class _Ty>
+        struct niche_traits {
+        static constexpr bool has_niche = false;
+    };
+
+    // A pointer at byte _Offset of _Ty that is never null, such as the category of error_code
+    _EXPORT_STD template <class _Ty, size_t _Offset>
+        struct pointer_niche_traits {
+        static_assert(_Offset + sizeof(void*) <= sizeof(_Ty), "The niche pointer must lie within T.");
+
+        static constexpr bool has_niche = true;
+        static constexpr size_t niche_offset = _Offset;
+
+        static void set_niche(void* const _Storage) noexcept {
+            const void* const _Null = nullptr;
+            _CSTD memcpy(static_cast<unsigned char*>(_Storage) + _Offset, &_Null, sizeof(_Null));
+        }
+
+        _NODISCARD static bool is_niche(const void* const _Storage) noexcept {
+            const void* _Ptr;
+            _CSTD memcpy(&_Ptr, static_cast<const unsigned char*>(_Storage) + _Offset, sizeof(_Ptr));
+            return _Ptr == nullptr;
+        }
+    };
+
+    // A value of _Ty that is never used, such as an enumerator value outside the declared range
+    _EXPORT_STD template <class _Ty, _Ty _Sentinel>
+        struct value_niche_traits {
+        static_assert(is_trivially_copyable_v<_Ty>, "The niche value must be trivially copyable.");
+
+        static constexpr bool has_niche = true;
+        static constexpr size_t niche_offset = 0;
+
+        static void set_niche(void* const _Storage) noexcept {
+            const _Ty _Val = _Sentinel;
+            _CSTD memcpy(_Storage, _STD addressof(_Val), sizeof(_Ty));
+        }
+
+        _NODISCARD static bool is_niche(const void* const _Storage) noexcept {
+            _Ty _Val;
+            _CSTD memcpy(_STD addressof(_Val), _Storage, sizeof(_Ty));
+            return _Val == _Sentinel;
+        }
+    };
+
+    enum class _Expected_niche : unsigned char { _None, _In_value, _In_error };
+
+    struct _Expected_niche_flag {}; // stands in for the bool discriminant when a niche is used
+
+    template <class _Ty, class _Err>
+    _NODISCARD consteval _Expected_niche _Select_expected_niche() noexcept {
+        if constexpr (niche_traits<_Err>::has_niche) {
+            if constexpr (is_void_v<_Ty>) {
+                return _Expected_niche::_In_error;
+            }
+            else if constexpr (sizeof(_Ty) <= niche_traits<_Err>::niche_offset) {
+                return _Expected_niche::_In_error;
+            }
+        }
+
+        if constexpr (!is_void_v<_Ty>) {
+            if constexpr (niche_traits<_Ty>::has_niche) {
+                if constexpr (sizeof(_Err) <= niche_traits<_Ty>::niche_offset) {
+                    return _Expected_niche::_In_value;
+                }
+            }
+        }
+
+        return _Expected_niche::_None;
+    }
+
+    template <size_t _Size>
+    using _Unsigned_of_size = conditional_t<_Size == 1, uint8_t,
+        conditional_t<_Size == 2, uint16_t, conditional_t<_Size == 4, uint32_t, uint64_t>>>;
+
+    // Scalars are blended by a bit mask, which the optimizer cannot turn back into a branch.
+    template <class _Ty>
+    inline constexpr bool _Is_branchless_selectable =
+        is_scalar_v<_Ty> && (sizeof(_Ty) == 1 || sizeof(_Ty) == 2 || sizeof(_Ty) == 4 || sizeof(_Ty) == 8);
+
+    // Returns _Cond ? _Left : _Right without a branch. _Left may name the inactive member of a union: only its
+    // bytes are read, and they are discarded when !_Cond.
+    template <class _Ty>
+    _NODISCARD _Ty _Branchless_select(const bool _Cond, const _Ty& _Left, const _Ty& _Right) noexcept {
+        static_assert(is_trivially_copyable_v<_Ty>);
+        if constexpr (_Is_branchless_selectable<_Ty>) {
+            using _Bits = _Unsigned_of_size<sizeof(_Ty)>;
+            _Bits _Left_bits;
+            _Bits _Right_bits;
+            _CSTD memcpy(&_Left_bits, _STD addressof(_Left), sizeof(_Ty));
+            _CSTD memcpy(&_Right_bits, _STD addressof(_Right), sizeof(_Ty));
+            const auto _Mask = static_cast<_Bits>(0 - static_cast<_Bits>(_Cond));
+            return _STD bit_cast<_Ty>(static_cast<_Bits>((_Left_bits & _Mask) | (_Right_bits & ~_Mask)));
+        }
+        else {
+            // selecting the address compiles to a conditional move
+            const _Ty* const _Src = _Cond ? _STD addressof(_Left) : _STD addressof(_Right);
+            return *_Src;
+        }
+    }
+
+    template <class _Ty>
+    struct _Tail_padding_probe {
+        _MSVC_NO_UNIQUE_ADDRESS _Ty _Val;
+        bool _Byte;
+    };
+
+    // True when a bool following a potentially-overlapping _Ty is placed inside sizeof(_Ty)
+    template <class _Ty>
+    inline constexpr bool _Has_reusable_tail_padding = sizeof(_Tail_padding_probe<_Ty>) == sizeof(_Ty);
+
+    // Tail padding layout: when T and E both leave tail padding (as std::pair<int, char> does) or are smaller than
+    // the other alternative, both are made potentially-overlapping and the discriminant is placed after their data.
+    // Initializing a potentially-overlapping subobject cannot elide the move of a prvalue, so the layout is used only
+    // for move constructible types, and transform() then moves its result once. As for any such subobject, writing
+    // sizeof(T) bytes over *e with memcpy is undefined.
+    template <class _Ty, class _Err>
+    inline constexpr bool _Expected_flag_in_tail_padding =
+        is_move_constructible_v<_Ty> && is_move_constructible_v<_Err>
+        && (_Has_reusable_tail_padding<_Ty> || sizeof(_Ty) < sizeof(_Err))
+        && (_Has_reusable_tail_padding<_Err> || sizeof(_Err) < sizeof(_Ty));
+
+    template <class _Ty, class _Err, bool = _Expected_flag_in_tail_padding<_Ty, _Err>>
+    union _Expected_union {
+        constexpr _Expected_union() noexcept {}
+
+        template <class... _Args>
+        constexpr explicit _Expected_union(in_place_t, _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Ty, _Args...>)
+            : _Value(_STD forward<_Args>(_Vals)...) {}
+
+        template <class... _Args>
+        constexpr explicit _Expected_union(unexpect_t, _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Err, _Args...>)
+            : _Unexpected(_STD forward<_Args>(_Vals)...) {}
+
+        template <class _Fn, class... _Ux>
+        constexpr _Expected_union(_Construct_expected_from_invoke_result_tag, in_place_t, _Fn&& _Func, _Ux&&... _Arg)
+            noexcept(noexcept(static_cast<_Ty>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...))))
+            : _Value(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...)) {}
+
+        template <class _Fn, class... _Ux>
+        constexpr _Expected_union(_Construct_expected_from_invoke_result_tag, unexpect_t, _Fn&& _Func, _Ux&&... _Arg)
+            noexcept(noexcept(static_cast<_Err>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...))))
+            : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...)) {}
+
+        // clang-format off
+        _Expected_union(const _Expected_union&) = default;
+        _Expected_union(_Expected_union&&) = default;
+        _Expected_union& operator=(const _Expected_union&) = default;
+        _Expected_union& operator=(_Expected_union&&) = default;
+        // clang-format on
+
+        constexpr ~_Expected_union() {}
+
+        // clang-format off
+        ~_Expected_union() requires is_trivially_destructible_v<_Ty> && is_trivially_destructible_v<_Err> = default;
+        // clang-format on
+
+        _Ty _Value;
+        _Err _Unexpected;
+    };
+
+    template <class _Ty, class _Err>
+    union _Expected_union<_Ty, _Err, true> {
+        constexpr _Expected_union() noexcept {}
+
+        template <class... _Args>
+        constexpr explicit _Expected_union(in_place_t, _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Ty, _Args...>)
+            : _Value(_STD forward<_Args>(_Vals)...) {}
+
+        template <class... _Args>
+        constexpr explicit _Expected_union(unexpect_t, _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Err, _Args...>)
+            : _Unexpected(_STD forward<_Args>(_Vals)...) {}
+
+        template <class _Fn, class... _Ux>
+        constexpr _Expected_union(_Construct_expected_from_invoke_result_tag, in_place_t, _Fn&& _Func, _Ux&&... _Arg)
+            noexcept(noexcept(static_cast<_Ty>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...))))
+            : _Value(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...)) {}
+
+        template <class _Fn, class... _Ux>
+        constexpr _Expected_union(_Construct_expected_from_invoke_result_tag, unexpect_t, _Fn&& _Func, _Ux&&... _Arg)
+            noexcept(noexcept(static_cast<_Err>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...))))
+            : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)...)) {}
+
+        // clang-format off
+        _Expected_union(const _Expected_union&) = default;
+        _Expected_union(_Expected_union&&) = default;
+        _Expected_union& operator=(const _Expected_union&) = default;
+        _Expected_union& operator=(_Expected_union&&) = default;
+        // clang-format on
+
+        constexpr ~_Expected_union() {}
+
+        // clang-format off
+        ~_Expected_union() requires is_trivially_destructible_v<_Ty> && is_trivially_destructible_v<_Err> = default;
+        // clang-format on
+
+        _MSVC_NO_UNIQUE_ADDRESS _Ty _Value;
+        _MSVC_NO_UNIQUE_ADDRESS _Err _Unexpected;
+    };
+
+    // Mirrors the data members of expected<T, E> so that the tail padding layout can be checked in the class body
+    template <class _Ty, class _Err>
+    struct _Expected_tail_layout {
+        _MSVC_NO_UNIQUE_ADDRESS _Expected_union<_Ty, _Err> _Un;
+        bool _Has_value;
+    };
+
+    // When both alternatives can be copied or moved by copying their object representation, so can expected
+    template <class _Ty>
+    inline constexpr bool _Expected_trivially_copy_assignable = is_trivially_copy_constructible_v<_Ty>
+        && is_trivially_copy_assignable_v<_Ty> && is_trivially_destructible_v<_Ty>;
+
+    template <class _Ty>
+    inline constexpr bool _Expected_trivially_move_assignable = is_trivially_move_constructible_v<_Ty>
+        && is_trivially_move_assignable_v<_Ty> && is_trivially_destructible_v<_Ty>;
+
+    struct _Expected_batch; // defined in expected_batch.h
+
     _EXPORT_STD template <class _Ty, class _Err>
         class expected {
         static_assert(_Check_expected_argument<_Ty>::value);
@@ -194,6 +638,8 @@ namespace std::experimental {
         template <class _UTy, class _UErr>
         friend class expected;
 
+        friend _Expected_batch;
+
         public:
             using value_type = _Ty;
             using error_type = _Err;
@@ -205,19 +651,22 @@ namespace std::experimental {
             // [expected.object.cons]
             constexpr expected() noexcept(is_nothrow_default_constructible_v<_Ty>) // strengthened
                 requires is_default_constructible_v<_Ty>
-            : _Value(), _Has_value(true) {}
+            : _Un(in_place) {
+                _Set_has_value(true);
+            }
 
             constexpr expected(const expected& _Other) noexcept(
                 is_nothrow_copy_constructible_v<_Ty>&& is_nothrow_copy_constructible_v<_Err>) // strengthened
                 requires (!(is_trivially_copy_constructible_v<_Ty>&& is_trivially_copy_constructible_v<_Err>)
             && is_copy_constructible_v<_Ty>&& is_copy_constructible_v<_Err>)
-                : _Has_value(_Other._Has_value) {
-                if (_Has_value) {
-                    _STD construct_at(_STD addressof(_Value), _Other._Value);
+            {
+                if (_Other.has_value()) {
+                    _STD construct_at(_STD addressof(_Un._Value), _Other._Un._Value);
                 }
                 else {
-                    _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
+                    _STD construct_at(_STD addressof(_Un._Unexpected), _Other._Un._Unexpected);
                 }
+                _Set_has_value(_Other.has_value());
             }
 
             // clang-format off
@@ -229,13 +678,14 @@ namespace std::experimental {
                 is_nothrow_move_constructible_v<_Ty>&& is_nothrow_move_constructible_v<_Err>)
                 requires (!(is_trivially_move_constructible_v<_Ty>&& is_trivially_move_constructible_v<_Err>)
             && is_move_constructible_v<_Ty>&& is_move_constructible_v<_Err>)
-                : _Has_value(_Other._Has_value) {
-                if (_Has_value) {
-                    _STD construct_at(_STD addressof(_Value), _STD move(_Other._Value));
+            {
+                if (_Other.has_value()) {
+                    _STD construct_at(_STD addressof(_Un._Value), _STD move(_Other._Un._Value));
                 }
                 else {
-                    _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
+                    _STD construct_at(_STD addressof(_Un._Unexpected), _STD move(_Other._Un._Unexpected));
                 }
+                _Set_has_value(_Other.has_value());
             }
 
             // clang-format off
@@ -264,13 +714,14 @@ namespace std::experimental {
                 constexpr explicit(!is_convertible_v<const _Uty&, _Ty> || !is_convertible_v<const _UErr&, _Err>)
                 expected(const expected<_Uty, _UErr>& _Other) noexcept(is_nothrow_constructible_v<_Ty, const _Uty&> //
                     && is_nothrow_constructible_v<_Err, const _UErr&>) // strengthened
-                : _Has_value(_Other._Has_value) {
-                if (_Has_value) {
-                    _STD construct_at(_STD addressof(_Value), _Other._Value);
+            {
+                if (_Other.has_value()) {
+                    _STD construct_at(_STD addressof(_Un._Value), _Other._Un._Value);
                 }
                 else {
-                    _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
+                    _STD construct_at(_STD addressof(_Un._Unexpected), _Other._Un._Unexpected);
                 }
+                _Set_has_value(_Other.has_value());
             }
 
             template <class _Uty, class _UErr>
@@ -278,13 +729,14 @@ namespace std::experimental {
             constexpr explicit(!is_convertible_v<_Uty, _Ty> || !is_convertible_v<_UErr, _Err>)
                 expected(expected<_Uty, _UErr>&& _Other) noexcept(
                     is_nothrow_constructible_v<_Ty, _Uty>&& is_nothrow_constructible_v<_Err, _UErr>) // strengthened
-                : _Has_value(_Other._Has_value) {
-                if (_Has_value) {
-                    _STD construct_at(_STD addressof(_Value), _STD move(_Other._Value));
+            {
+                if (_Other.has_value()) {
+                    _STD construct_at(_STD addressof(_Un._Value), _STD move(_Other._Un._Value));
                 }
                 else {
-                    _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
+                    _STD construct_at(_STD addressof(_Un._Unexpected), _STD move(_Other._Un._Unexpected));
                 }
+                _Set_has_value(_Other.has_value());
             }
 
             template <class _Uty = _Ty>
@@ -294,43 +746,151 @@ namespace std::experimental {
                 && is_constructible_v<_Ty, _Uty>)
                 constexpr explicit(!is_convertible_v<_Uty, _Ty>)
                 expected(_Uty&& _Other) noexcept(is_nothrow_constructible_v<_Ty, _Uty>) // strengthened
-                : _Value(_STD forward<_Uty>(_Other)), _Has_value(true) {}
+                : _Un(in_place, _STD forward<_Uty>(_Other)) {
+                _Set_has_value(true);
+            }
 
             template <class _UErr>
                 requires is_constructible_v<_Err, const _UErr&>
             constexpr explicit(!is_convertible_v<const _UErr&, _Err>) expected(const unexpected<_UErr>& _Other) //
                 noexcept(is_nothrow_constructible_v<_Err, const _UErr&>) // strengthened
-                : _Unexpected(_Other._Unexpected), _Has_value(false) {}
+                : _Un(unexpect, _Other._Unexpected) {
+                _Set_has_value(false);
+                _EXPECTED_PROBE(expected_error, error());
+            }
 
             template <class _UErr>
                 requires is_constructible_v<_Err, _UErr>
             constexpr explicit(!is_convertible_v<_UErr, _Err>) expected(unexpected<_UErr>&& _Other) //
                 noexcept(is_nothrow_constructible_v<_Err, _UErr>) // strengthened
-                : _Unexpected(_STD move(_Other._Unexpected)), _Has_value(false) {}
+                : _Un(unexpect, _STD move(_Other._Unexpected)) {
+                _Set_has_value(false);
+                _EXPECTED_PROBE(expected_error, error());
+            }
 
             template <class... _Args>
                 requires is_constructible_v<_Ty, _Args...>
             constexpr explicit expected(in_place_t, _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Ty, _Args...>) // strengthened
-                : _Value(_STD forward<_Args>(_Vals)...), _Has_value(true) {}
+                : _Un(in_place, _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(true);
+            }
 
             template <class _Uty, class... _Args>
                 requires is_constructible_v<_Ty, initializer_list<_Uty>&, _Args...>
             constexpr explicit expected(in_place_t, initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Ty, initializer_list<_Uty>&, _Args...>) // strengthened
-                : _Value(_Ilist, _STD forward<_Args>(_Vals)...), _Has_value(true) {}
+                : _Un(in_place, _Ilist, _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(true);
+            }
 
             template <class... _Args>
                 requires is_constructible_v<_Err, _Args...>
-            constexpr explicit expected(unexpect_t, _Args&&... _Vals) noexcept(
+            constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Err, _Args...>) // strengthened
-                : _Unexpected(_STD forward<_Args>(_Vals)...), _Has_value(false) {}
+                : _Un(unexpect, _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(false);
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(expected_error, error());
+            }
 
             template <class _Uty, class... _Args>
                 requires is_constructible_v<_Err, initializer_list<_Uty>&, _Args...>
-            constexpr explicit expected(unexpect_t, initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
+            constexpr explicit expected(
+                _EXPECTED_SITE_PARAM(unexpect_t, _Site), initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
                 is_nothrow_constructible_v<_Err, initializer_list<_Uty>&, _Args...>) // strengthened
-                : _Unexpected(_Ilist, _STD forward<_Args>(_Vals)...), _Has_value(false) {}
+                : _Un(unexpect, _Ilist, _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(false);
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(expected_error, error());
+            }
+
+            // [expected.from] (extension)
+            template <class _Fn, class... _Args>
+                requires _Is_invoke_constructible_as<_Ty, _Fn, _Args...>
+            constexpr explicit expected(in_place_from_t, _Fn&& _Func, _Args&&... _Vals) noexcept(
+                _Is_nothrow_invoke_constructible_as<_Ty, _Fn, _Args...>)
+                : _Un(_Construct_expected_from_invoke_result_tag{}, in_place, _STD forward<_Fn>(_Func),
+                    _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(true);
+            }
+
+            template <class _Fn, class... _Args>
+                requires _Is_invoke_constructible_as<_Err, _Fn, _Args...>
+            constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_from_t, _Site), _Fn&& _Func, _Args&&... _Vals) noexcept(
+                _Is_nothrow_invoke_constructible_as<_Err, _Fn, _Args...>)
+                : _Un(_Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func),
+                    _STD forward<_Args>(_Vals)...) {
+                _Set_has_value(false);
+                _EXPECTED_RECORD_SITE(_Site);
+                _EXPECTED_PROBE(expected_error, error());
+            }
+
+            // [expected.alloc] (extension)
+            template <class _Alloc>
+                requires _Is_uses_allocator_constructible<_Ty, _Alloc>
+            constexpr expected(allocator_arg_t, const _Alloc& _Al)
+                : expected(in_place_from, _Make_obj_using_allocator_fn<_Ty>{}, _Al) {}
+
+            template <class _Alloc>
+                requires _Is_uses_allocator_constructible<_Ty, _Alloc, const _Ty&>
+            && _Is_uses_allocator_constructible<_Err, _Alloc, const _Err&>
+                constexpr expected(allocator_arg_t, const _Alloc& _Al, const expected& _Other) {
+                if (_Other.has_value()) {
+                    _STD uninitialized_construct_using_allocator(_STD addressof(_Un._Value), _Al, _Other._Un._Value);
+                }
+                else {
+                    _STD uninitialized_construct_using_allocator(
+                        _STD addressof(_Un._Unexpected), _Al, _Other._Un._Unexpected);
+                }
+                _Set_has_value(_Other.has_value());
+            }
+
+            template <class _Alloc>
+                requires _Is_uses_allocator_constructible<_Ty, _Alloc, _Ty>
+            && _Is_uses_allocator_constructible<_Err, _Alloc, _Err>
+                constexpr expected(allocator_arg_t, const _Alloc& _Al, expected&& _Other) {
+                if (_Other.has_value()) {
+                    _STD uninitialized_construct_using_allocator(
+                        _STD addressof(_Un._Value), _Al, _STD move(_Other._Un._Value));
+                }
+                else {
+                    _STD uninitialized_construct_using_allocator(
+                        _STD addressof(_Un._Unexpected), _Al, _STD move(_Other._Un._Unexpected));
+                }
+                _Set_has_value(_Other.has_value());
+            }
+
+            template <class _Alloc, class _Uty = _Ty>
+                requires (!is_same_v<remove_cvref_t<_Uty>, in_place_t> && !is_same_v<remove_cvref_t<_Uty>, unexpect_t>
+            && !is_same_v<remove_cvref_t<_Uty>, expected> && !_Is_specialization_v<remove_cvref_t<_Uty>, unexpected>
+                && (!is_same_v<remove_cv_t<_Ty>, bool> || !_Is_specialization_v<remove_cvref_t<_Uty>, expected>)
+                && _Is_uses_allocator_constructible<_Ty, _Alloc, _Uty>)
+                constexpr explicit(!is_convertible_v<_Uty, _Ty>)
+                expected(allocator_arg_t, const _Alloc& _Al, _Uty&& _Other)
+                : expected(in_place_from, _Make_obj_using_allocator_fn<_Ty>{}, _Al, _STD forward<_Uty>(_Other)) {}
+
+            template <class _Alloc, class _UErr>
+                requires _Is_uses_allocator_constructible<_Err, _Alloc, const _UErr&>
+            constexpr explicit(!is_convertible_v<const _UErr&, _Err>)
+                expected(allocator_arg_t, const _Alloc& _Al, const unexpected<_UErr>& _Other)
+                : expected(_EXPECTED_UNTRACKED(unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _Other._Unexpected) {}
+
+            template <class _Alloc, class _UErr>
+                requires _Is_uses_allocator_constructible<_Err, _Alloc, _UErr>
+            constexpr explicit(!is_convertible_v<_UErr, _Err>)
+                expected(allocator_arg_t, const _Alloc& _Al, unexpected<_UErr>&& _Other)
+                : expected(_EXPECTED_UNTRACKED(unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _STD move(_Other._Unexpected)) {}
+
+            template <class _Alloc, class... _Args>
+                requires _Is_uses_allocator_constructible<_Ty, _Alloc, _Args...>
+            constexpr explicit expected(allocator_arg_t, const _Alloc& _Al, in_place_t, _Args&&... _Vals)
+                : expected(in_place_from, _Make_obj_using_allocator_fn<_Ty>{}, _Al, _STD forward<_Args>(_Vals)...) {}
+
+            template <class _Alloc, class... _Args>
+                requires _Is_uses_allocator_constructible<_Err, _Alloc, _Args...>
+            constexpr explicit expected(allocator_arg_t, const _Alloc& _Al, _EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals)
+                : expected(_EXPECTED_PASS_SITE(_Site, unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _STD forward<_Args>(_Vals)...) {}
 
             // [expected.object.dtor]
             constexpr ~expected()
@@ -338,14 +898,14 @@ namespace std::experimental {
                 noexcept
 #endif // __clang__
             {
-                if (_Has_value) {
+                if (has_value()) {
                     if constexpr (!is_trivially_destructible_v<_Ty>) {
-                        _Value.~_Ty();
+                        _Un._Value.~_Ty();
                     }
                 }
                 else {
                     if constexpr (!is_trivially_destructible_v<_Err>) {
-                        _Unexpected.~_Err();
+                        _Un._Unexpected.~_Err();
                     }
                 }
             }
@@ -399,51 +959,63 @@ namespace std::experimental {
             constexpr expected& operator=(const expected& _Other) noexcept(
                 is_nothrow_copy_constructible_v<_Ty>&& is_nothrow_copy_constructible_v<_Err> //
                 && is_nothrow_copy_assignable_v<_Ty>&& is_nothrow_copy_assignable_v<_Err>) // strengthened
-                requires is_copy_assignable_v<_Ty>&& is_copy_constructible_v<_Ty> //
+                requires (!(_Expected_trivially_copy_assignable<_Ty>&& _Expected_trivially_copy_assignable<_Err>)
+            && is_copy_assignable_v<_Ty>&& is_copy_constructible_v<_Ty> //
             && is_copy_assignable_v<_Err>&& is_copy_constructible_v<_Err> //
-                && (is_nothrow_move_constructible_v<_Ty> || is_nothrow_move_constructible_v<_Err>)
+                && (is_nothrow_move_constructible_v<_Ty> || is_nothrow_move_constructible_v<_Err>))
             {
-                if (_Has_value && _Other._Has_value) {
-                    _Value = _Other._Value;
+                if (has_value() && _Other.has_value()) {
+                    _Un._Value = _Other._Un._Value;
                 }
-                else if (_Has_value) {
-                    _Reinit_expected(_Unexpected, _Value, _Other._Unexpected);
+                else if (has_value()) {
+                    _Reinit_expected(_Un._Unexpected, _Un._Value, _Other._Un._Unexpected);
                 }
-                else if (_Other._Has_value) {
-                    _Reinit_expected(_Value, _Unexpected, _Other._Value);
+                else if (_Other.has_value()) {
+                    _Reinit_expected(_Un._Value, _Un._Unexpected, _Other._Un._Value);
                 }
                 else {
-                    _Unexpected = _Other._Unexpected;
+                    _Un._Unexpected = _Other._Un._Unexpected;
                 }
 
-                _Has_value = _Other._Has_value;
+                _Set_has_value(_Other.has_value());
                 return *this;
             }
 
+            // clang-format off
+            expected& operator=(const expected&) requires
+                _Expected_trivially_copy_assignable<_Ty>&& _Expected_trivially_copy_assignable<_Err> = default;
+            // clang-format on
+
             constexpr expected& operator=(expected&& _Other) noexcept(
                 is_nothrow_move_constructible_v<_Ty>&& is_nothrow_move_constructible_v<_Err> //
                 && is_nothrow_move_assignable_v<_Ty>&& is_nothrow_move_assignable_v<_Err>) //
-                requires is_move_assignable_v<_Ty>&& is_move_constructible_v<_Ty> //
+                requires (!(_Expected_trivially_move_assignable<_Ty>&& _Expected_trivially_move_assignable<_Err>)
+            && is_move_assignable_v<_Ty>&& is_move_constructible_v<_Ty> //
             && is_move_assignable_v<_Err>&& is_move_constructible_v<_Err> //
-                && (is_nothrow_move_constructible_v<_Ty> || is_nothrow_move_constructible_v<_Err>)
+                && (is_nothrow_move_constructible_v<_Ty> || is_nothrow_move_constructible_v<_Err>))
             {
-                if (_Has_value && _Other._Has_value) {
-                    _Value = _STD move(_Other._Value);
+                if (has_value() && _Other.has_value()) {
+                    _Un._Value = _STD move(_Other._Un._Value);
                 }
-                else if (_Has_value) {
-                    _Reinit_expected(_Unexpected, _Value, _STD move(_Other._Unexpected));
+                else if (has_value()) {
+                    _Reinit_expected(_Un._Unexpected, _Un._Value, _STD move(_Other._Un._Unexpected));
                 }
-                else if (_Other._Has_value) {
-                    _Reinit_expected(_Value, _Unexpected, _STD move(_Other._Value));
+                else if (_Other.has_value()) {
+                    _Reinit_expected(_Un._Value, _Un._Unexpected, _STD move(_Other._Un._Value));
                 }
                 else {
-                    _Unexpected = _STD move(_Other._Unexpected);
+                    _Un._Unexpected = _STD move(_Other._Un._Unexpected);
                 }
 
-                _Has_value = _Other._Has_value;
+                _Set_has_value(_Other.has_value());
                 return *this;
             }
 
+            // clang-format off
+            expected& operator=(expected&&) requires
+                _Expected_trivially_move_assignable<_Ty>&& _Expected_trivially_move_assignable<_Err> = default;
+            // clang-format on
+
             template <class _Uty = _Ty>
                 requires (!is_same_v<remove_cvref_t<_Uty>, expected> && !_Is_specialization_v<remove_cvref_t<_Uty>, unexpected>
             && is_constructible_v<_Ty, _Uty>&& is_assignable_v<_Ty&, _Uty>
@@ -451,12 +1023,12 @@ namespace std::experimental {
                     || is_nothrow_move_constructible_v<_Err>))
                 constexpr expected& operator=(_Uty&& _Other) noexcept(
                     is_nothrow_constructible_v<_Ty, _Uty>&& is_nothrow_assignable_v<_Ty&, _Uty>) /* strengthened */ {
-                if (_Has_value) {
-                    _Value = _STD forward<_Uty>(_Other);
+                if (has_value()) {
+                    _Un._Value = _STD forward<_Uty>(_Other);
                 }
                 else {
-                    _Reinit_expected(_Value, _Unexpected, _STD forward<_Uty>(_Other));
-                    _Has_value = true;
+                    _Reinit_expected(_Un._Value, _Un._Unexpected, _STD forward<_Uty>(_Other));
+                    _Set_has_value(true);
                 }
 
                 return *this;
@@ -469,12 +1041,12 @@ namespace std::experimental {
                 constexpr expected& operator=(const unexpected<_UErr>& _Other) noexcept(
                     is_nothrow_constructible_v<_Err, const _UErr&>&&
                     is_nothrow_assignable_v<_Err&, const _UErr&>) /* strengthened */ {
-                if (_Has_value) {
-                    _Reinit_expected(_Unexpected, _Value, _Other._Unexpected);
-                    _Has_value = false;
+                if (has_value()) {
+                    _Reinit_expected(_Un._Unexpected, _Un._Value, _Other._Unexpected);
+                    _Set_has_value(false);
                 }
                 else {
-                    _Unexpected = _Other._Unexpected;
+                    _Un._Unexpected = _Other._Unexpected;
                 }
 
                 return *this;
@@ -486,12 +1058,12 @@ namespace std::experimental {
                 || is_nothrow_move_constructible_v<_Err>))
                 constexpr expected& operator=(unexpected<_UErr>&& _Other) noexcept(
                     is_nothrow_constructible_v<_Err, _UErr>&& is_nothrow_assignable_v<_Err&, _UErr>) /* strengthened */ {
-                if (_Has_value) {
-                    _Reinit_expected(_Unexpected, _Value, _STD move(_Other._Unexpected));
-                    _Has_value = false;
+                if (has_value()) {
+                    _Reinit_expected(_Un._Unexpected, _Un._Value, _STD move(_Other._Unexpected));
+                    _Set_has_value(false);
                 }
                 else {
-                    _Unexpected = _STD move(_Other._Unexpected);
+                    _Un._Unexpected = _STD move(_Other._Unexpected);
                 }
 
                 return *this;
@@ -500,37 +1072,73 @@ namespace std::experimental {
             template <class... _Args>
                 requires is_nothrow_constructible_v<_Ty, _Args...>
             constexpr _Ty& emplace(_Args&&... _Vals) noexcept {
-                if (_Has_value) {
+                if (has_value()) {
                     if constexpr (!is_trivially_destructible_v<_Ty>) {
-                        _Value.~_Ty();
+                        _Un._Value.~_Ty();
                     }
                 }
                 else {
                     if constexpr (!is_trivially_destructible_v<_Err>) {
-                        _Unexpected.~_Err();
+                        _Un._Unexpected.~_Err();
                     }
-                    _Has_value = true;
                 }
 
-                return *_STD construct_at(_STD addressof(_Value), _STD forward<_Args>(_Vals)...);
+                // after the construction, which may overwrite a discriminant in the tail padding of _Ty
+                _Ty& _Result = *_STD construct_at(_STD addressof(_Un._Value), _STD forward<_Args>(_Vals)...);
+                _Set_has_value(true);
+                return _Result;
             }
 
             template <class _Uty, class... _Args>
                 requires is_nothrow_constructible_v<_Ty, initializer_list<_Uty>&, _Args...>
             constexpr _Ty& emplace(initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept {
-                if (_Has_value) {
+                if (has_value()) {
                     if constexpr (!is_trivially_destructible_v<_Ty>) {
-                        _Value.~_Ty();
+                        _Un._Value.~_Ty();
                     }
                 }
                 else {
                     if constexpr (!is_trivially_destructible_v<_Err>) {
-                        _Unexpected.~_Err();
+                        _Un._Unexpected.~_Err();
                     }
-                    _Has_value = true;
                 }
 
-                return *_STD construct_at(_STD addressof(_Value), _Ilist, _STD forward<_Args>(_Vals)...);
+                // after the construction, which may overwrite a discriminant in the tail padding of _Ty
+                _Ty& _Result = *_STD construct_at(_STD addressof(_Un._Value), _Ilist, _STD forward<_Args>(_Vals)...);
+                _Set_has_value(true);
+                return _Result;
+            }
+
+            // [expected.from] (extension)
+            // Without a nothrow invocation the result is built in a temporary first and moved in, as assignment does,
+            // so that an exception leaves *this unchanged.
+            template <class _Fn, class... _Args>
+                requires _Is_invoke_constructible_as<_Ty, _Fn, _Args...>
+                      && (_Is_nothrow_invoke_constructible_as<_Ty, _Fn, _Args...> || is_nothrow_move_constructible_v<_Ty>)
+            constexpr _Ty& emplace_from(_Fn&& _Func, _Args&&... _Vals) noexcept(
+                _Is_nothrow_invoke_constructible_as<_Ty, _Fn, _Args...>) /* strengthened */ {
+                if constexpr (_Is_nothrow_invoke_constructible_as<_Ty, _Fn, _Args...>) {
+                    if (has_value()) {
+                        if constexpr (!is_trivially_destructible_v<_Ty>) {
+                            _Un._Value.~_Ty();
+                        }
+                    }
+                    else {
+                        if constexpr (!is_trivially_destructible_v<_Err>) {
+                            _Un._Unexpected.~_Err();
+                        }
+                    }
+
+                    // the union, not _Value, is constructed, so that the result initializes _Value directly
+                    _STD construct_at(_STD addressof(_Un), _Construct_expected_from_invoke_result_tag{}, in_place,
+                        _STD forward<_Fn>(_Func), _STD forward<_Args>(_Vals)...);
+                    _Set_has_value(true);
+                    return _Un._Value;
+                }
+                else {
+                    _Ty _Tmp(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Args>(_Vals)...));
+                    return emplace(_STD move(_Tmp));
+                }
             }
 
             // [expected.object.swap]
@@ -541,54 +1149,54 @@ namespace std::experimental {
                 && (is_nothrow_move_constructible_v<_Ty> || is_nothrow_move_constructible_v<_Err>)
             {
                 using _STD swap;
-                if (_Has_value && _Other._Has_value) {
-                    swap(_Value, _Other._Value); // intentional ADL
+                if (has_value() && _Other.has_value()) {
+                    swap(_Un._Value, _Other._Un._Value); // intentional ADL
                 }
-                else if (_Has_value) {
+                else if (has_value()) {
                     if constexpr (is_nothrow_move_constructible_v<_Err>) {
-                        _Err _Tmp(_STD move(_Other._Unexpected));
+                        _Err _Tmp(_STD move(_Other._Un._Unexpected));
                         if constexpr (!is_trivially_destructible_v<_Err>) {
-                            _Other._Unexpected.~_Err();
+                            _Other._Un._Unexpected.~_Err();
                         }
 
                         if constexpr (is_nothrow_move_constructible_v<_Ty>) {
-                            _STD construct_at(_STD addressof(_Other._Value), _STD move(_Value));
+                            _STD construct_at(_STD addressof(_Other._Un._Value), _STD move(_Un._Value));
                         }
                         else {
-                            _GuardTy<_Err> _Guard{ _STD addressof(_Other._Unexpected), _STD addressof(_Tmp) };
-                            _STD construct_at(_STD addressof(_Other._Value), _STD move(_Value));
+                            _GuardTy<_Err> _Guard{ _STD addressof(_Other._Un._Unexpected), _STD addressof(_Tmp) };
+                            _STD construct_at(_STD addressof(_Other._Un._Value), _STD move(_Un._Value));
                             _Guard._Target = nullptr;
                         }
 
                         if constexpr (!is_trivially_destructible_v<_Ty>) {
-                            _Value.~_Ty();
+                            _Un._Value.~_Ty();
                         }
-                        _STD construct_at(_STD addressof(_Unexpected), _STD move(_Tmp));
+                        _STD construct_at(_STD addressof(_Un._Unexpected), _STD move(_Tmp));
                     }
                     else {
-                        _Ty _Tmp(_STD move(_Value));
+                        _Ty _Tmp(_STD move(_Un._Value));
                         if constexpr (!is_trivially_destructible_v<_Ty>) {
-                            _Value.~_Ty();
+                            _Un._Value.~_Ty();
                         }
 
-                        _GuardTy<_Ty> _Guard{ _STD addressof(_Value), _STD addressof(_Tmp) };
-                        _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
+                        _GuardTy<_Ty> _Guard{ _STD addressof(_Un._Value), _STD addressof(_Tmp) };
+                        _STD construct_at(_STD addressof(_Un._Unexpected), _STD move(_Other._Un._Unexpected));
                         _Guard._Target = nullptr;
 
                         if constexpr (!is_trivially_destructible_v<_Err>) {
-                            _Other._Unexpected.~_Err();
+                            _Other._Un._Unexpected.~_Err();
                         }
-                        _STD construct_at(_STD addressof(_Other._Value), _STD move(_Tmp));
+                        _STD construct_at(_STD addressof(_Other._Un._Value), _STD move(_Tmp));
                     }
 
-                    _Has_value = false;
-                    _Other._Has_value = true;
+                    _Set_has_value(false);
+                    _Other._Set_has_value(true);
                 }
-                else if (_Other._Has_value) {
+                else if (_Other.has_value()) {
                     _Other.swap(*this);
                 }
                 else {
-                    swap(_Unexpected, _Other._Unexpected); // intentional ADL
+                    swap(_Un._Unexpected, _Other._Un._Unexpected); // intentional ADL
                 }
             }
 
@@ -604,73 +1212,81 @@ namespace std::experimental {
             // [expected.object.obs]
             _NODISCARD constexpr const _Ty* operator->() const noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD addressof(_Value);
+                return _STD addressof(_Un._Value);
             }
             _NODISCARD constexpr _Ty* operator->() noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD addressof(_Value);
+                return _STD addressof(_Un._Value);
             }
 
             _NODISCARD constexpr const _Ty& operator*() const& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _Value;
+                return _Un._Value;
             }
             _NODISCARD constexpr _Ty& operator*() & noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _Value;
+                return _Un._Value;
             }
             _NODISCARD constexpr const _Ty&& operator*() const&& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD move(_Value);
+                return _STD move(_Un._Value);
             }
             _NODISCARD constexpr _Ty&& operator*() && noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+                _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD move(_Value);
+                return _STD move(_Un._Value);
             }
 
             _NODISCARD constexpr explicit operator bool() const noexcept {
-                return _Has_value;
+                return has_value();
             }
             _NODISCARD constexpr bool has_value() const noexcept {
-                return _Has_value;
+                if constexpr (_Niche == _Expected_niche::_In_error) {
+                    return niche_traits<_Err>::is_niche(_STD addressof(_Un._Unexpected));
+                }
+                else if constexpr (_Niche == _Expected_niche::_In_value) {
+                    return !niche_traits<_Ty>::is_niche(_STD addressof(_Un._Value));
+                }
+                else {
+                    return _Has_value;
+                }
             }
 
             _NODISCARD constexpr const _Ty& value() const& {
-                if (_Has_value) {
-                    return _Value;
+                if (has_value()) [[likely]] {
+                    return _Un._Value;
                 }
 
                 _Throw_bad_expected_access_lv();
             }
             _NODISCARD constexpr _Ty& value()& {
-                if (_Has_value) {
-                    return _Value;
+                if (has_value()) [[likely]] {
+                    return _Un._Value;
                 }
 
                 _Throw_bad_expected_access_lv();
             }
             _NODISCARD constexpr const _Ty&& value() const&& {
-                if (_Has_value) {
-                    return _STD move(_Value);
+                if (has_value()) [[likely]] {
+                    return _STD move(_Un._Value);
                 }
 
                 _Throw_bad_expected_access_rv();
             }
             _NODISCARD constexpr _Ty&& value()&& {
-                if (_Has_value) {
-                    return _STD move(_Value);
+                if (has_value()) [[likely]] {
+                    return _STD move(_Un._Value);
                 }
 
                 _Throw_bad_expected_access_rv();
@@ -678,27 +1294,27 @@ namespace std::experimental {
 
             _NODISCARD constexpr const _Err& error() const& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+                _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _Unexpected;
+                return _Un._Unexpected;
             }
             _NODISCARD constexpr _Err& error() & noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+                _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _Unexpected;
+                return _Un._Unexpected;
             }
             _NODISCARD constexpr const _Err&& error() const&& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+                _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD move(_Unexpected);
+                return _STD move(_Un._Unexpected);
             }
             _NODISCARD constexpr _Err&& error() && noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-                _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+                _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
-                return _STD move(_Unexpected);
+                return _STD move(_Un._Unexpected);
             }
 
             template <class _Uty>
@@ -709,8 +1325,8 @@ namespace std::experimental {
                 static_assert(
                     is_convertible_v<_Uty, _Ty>, "is_convertible_v<U, T> must be true. (N4950 [expected.object.obs]/18)");
 
-                if (_Has_value) {
-                    return _Value;
+                if (has_value()) {
+                    return _Un._Value;
                 }
                 else {
                     return static_cast<_Ty>(_STD forward<_Uty>(_Other));
@@ -724,8 +1340,8 @@ namespace std::experimental {
                 static_assert(
                     is_convertible_v<_Uty, _Ty>, "is_convertible_v<U, T> must be true. (N4950 [expected.object.obs]/20)");
 
-                if (_Has_value) {
-                    return _STD move(_Value);
+                if (has_value()) {
+                    return _STD move(_Un._Value);
                 }
                 else {
                     return static_cast<_Ty>(_STD forward<_Uty>(_Other));
@@ -740,11 +1356,11 @@ namespace std::experimental {
                 static_assert(
                     is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.object.obs]/22)");
 
-                if (_Has_value) {
+                if (has_value()) {
                     return _STD forward<_Uty>(_Other);
                 }
                 else {
-                    return _Unexpected;
+                    return _Un._Unexpected;
                 }
             }
 
@@ -756,12 +1372,43 @@ namespace std::experimental {
                 static_assert(
                     is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.object.obs]/24)");
 
-                if (_Has_value) {
+                if (has_value()) {
                     return _STD forward<_Uty>(_Other);
                 }
                 else {
-                    return _STD move(_Unexpected);
+                    return _STD move(_Un._Unexpected);
+                }
+            }
+
+            // [expected.object.select] (extension)
+            // Like value_or and error_or, but the fallback is always converted and the result is chosen without
+            // branching on has_value(), which pays off when errors are frequent and unpredictable. The bytes of the
+            // inactive alternative are read and discarded, which Valgrind and MemorySanitizer report when that
+            // alternative was never initialized; value_or and error_or branch and never read it.
+            template <class _Uty>
+                requires is_trivially_copyable_v<_Ty>
+            _NODISCARD constexpr _Ty value_or_select(_Uty&& _Other) const noexcept(is_nothrow_convertible_v<_Uty, _Ty>) {
+                static_assert(is_convertible_v<_Uty, _Ty>, "value_or_select(U) requires U to be convertible to T.");
+
+                const _Ty _Fallback = static_cast<_Ty>(_STD forward<_Uty>(_Other));
+                if (_STD is_constant_evaluated()) {
+                    return has_value() ? _Un._Value : _Fallback;
+                }
+
+                return _Branchless_select(has_value(), _Un._Value, _Fallback);
+            }
+
+            template <class _Uty = _Err>
+                requires is_trivially_copyable_v<_Err>
+            _NODISCARD constexpr _Err error_or_select(_Uty&& _Other) const noexcept(is_nothrow_convertible_v<_Uty, _Err>) {
+                static_assert(is_convertible_v<_Uty, _Err>, "error_or_select(G) requires G to be convertible to E.");
+
+                const _Err _Fallback = static_cast<_Err>(_STD forward<_Uty>(_Other));
+                if (_STD is_constant_evaluated()) {
+                    return has_value() ? _Fallback : _Un._Unexpected;
                 }
+
+                return _Branchless_select(!has_value(), _Un._Unexpected, _Fallback);
             }
 
             // [expected.object.monadic]
@@ -777,11 +1424,11 @@ namespace std::experimental {
                     "expected<T, E>::and_then(F) requires the error type of the return type of F to be E. "
                     "(N4950 [expected.object.monadic]/3)");
 
-                if (_Has_value) {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _Value);
+                if (has_value()) [[likely]] {
+                    return _STD invoke(_STD forward<_Fn>(_Func), _Un._Value);
                 }
                 else {
-                    return _Uty{ unexpect, _Unexpected };
+                    return _Uty{ _EXPECTED_UNTRACKED(unexpect), _Un._Unexpected };
                 }
             }
 
@@ -797,11 +1444,11 @@ namespace std::experimental {
                     "expected<T, E>::and_then(F) requires the error type of the return type of F to be E. "
                     "(N4950 [expected.object.monadic]/3)");
 
-                if (_Has_value) {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _Value);
+                if (has_value()) [[likely]] {
+                    return _STD invoke(_STD forward<_Fn>(_Func), _Un._Value);
                 }
                 else {
-                    return _Uty{ unexpect, _Unexpected };
+                    return _Uty{ _EXPECTED_UNTRACKED(unexpect), _Un._Unexpected };
                 }
             }
 
@@ -817,11 +1464,11 @@ namespace std::experimental {
                     "expected<T, E>::and_then(F) requires the error type of the return type of F to be E. "
                     "(N4950 [expected.object.monadic]/7)");
 
-                if (_Has_value) {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Value));
+                if (has_value()) [[likely]] {
+                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Value));
                 }
                 else {
-                    return _Uty{ unexpect, _STD move(_Unexpected) };
+                    return _Uty{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Un._Unexpected) };
                 }
             }
 
@@ -837,11 +1484,11 @@ namespace std::experimental {
                     "expected<T, E>::and_then(F) requires the error type of the return type of F to be E. "
                     "(N4950 [expected.object.monadic]/7)");
 
-                if (_Has_value) {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Value));
+                if (has_value()) [[likely]] {
+                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Value));
                 }
                 else {
-                    return _Uty{ unexpect, _STD move(_Unexpected) };
+                    return _Uty{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Un._Unexpected) };
                 }
             }
 
@@ -857,11 +1504,11 @@ namespace std::experimental {
                     "expected<T, E>::or_else(F) requires the value type of the return type of F to be T. "
                     "(N4950 [expected.object.monadic]/11)");
 
-                if (_Has_value) {
-                    return _Uty{ in_place, _Value };
+                if (has_value()) [[likely]] {
+                    return _Uty{ in_place, _Un._Value };
                 }
                 else {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _Unexpected);
+                    return _STD invoke(_STD forward<_Fn>(_Func), _Un._Unexpected);
                 }
             }
 
@@ -877,11 +1524,11 @@ namespace std::experimental {
                     "expected<T, E>::or_else(F) requires the value type of the return type of F to be T. "
                     "(N4950 [expected.object.monadic]/11)");
 
-                if (_Has_value) {
-                    return _Uty{ in_place, _Value };
+                if (has_value()) [[likely]] {
+                    return _Uty{ in_place, _Un._Value };
                 }
                 else {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _Unexpected);
+                    return _STD invoke(_STD forward<_Fn>(_Func), _Un._Unexpected);
                 }
             }
 
@@ -897,11 +1544,11 @@ namespace std::experimental {
                     "expected<T, E>::or_else(F) requires the value type of the return type of F to be T. "
                     "(N4950 [expected.object.monadic]/15)");
 
-                if (_Has_value) {
-                    return _Uty{ in_place, _STD move(_Value) };
+                if (has_value()) [[likely]] {
+                    return _Uty{ in_place, _STD move(_Un._Value) };
                 }
                 else {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Unexpected));
+                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Unexpected));
                 }
             }
 
@@ -917,11 +1564,11 @@ namespace std::experimental {
                     "expected<T, E>::or_else(F) requires the value type of the return type of F to be T. "
                     "(N4950 [expected.object.monadic]/15)");
 
-                if (_Has_value) {
-                    return _Uty{ in_place, _STD move(_Value) };
+                if (has_value()) [[likely]] {
+                    return _Uty{ in_place, _STD move(_Un._Value) };
                 }
                 else {
-                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Unexpected));
+                    return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Unexpected));
                 }
             }
 
@@ -939,18 +1586,18 @@ namespace std::experimental {
                 }
                 static_assert(_Check_expected_argument<_Uty>::value);
 
-                if (_Has_value) {
+                if (has_value()) [[likely]] {
                     if constexpr (is_void_v<_Uty>) {
-                        _STD invoke(_STD forward<_Fn>(_Func), _Value);
+                        _STD invoke(_STD forward<_Fn>(_Func), _Un._Value);
                         return expected<_Uty, _Err>{};
                     }
                     else {
                         return expected<_Uty, _Err>{
-                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _Value};
+                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _Un._Value};
                     }
                 }
                 else {
-                    return expected<_Uty, _Err>{unexpect, _Unexpected};
+                    return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _Un._Unexpected};
                 }
             }
 
@@ -968,18 +1615,18 @@ namespace std::experimental {
                 }
                 static_assert(_Check_expected_argument<_Uty>::value);
 
-                if (_Has_value) {
+                if (has_value()) [[likely]] {
                     if constexpr (is_void_v<_Uty>) {
-                        _STD invoke(_STD forward<_Fn>(_Func), _Value);
+                        _STD invoke(_STD forward<_Fn>(_Func), _Un._Value);
                         return expected<_Uty, _Err>{};
                     }
                     else {
                         return expected<_Uty, _Err>{
-                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _Value};
+                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _Un._Value};
                     }
                 }
                 else {
-                    return expected<_Uty, _Err>{unexpect, _Unexpected};
+                    return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _Un._Unexpected};
                 }
             }
 
@@ -997,18 +1644,18 @@ namespace std::experimental {
                 }
                 static_assert(_Check_expected_argument<_Uty>::value);
 
-                if (_Has_value) {
+                if (has_value()) [[likely]] {
                     if constexpr (is_void_v<_Uty>) {
-                        _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Value));
+                        _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Value));
                         return expected<_Uty, _Err>{};
                     }
                     else {
                         return expected<_Uty, _Err>{
-                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _STD move(_Value)};
+                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _STD move(_Un._Value)};
                     }
                 }
                 else {
-                    return expected<_Uty, _Err>{unexpect, _STD move(_Unexpected)};
+                    return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Un._Unexpected)};
                 }
             }
 
@@ -1026,18 +1673,18 @@ namespace std::experimental {
                 }
                 static_assert(_Check_expected_argument<_Uty>::value);
 
-                if (_Has_value) {
+                if (has_value()) [[likely]] {
                     if constexpr (is_void_v<_Uty>) {
-                        _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Value));
+                        _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Un._Value));
                         return expected<_Uty, _Err>{};
                     }
                     else {
                         return expected<_Uty, _Err>{
-                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _STD move(_Value)};
+                            _Construct_expected_from_invoke_result_tag{}, _STD forward<_Fn>(_Func), _STD move(_Un._Value)};
                     }
                 }
                 else {
-                    return expected<_Uty, _Err>{unexpect, _STD move(_Unexpected)};
+                    return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Un._Unexpected)};
                 }
             }
 
@@ -1053,12 +1700,12 @@ namespace std::experimental {
 
                 static_assert(_Check_unexpected_argument<_Uty>::value);
 
-                if (_Has_value) {
-                    return expected<_Ty, _Uty>{in_place, _Value};
+                if (has_value()) [[likely]] {
+                    return expected<_Ty, _Uty>{in_place, _Un._Value};
                 }
                 else {
                     return expected<_Ty, _Uty>{
-                        _Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func), _Unexpected};
+                        _Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func), _Un._Unexpected};
                 }
             }
 
@@ -1075,12 +1722,12 @@ namespace std::experimental {
 
                 static_assert(_Check_unexpected_argument<_Uty>::value);
 
-                if (_Has_value) {
-                    return expected<_Ty, _Uty>{in_place, _Value};
+                if (has_value()) [[likely]] {
+                    return expected<_Ty, _Uty>{in_place, _Un._Value};
                 }
                 else {
                     return expected<_Ty, _Uty>{
-                        _Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func), _Unexpected};
+                        _Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func), _Un._Unexpected};
                 }
             }
 
@@ -1096,12 +1743,12 @@ namespace std::experimental {
 
                 static_assert(_Check_unexpected_argument<_Uty>::value);
 
-                if (_Has_value) {
-                    return expected<_Ty, _Uty>{in_place, _STD move(_Value)};
+                if (has_value()) [[likely]] {
+                    return expected<_Ty, _Uty>{in_place, _STD move(_Un._Value)};
                 }
                 else {
                     return expected<_Ty, _Uty>{_Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func),
-                        _STD move(_Unexpected)};
+                        _STD move(_Un._Unexpected)};
                 }
             }
 
@@ -1118,12 +1765,12 @@ namespace std::experimental {
 
                 static_assert(_Check_unexpected_argument<_Uty>::value);
 
-                if (_Has_value) {
-                    return expected<_Ty, _Uty>{in_place, _STD move(_Value)};
+                if (has_value()) [[likely]] {
+                    return expected<_Ty, _Uty>{in_place, _STD move(_Un._Value)};
                 }
                 else {
                     return expected<_Ty, _Uty>{_Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func),
-                        _STD move(_Unexpected)};
+                        _STD move(_Un._Unexpected)};
                 }
             }
 
@@ -1131,24 +1778,24 @@ namespace std::experimental {
             template <class _Uty, class _UErr>
                 requires (!is_void_v<_Uty>)
             _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const expected<_Uty, _UErr>& _Right) noexcept(
-                noexcept(_Fake_copy_init<bool>(_Left._Value == *_Right)) && noexcept(
-                    _Fake_copy_init<bool>(_Left._Unexpected == _Right.error()))) /* strengthened */ {
-                if (_Left._Has_value != _Right.has_value()) {
+                noexcept(_Fake_copy_init<bool>(_Left._Un._Value == *_Right)) && noexcept(
+                    _Fake_copy_init<bool>(_Left._Un._Unexpected == _Right.error()))) /* strengthened */ {
+                if (_Left.has_value() != _Right.has_value()) {
                     return false;
                 }
-                else if (_Left._Has_value) {
-                    return _Left._Value == *_Right;
+                else if (_Left.has_value()) {
+                    return _Left._Un._Value == *_Right;
                 }
                 else {
-                    return _Left._Unexpected == _Right.error();
+                    return _Left._Un._Unexpected == _Right.error();
                 }
             }
 
             template <class _Uty>
             _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const _Uty& _Right) noexcept(
-                noexcept(static_cast<bool>(_Left._Value == _Right))) /* strengthened */ {
-                if (_Left._Has_value) {
-                    return static_cast<bool>(_Left._Value == _Right);
+                noexcept(static_cast<bool>(_Left._Un._Value == _Right))) /* strengthened */ {
+                if (_Left.has_value()) {
+                    return static_cast<bool>(_Left._Un._Value == _Right);
                 }
                 else {
                     return false;
@@ -1157,12 +1804,12 @@ namespace std::experimental {
 
             template <class _UErr>
             _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const unexpected<_UErr>& _Right) noexcept(
-                noexcept(static_cast<bool>(_Left._Unexpected == _Right.error()))) /* strengthened */ {
-                if (_Left._Has_value) {
+                noexcept(static_cast<bool>(_Left._Un._Unexpected == _Right.error()))) /* strengthened */ {
+                if (_Left.has_value()) {
                     return false;
                 }
                 else {
-                    return static_cast<bool>(_Left._Unexpected == _Right.error());
+                    return static_cast<bool>(_Left._Un._Unexpected == _Right.error());
                 }
             }
 
@@ -1171,37 +1818,62 @@ namespace std::experimental {
             template <class _Fn, class _Ux>
             constexpr expected(_Construct_expected_from_invoke_result_tag, _Fn&& _Func, _Ux&& _Arg) noexcept(
                 noexcept(static_cast<_Ty>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)))))
-                : _Value(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg))), _Has_value{ true } {}
+                : _Un(_Construct_expected_from_invoke_result_tag{}, in_place, _STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)) {
+                _Set_has_value(true);
+            }
 
             // For when transform is called on an expected<void, E> and requires calling _Func with no arg
             template <class _Fn>
             constexpr expected(_Construct_expected_from_invoke_result_tag, _Fn&& _Func) noexcept(
                 noexcept(static_cast<_Ty>(_STD forward<_Fn>(_Func)()))) // f() is equivalent to invoke(f)
-                : _Value(_STD forward<_Fn>(_Func)()), _Has_value{ true } {} // f() is equivalent to invoke(f)
+                : _Un(_Construct_expected_from_invoke_result_tag{}, in_place, _STD forward<_Fn>(_Func)) {
+                _Set_has_value(true);
+            }
 
             template <class _Fn, class _Ux>
             constexpr expected(_Construct_expected_from_invoke_result_tag, unexpect_t, _Fn&& _Func, _Ux&& _Arg) noexcept(
                 noexcept(static_cast<_Err>(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)))))
-                : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg))), _Has_value{ false } {}
+                : _Un(_Construct_expected_from_invoke_result_tag{}, unexpect, _STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)) {
+                _Set_has_value(false);
+            }
 
             [[noreturn]] void _Throw_bad_expected_access_lv() const {
-                _THROW(bad_expected_access{ _Unexpected });
-            }
-            [[noreturn]] void _Throw_bad_expected_access_lv() {
-                _THROW(bad_expected_access{ _Unexpected });
+                _Throw_bad_expected_access(_Un._Unexpected);
             }
             [[noreturn]] void _Throw_bad_expected_access_rv() const {
-                _THROW(bad_expected_access{ _STD move(_Unexpected) });
+                // a const rvalue cannot be moved from
+                _Throw_bad_expected_access(_Un._Unexpected);
             }
             [[noreturn]] void _Throw_bad_expected_access_rv() {
-                _THROW(bad_expected_access{ _STD move(_Unexpected) });
+                _Throw_bad_expected_access_moved(_Un._Unexpected);
             }
 
-            union {
-                _Ty _Value;
-                _Err _Unexpected;
-            };
-            bool _Has_value;
+            // Must be called after the previous alternative has been destroyed and the new one constructed:
+            // constructing _Ty may overwrite its tail padding, where the discriminant can live.
+            constexpr void _Set_has_value(const bool _Val) noexcept {
+                if constexpr (_Niche == _Expected_niche::_In_error) {
+                    if (_Val) {
+                        niche_traits<_Err>::set_niche(_STD addressof(_Un._Unexpected));
+                    }
+                }
+                else if constexpr (_Niche == _Expected_niche::_In_value) {
+                    if (!_Val) {
+                        niche_traits<_Ty>::set_niche(_STD addressof(_Un._Value));
+                    }
+                }
+                else {
+                    _Has_value = _Val;
+                }
+            }
+
+            static constexpr _Expected_niche _Niche = _Select_expected_niche<_Ty, _Err>();
+
+            static_assert(!_Expected_flag_in_tail_padding<_Ty, _Err>
+                              || sizeof(_Expected_tail_layout<_Ty, _Err>) == sizeof(_Expected_union<_Ty, _Err>),
+                "When T and E leave tail padding, the discriminant must be stored in it.");
+
+            _MSVC_NO_UNIQUE_ADDRESS _Expected_union<_Ty, _Err> _Un;
+            _MSVC_NO_UNIQUE_ADDRESS conditional_t<_Niche == _Expected_niche::_None, bool, _Expected_niche_flag> _Has_value;
     };
 
     template <class _Ty, class _Err>
@@ -1221,14 +1893,17 @@ namespace std::experimental {
         using rebind = expected<_Uty, error_type>;
 
         // [expected.void.cons]
-        constexpr expected() noexcept : _Has_value(true) {}
+        constexpr expected() noexcept {
+            _Set_has_value(true);
+        }
 
         constexpr expected(const expected& _Other) noexcept(is_nothrow_copy_constructible_v<_Err>) // strengthened
             requires (!is_trivially_copy_constructible_v<_Err>&& is_copy_constructible_v<_Err>)
-        : _Has_value(_Other._Has_value) {
-            if (!_Has_value) {
+        {
+            if (!_Other.has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
             }
+            _Set_has_value(_Other.has_value());
         }
 
         // clang-format off
@@ -1237,10 +1912,11 @@ namespace std::experimental {
 
         constexpr expected(expected&& _Other) noexcept(is_nothrow_move_constructible_v<_Err>)
             requires (!is_trivially_move_constructible_v<_Err>&& is_move_constructible_v<_Err>)
-        : _Has_value(_Other._Has_value) {
-            if (!_Has_value) {
+        {
+            if (!_Other.has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
             }
+            _Set_has_value(_Other.has_value());
         }
 
         // clang-format off
@@ -1257,47 +1933,120 @@ namespace std::experimental {
             requires is_void_v<_Uty>&& is_constructible_v<_Err, const _UErr&>&& _Allow_unwrapping<_Uty, _UErr>
         constexpr explicit(!is_convertible_v<const _UErr&, _Err>) expected(const expected<_Uty, _UErr>& _Other) noexcept(
             is_nothrow_constructible_v<_Err, const _UErr&>) // strengthened
-            : _Has_value(_Other._Has_value) {
-            if (!_Has_value) {
+        {
+            if (!_Other.has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
             }
+            _Set_has_value(_Other.has_value());
         }
 
         template <class _Uty, class _UErr>
             requires is_void_v<_Uty>&& is_constructible_v<_Err, _UErr>&& _Allow_unwrapping<_Uty, _UErr>
         constexpr explicit(!is_convertible_v<_UErr, _Err>)
             expected(expected<_Uty, _UErr>&& _Other) noexcept(is_nothrow_constructible_v<_Err, _UErr>) // strengthened
-            : _Has_value(_Other._Has_value) {
-            if (!_Has_value) {
+        {
+            if (!_Other.has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
             }
+            _Set_has_value(_Other.has_value());
         }
 
         template <class _UErr>
             requires is_constructible_v<_Err, const _UErr&>
         constexpr explicit(!is_convertible_v<const _UErr&, _Err>) expected(const unexpected<_UErr>& _Other) //
             noexcept(is_nothrow_constructible_v<_Err, const _UErr&>) // strengthened
-            : _Unexpected(_Other._Unexpected), _Has_value(false) {}
+            : _Unexpected(_Other._Unexpected) {
+            _Set_has_value(false);
+            _EXPECTED_PROBE(expected_error, error());
+        }
 
         template <class _UErr>
             requires is_constructible_v<_Err, _UErr>
         constexpr explicit(!is_convertible_v<_UErr, _Err>) expected(unexpected<_UErr>&& _Other) //
             noexcept(is_nothrow_constructible_v<_Err, _UErr>) // strengthened
-            : _Unexpected(_STD move(_Other._Unexpected)), _Has_value(false) {}
+            : _Unexpected(_STD move(_Other._Unexpected)) {
+            _Set_has_value(false);
+            _EXPECTED_PROBE(expected_error, error());
+        }
 
-        constexpr explicit expected(in_place_t) noexcept : _Has_value(true) {}
+        constexpr explicit expected(in_place_t) noexcept {
+            _Set_has_value(true);
+        }
 
         template <class... _Args>
             requires is_constructible_v<_Err, _Args...>
-        constexpr explicit expected(unexpect_t, _Args&&... _Vals) noexcept(
+        constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals) noexcept(
             is_nothrow_constructible_v<_Err, _Args...>) // strengthened
-            : _Unexpected(_STD forward<_Args>(_Vals)...), _Has_value(false) {}
+            : _Unexpected(_STD forward<_Args>(_Vals)...) {
+            _Set_has_value(false);
+            _EXPECTED_RECORD_SITE(_Site);
+            _EXPECTED_PROBE(expected_error, error());
+        }
 
         template <class _Uty, class... _Args>
             requires is_constructible_v<_Err, initializer_list<_Uty>&, _Args...>
-        constexpr explicit expected(unexpect_t, initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
+        constexpr explicit expected(
+            _EXPECTED_SITE_PARAM(unexpect_t, _Site), initializer_list<_Uty> _Ilist, _Args&&... _Vals) noexcept(
             is_nothrow_constructible_v<_Err, initializer_list<_Uty>&, _Args...>) // strengthened
-            : _Unexpected(_Ilist, _STD forward<_Args>(_Vals)...), _Has_value(false) {}
+            : _Unexpected(_Ilist, _STD forward<_Args>(_Vals)...) {
+            _Set_has_value(false);
+            _EXPECTED_RECORD_SITE(_Site);
+            _EXPECTED_PROBE(expected_error, error());
+        }
+
+        // [expected.from] (extension)
+        template <class _Fn, class... _Args>
+            requires _Is_invoke_constructible_as<_Err, _Fn, _Args...>
+        constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_from_t, _Site), _Fn&& _Func, _Args&&... _Vals) noexcept(
+            _Is_nothrow_invoke_constructible_as<_Err, _Fn, _Args...>)
+            : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Args>(_Vals)...)) {
+            _Set_has_value(false);
+            _EXPECTED_RECORD_SITE(_Site);
+            _EXPECTED_PROBE(expected_error, error());
+        }
+
+        // [expected.alloc] (extension)
+        template <class _Alloc>
+        constexpr expected(allocator_arg_t, const _Alloc&) noexcept : expected() {}
+
+        template <class _Alloc>
+            requires _Is_uses_allocator_constructible<_Err, _Alloc, const _Err&>
+        constexpr expected(allocator_arg_t, const _Alloc& _Al, const expected& _Other) {
+            if (!_Other.has_value()) {
+                _STD uninitialized_construct_using_allocator(_STD addressof(_Unexpected), _Al, _Other._Unexpected);
+            }
+            _Set_has_value(_Other.has_value());
+        }
+
+        template <class _Alloc>
+            requires _Is_uses_allocator_constructible<_Err, _Alloc, _Err>
+        constexpr expected(allocator_arg_t, const _Alloc& _Al, expected&& _Other) {
+            if (!_Other.has_value()) {
+                _STD uninitialized_construct_using_allocator(
+                    _STD addressof(_Unexpected), _Al, _STD move(_Other._Unexpected));
+            }
+            _Set_has_value(_Other.has_value());
+        }
+
+        template <class _Alloc, class _UErr>
+            requires _Is_uses_allocator_constructible<_Err, _Alloc, const _UErr&>
+        constexpr explicit(!is_convertible_v<const _UErr&, _Err>)
+            expected(allocator_arg_t, const _Alloc& _Al, const unexpected<_UErr>& _Other)
+            : expected(_EXPECTED_UNTRACKED(unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _Other._Unexpected) {}
+
+        template <class _Alloc, class _UErr>
+            requires _Is_uses_allocator_constructible<_Err, _Alloc, _UErr>
+        constexpr explicit(!is_convertible_v<_UErr, _Err>)
+            expected(allocator_arg_t, const _Alloc& _Al, unexpected<_UErr>&& _Other)
+            : expected(_EXPECTED_UNTRACKED(unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _STD move(_Other._Unexpected)) {}
+
+        template <class _Alloc>
+        constexpr explicit expected(allocator_arg_t, const _Alloc&, in_place_t) noexcept : expected(in_place) {}
+
+        template <class _Alloc, class... _Args>
+            requires _Is_uses_allocator_constructible<_Err, _Alloc, _Args...>
+        constexpr explicit expected(allocator_arg_t, const _Alloc& _Al, _EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals)
+            : expected(_EXPECTED_PASS_SITE(_Site, unexpect_from), _Make_obj_using_allocator_fn<_Err>{}, _Al, _STD forward<_Args>(_Vals)...) {}
 
         // [expected.void.dtor]
         constexpr ~expected()
@@ -1305,7 +2054,7 @@ namespace std::experimental {
             noexcept
 #endif // __clang__
         {
-            if (!_Has_value) {
+            if (!has_value()) {
                 _Unexpected.~_Err();
             }
         }
@@ -1317,20 +2066,20 @@ namespace std::experimental {
         // [expected.void.assign]
         constexpr expected& operator=(const expected& _Other) noexcept(
             is_nothrow_copy_constructible_v<_Err>&& is_nothrow_copy_assignable_v<_Err>) // strengthened
-            requires is_copy_assignable_v<_Err>&& is_copy_constructible_v<_Err>
+            requires (!_Expected_trivially_copy_assignable<_Err>&& is_copy_assignable_v<_Err>&& is_copy_constructible_v<_Err>)
         {
-            if (_Has_value && _Other._Has_value) {
+            if (has_value() && _Other.has_value()) {
                 // nothing to do
             }
-            else if (_Has_value) {
+            else if (has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
-                _Has_value = false;
+                _Set_has_value(false);
             }
-            else if (_Other._Has_value) {
+            else if (_Other.has_value()) {
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Unexpected.~_Err();
                 }
-                _Has_value = true;
+                _Set_has_value(true);
             }
             else {
                 _Unexpected = _Other._Unexpected;
@@ -1339,22 +2088,26 @@ namespace std::experimental {
             return *this;
         }
 
+        // clang-format off
+        expected& operator=(const expected&) requires _Expected_trivially_copy_assignable<_Err> = default;
+        // clang-format on
+
         constexpr expected& operator=(expected&& _Other) noexcept(
             is_nothrow_move_constructible_v<_Err>&& is_nothrow_move_assignable_v<_Err>)
-            requires is_move_assignable_v<_Err>&& is_move_constructible_v<_Err>
+            requires (!_Expected_trivially_move_assignable<_Err>&& is_move_assignable_v<_Err>&& is_move_constructible_v<_Err>)
         {
-            if (_Has_value && _Other._Has_value) {
+            if (has_value() && _Other.has_value()) {
                 // nothing to do
             }
-            else if (_Has_value) {
+            else if (has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
-                _Has_value = false;
+                _Set_has_value(false);
             }
-            else if (_Other._Has_value) {
+            else if (_Other.has_value()) {
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Unexpected.~_Err();
                 }
-                _Has_value = true;
+                _Set_has_value(true);
             }
             else {
                 _Unexpected = _STD move(_Other._Unexpected);
@@ -1363,14 +2116,18 @@ namespace std::experimental {
             return *this;
         }
 
+        // clang-format off
+        expected& operator=(expected&&) requires _Expected_trivially_move_assignable<_Err> = default;
+        // clang-format on
+
         template <class _UErr>
             requires is_constructible_v<_Err, const _UErr&>&& is_assignable_v<_Err&, const _UErr&>
         constexpr expected& operator=(const unexpected<_UErr>& _Other) noexcept(
             is_nothrow_constructible_v<_Err, const _UErr&>&&
             is_nothrow_assignable_v<_Err&, const _UErr&>) /* strengthened */ {
-            if (_Has_value) {
+            if (has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _Other._Unexpected);
-                _Has_value = false;
+                _Set_has_value(false);
             }
             else {
                 _Unexpected = _Other._Unexpected;
@@ -1383,9 +2140,9 @@ namespace std::experimental {
             requires is_constructible_v<_Err, _UErr>&& is_assignable_v<_Err&, _UErr>
         constexpr expected& operator=(unexpected<_UErr>&& _Other) noexcept(
             is_nothrow_constructible_v<_Err, _UErr>&& is_nothrow_assignable_v<_Err&, _UErr>) /* strengthened */ {
-            if (_Has_value) {
+            if (has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
-                _Has_value = false;
+                _Set_has_value(false);
             }
             else {
                 _Unexpected = _STD move(_Other._Unexpected);
@@ -1395,11 +2152,11 @@ namespace std::experimental {
         }
 
         constexpr void emplace() noexcept {
-            if (!_Has_value) {
+            if (!has_value()) {
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Unexpected.~_Err();
                 }
-                _Has_value = true;
+                _Set_has_value(true);
             }
         }
 
@@ -1409,24 +2166,24 @@ namespace std::experimental {
             requires is_swappable_v<_Err>&& is_move_constructible_v<_Err>
         {
             using _STD swap;
-            if (_Has_value && _Other._Has_value) {
+            if (has_value() && _Other.has_value()) {
                 // nothing
             }
-            else if (_Has_value) {
+            else if (has_value()) {
                 _STD construct_at(_STD addressof(_Unexpected), _STD move(_Other._Unexpected));
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Other._Unexpected.~_Err();
                 }
-                _Has_value = false;
-                _Other._Has_value = true;
+                _Set_has_value(false);
+                _Other._Set_has_value(true);
             }
-            else if (_Other._Has_value) {
+            else if (_Other.has_value()) {
                 _STD construct_at(_STD addressof(_Other._Unexpected), _STD move(_Unexpected));
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Unexpected.~_Err();
                 }
-                _Has_value = true;
-                _Other._Has_value = false;
+                _Set_has_value(true);
+                _Other._Set_has_value(false);
             }
             else {
                 swap(_Unexpected, _Other._Unexpected); // intentional ADL
@@ -1438,24 +2195,24 @@ namespace std::experimental {
             requires is_swappable_v<_Err>&& is_move_constructible_v<_Err>
         {
             using _STD swap;
-            if (_Left._Has_value && _Right._Has_value) {
+            if (_Left.has_value() && _Right.has_value()) {
                 // nothing
             }
-            else if (_Left._Has_value) {
+            else if (_Left.has_value()) {
                 _STD construct_at(_STD addressof(_Left._Unexpected), _STD move(_Right._Unexpected));
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Right._Unexpected.~_Err();
                 }
-                _Left._Has_value = false;
-                _Right._Has_value = true;
+                _Left._Set_has_value(false);
+                _Right._Set_has_value(true);
             }
-            else if (_Right._Has_value) {
+            else if (_Right.has_value()) {
                 _STD construct_at(_STD addressof(_Right._Unexpected), _STD move(_Left._Unexpected));
                 if constexpr (!is_trivially_destructible_v<_Err>) {
                     _Left._Unexpected.~_Err();
                 }
-                _Left._Has_value = true;
-                _Right._Has_value = false;
+                _Left._Set_has_value(true);
+                _Right._Set_has_value(false);
             }
             else {
                 swap(_Left._Unexpected, _Right._Unexpected); // intentional ADL
@@ -1464,50 +2221,55 @@ namespace std::experimental {
 
         // [expected.void.obs]
         _NODISCARD constexpr explicit operator bool() const noexcept {
-            return _Has_value;
+            return has_value();
         }
         _NODISCARD constexpr bool has_value() const noexcept {
-            return _Has_value;
+            if constexpr (_Niche == _Expected_niche::_In_error) {
+                return niche_traits<_Err>::is_niche(_STD addressof(_Unexpected));
+            }
+            else {
+                return _Has_value;
+            }
         }
 
         constexpr void operator*() const noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-            _STL_VERIFY(_Has_value, "expected stores an error, not a value");
+            _STL_VERIFY(has_value(), "expected stores an error, not a value");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
         }
 
         constexpr void value() const& {
-            if (!_Has_value) {
+            if (!has_value()) [[unlikely]] {
                 _Throw_bad_expected_access_lv();
             }
         }
         constexpr void value()&& {
-            if (!_Has_value) {
+            if (!has_value()) [[unlikely]] {
                 _Throw_bad_expected_access_rv();
             }
         }
 
         _NODISCARD constexpr const _Err& error() const& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-            _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
             return _Unexpected;
         }
         _NODISCARD constexpr _Err& error() & noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-            _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
             return _Unexpected;
         }
         _NODISCARD constexpr const _Err&& error() const&& noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-            _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
             return _STD move(_Unexpected);
         }
         _NODISCARD constexpr _Err&& error() && noexcept {
 #if _CONTAINER_DEBUG_LEVEL > 0
-            _STL_VERIFY(!_Has_value, "expected stores a value, not an error");
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
 #endif // _CONTAINER_DEBUG_LEVEL > 0
             return _STD move(_Unexpected);
         }
@@ -1520,7 +2282,7 @@ namespace std::experimental {
             static_assert(
                 is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.void.obs]/9)");
 
-            if (_Has_value) {
+            if (has_value()) {
                 return _STD forward<_Uty>(_Other);
             }
             else {
@@ -1536,7 +2298,7 @@ namespace std::experimental {
             static_assert(
                 is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.void.obs]/11)");
 
-            if (_Has_value) {
+            if (has_value()) {
                 return _STD forward<_Uty>(_Other);
             }
             else {
@@ -1544,6 +2306,20 @@ namespace std::experimental {
             }
         }
 
+        // [expected.void.select] (extension)
+        template <class _Uty = _Err>
+            requires is_trivially_copyable_v<_Err>
+        _NODISCARD constexpr _Err error_or_select(_Uty&& _Other) const noexcept(is_nothrow_convertible_v<_Uty, _Err>) {
+            static_assert(is_convertible_v<_Uty, _Err>, "error_or_select(G) requires G to be convertible to E.");
+
+            const _Err _Fallback = static_cast<_Err>(_STD forward<_Uty>(_Other));
+            if (_STD is_constant_evaluated()) {
+                return has_value() ? _Fallback : _Unexpected;
+            }
+
+            return _Branchless_select(!has_value(), _Unexpected, _Fallback);
+        }
+
         // [expected.void.monadic]
         template <class _Fn>
             requires is_constructible_v<_Err, _Err&>
@@ -1557,11 +2333,11 @@ namespace std::experimental {
                 "expected<void, E>::and_then(F) requires the error type of the return type of F to be E. "
                 "(N4950 [expected.void.monadic]/3)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
             }
             else {
-                return _Uty{ unexpect, _Unexpected };
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _Unexpected };
             }
         }
 
@@ -1577,11 +2353,11 @@ namespace std::experimental {
                 "expected<void, E>::and_then(F) requires the error type of the return type of F to be E. "
                 "(N4950 [expected.void.monadic]/3)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
             }
             else {
-                return _Uty{ unexpect, _Unexpected };
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _Unexpected };
             }
         }
 
@@ -1597,11 +2373,11 @@ namespace std::experimental {
                 "expected<void, E>::and_then(F) requires the error type of the return type of F to be E. "
                 "(N4950 [expected.void.monadic]/7)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
             }
             else {
-                return _Uty{ unexpect, _STD move(_Unexpected) };
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Unexpected) };
             }
         }
 
@@ -1617,11 +2393,11 @@ namespace std::experimental {
                 "expected<void, E>::and_then(F) requires the error type of the return type of F to be E. "
                 "(N4950 [expected.void.monadic]/7)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
             }
             else {
-                return _Uty{ unexpect, _STD move(_Unexpected) };
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Unexpected) };
             }
         }
 
@@ -1636,7 +2412,7 @@ namespace std::experimental {
                 "expected<void, E>::or_else(F) requires the value type of the return type of F to be T. "
                 "(N4950 [expected.void.monadic]/10)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _Uty{};
             }
             else {
@@ -1655,7 +2431,7 @@ namespace std::experimental {
                 "expected<void, E>::or_else(F) requires the value type of the return type of F to be T. "
                 "(N4950 [expected.void.monadic]/10)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _Uty{};
             }
             else {
@@ -1674,7 +2450,7 @@ namespace std::experimental {
                 "expected<void, E>::or_else(F) requires the value type of the return type of F to be T. "
                 "(N4950 [expected.void.monadic]/13)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _Uty{};
             }
             else {
@@ -1693,7 +2469,7 @@ namespace std::experimental {
                 "expected<void, E>::or_else(F) requires the value type of the return type of F to be T. "
                 "(N4950 [expected.void.monadic]/13)");
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return _Uty{};
             }
             else {
@@ -1715,7 +2491,7 @@ namespace std::experimental {
             }
             static_assert(_Check_expected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 if constexpr (is_void_v<_Uty>) {
                     _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
                     return expected<_Uty, _Err>{};
@@ -1725,7 +2501,7 @@ namespace std::experimental {
                 }
             }
             else {
-                return expected<_Uty, _Err>{unexpect, _Unexpected};
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _Unexpected};
             }
         }
 
@@ -1743,7 +2519,7 @@ namespace std::experimental {
             }
             static_assert(_Check_expected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 if constexpr (is_void_v<_Uty>) {
                     _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
                     return expected<_Uty, _Err>{};
@@ -1753,7 +2529,7 @@ namespace std::experimental {
                 }
             }
             else {
-                return expected<_Uty, _Err>{unexpect, _Unexpected};
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _Unexpected};
             }
         }
 
@@ -1771,7 +2547,7 @@ namespace std::experimental {
             }
             static_assert(_Check_expected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 if constexpr (is_void_v<_Uty>) {
                     _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
                     return expected<_Uty, _Err>{};
@@ -1781,7 +2557,7 @@ namespace std::experimental {
                 }
             }
             else {
-                return expected<_Uty, _Err>{unexpect, _STD move(_Unexpected)};
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Unexpected)};
             }
         }
 
@@ -1799,7 +2575,7 @@ namespace std::experimental {
             }
             static_assert(_Check_expected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 if constexpr (is_void_v<_Uty>) {
                     _STD forward<_Fn>(_Func)(); // f() is equivalent to invoke(f)
                     return expected<_Uty, _Err>{};
@@ -1809,7 +2585,7 @@ namespace std::experimental {
                 }
             }
             else {
-                return expected<_Uty, _Err>{unexpect, _STD move(_Unexpected)};
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Unexpected)};
             }
         }
 
@@ -1825,7 +2601,7 @@ namespace std::experimental {
 
             static_assert(_Check_unexpected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return expected<_Ty, _Uty>{};
             }
             else {
@@ -1847,7 +2623,7 @@ namespace std::experimental {
 
             static_assert(_Check_unexpected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return expected<_Ty, _Uty>{};
             }
             else {
@@ -1868,7 +2644,7 @@ namespace std::experimental {
 
             static_assert(_Check_unexpected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return expected<_Ty, _Uty>{};
             }
             else {
@@ -1890,7 +2666,7 @@ namespace std::experimental {
 
             static_assert(_Check_unexpected_argument<_Uty>::value);
 
-            if (_Has_value) {
+            if (has_value()) [[likely]] {
                 return expected<_Ty, _Uty>{};
             }
             else {
@@ -1904,18 +2680,18 @@ namespace std::experimental {
             requires is_void_v<_Uty>
         _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const expected<_Uty, _UErr>& _Right) noexcept(
             noexcept(static_cast<bool>(_Left._Unexpected == _Right.error()))) /* strengthened */ {
-            if (_Left._Has_value != _Right.has_value()) {
+            if (_Left.has_value() != _Right.has_value()) {
                 return false;
             }
             else {
-                return _Left._Has_value || static_cast<bool>(_Left._Unexpected == _Right.error());
+                return _Left.has_value() || static_cast<bool>(_Left._Unexpected == _Right.error());
             }
         }
 
         template <class _UErr>
         _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const unexpected<_UErr>& _Right) noexcept(
             noexcept(static_cast<bool>(_Left._Unexpected == _Right.error()))) /* strengthened */ {
-            if (_Left._Has_value) {
+            if (_Left.has_value()) {
                 return false;
             }
             else {
@@ -1927,27 +2703,523 @@ namespace std::experimental {
         template <class _Fn, class _Ux>
         constexpr expected(_Construct_expected_from_invoke_result_tag, unexpect_t, _Fn&& _Func, _Ux&& _Arg) noexcept(
             noexcept(_Err(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg)))))
-            : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg))), _Has_value{ false } {}
+            : _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Ux>(_Arg))) {
+            _Set_has_value(false);
+        }
 
         [[noreturn]] void _Throw_bad_expected_access_lv() const {
-            _THROW(bad_expected_access{ _Unexpected });
+            _Throw_bad_expected_access(_Unexpected);
         }
         [[noreturn]] void _Throw_bad_expected_access_rv() {
-            _THROW(bad_expected_access{ _STD move(_Unexpected) });
+            _Throw_bad_expected_access_moved(_Unexpected);
+        }
+
+        // Must be called after _Unexpected has been destroyed when becoming engaged
+        constexpr void _Set_has_value(const bool _Val) noexcept {
+            if constexpr (_Niche == _Expected_niche::_In_error) {
+                if (_Val) {
+                    niche_traits<_Err>::set_niche(_STD addressof(_Unexpected));
+                }
+            }
+            else {
+                _Has_value = _Val;
+            }
         }
 
+        static constexpr _Expected_niche _Niche = _Select_expected_niche<_Ty, _Err>();
+
         union {
             _Err _Unexpected;
         };
-        bool _Has_value;
+        _MSVC_NO_UNIQUE_ADDRESS conditional_t<_Niche == _Expected_niche::_None, bool, _Expected_niche_flag> _Has_value;
     };
 
+    // [expected.ref] (extension)
+    // expected<T&, E> refers to a T owned elsewhere, such as a record found by a lookup, instead of holding a copy.
+    // It stores a T* where expected<T, E> stores a T, so it is laid out as expected<T*, E> and uses the same niches
+    // (with niche_traits<error_code> specialized, expected<T&, error_code> is the size of an error_code); when E is
+    // an empty type the null pointer stands for the error, and the whole object is the size of a pointer.
+    // Like a reference member it binds on construction and is rebound by assignment and emplace(), and it binds
+    // only to lvalues; it is const-shallow, so *e is a T& even when e is const. value_or(fallback) also returns a
+    // reference, and transform(f) returns expected<U&, E> when f returns an lvalue reference U&.
+    template <class _Err>
+    inline constexpr bool _Expected_ref_null_niche =
+        is_empty_v<_Err> && is_trivially_copyable_v<_Err> && is_trivially_default_constructible_v<_Err>;
+
+    // Storage of expected<T&, E> for an empty E: the pointer is null exactly when the error is held, and the error
+    // object, having no state, is never constructed or destroyed separately from the storage.
+    template <class _Ty, class _Err>
+    class _Expected_null_ref_storage {
+    public:
+        constexpr explicit _Expected_null_ref_storage(in_place_t, _Ty* const _Ptr_) noexcept : _Ptr(_Ptr_) {}
+
+        template <class... _Args>
+        constexpr explicit _Expected_null_ref_storage(_EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Err, _Args...>)
+            : _Ptr(nullptr), _Unexpected(_STD forward<_Args>(_Vals)...) {
+            _EXPECTED_RECORD_SITE(_Site);
+            _EXPECTED_PROBE(expected_error, _Unexpected);
+        }
+
+        template <class _Fn, class... _Args>
+        constexpr explicit _Expected_null_ref_storage(
+            _EXPECTED_SITE_PARAM(unexpect_from_t, _Site), _Fn&& _Func, _Args&&... _Vals) noexcept(
+            _Is_nothrow_invoke_constructible_as<_Err, _Fn, _Args...>)
+            : _Ptr(nullptr), _Unexpected(_STD invoke(_STD forward<_Fn>(_Func), _STD forward<_Args>(_Vals)...)) {
+            _EXPECTED_RECORD_SITE(_Site);
+            _EXPECTED_PROBE(expected_error, _Unexpected);
+        }
+
+        template <class _UErr>
+        constexpr _Expected_null_ref_storage& operator=(const unexpected<_UErr>& _Other) noexcept(
+            is_nothrow_assignable_v<_Err&, const _UErr&>) {
+            _Unexpected = _Other.error();
+            _Ptr        = nullptr;
+            return *this;
+        }
+
+        template <class _UErr>
+        constexpr _Expected_null_ref_storage& operator=(unexpected<_UErr>&& _Other) noexcept(
+            is_nothrow_assignable_v<_Err&, _UErr>) {
+            _Unexpected = _STD move(_Other.error());
+            _Ptr        = nullptr;
+            return *this;
+        }
+
+        constexpr void emplace(_Ty* const _Ptr_) noexcept {
+            _Ptr = _Ptr_;
+        }
+
+        constexpr void swap(_Expected_null_ref_storage& _Other) noexcept {
+            _STD swap(_Ptr, _Other._Ptr);
+        }
+
+        _NODISCARD constexpr bool has_value() const noexcept {
+            return _Ptr != nullptr;
+        }
+
+        _NODISCARD constexpr _Ty* operator*() const noexcept {
+            return _Ptr;
+        }
+
+        _NODISCARD constexpr const _Err& error() const& noexcept {
+            return _Unexpected;
+        }
+        _NODISCARD constexpr _Err& error() & noexcept {
+            return _Unexpected;
+        }
+        _NODISCARD constexpr const _Err&& error() const&& noexcept {
+            return _STD move(_Unexpected);
+        }
+        _NODISCARD constexpr _Err&& error() && noexcept {
+            return _STD move(_Unexpected);
+        }
+
+    private:
+        _Ty* _Ptr;
+        _MSVC_NO_UNIQUE_ADDRESS _Err _Unexpected;
+    };
+
+    template <class _Ty, class _Err>
+    class expected<_Ty&, _Err> {
+        static_assert(is_object_v<_Ty>, "expected<T&, E> requires T to be an object type.");
+        static_assert(_Check_unexpected_argument<_Err>::value);
+
+        template <class _UTy, class _UErr>
+        friend class expected;
+
+        using _Storage = conditional_t<_Expected_ref_null_niche<_Err>, _Expected_null_ref_storage<_Ty, _Err>,
+            expected<_Ty*, _Err>>;
+
+    public:
+        using value_type = _Ty&;
+        using error_type = _Err;
+        using unexpected_type = unexpected<_Err>;
+
+        template <class _Uty>
+        using rebind = expected<_Uty, error_type>;
+
+        // [expected.ref.cons]
+        template <class _Uty>
+            requires (!_Is_specialization_v<remove_cv_t<_Uty>, expected>
+                && !_Is_specialization_v<remove_cv_t<_Uty>, unexpected> && is_convertible_v<_Uty&, _Ty&>)
+        constexpr expected(_Uty& _Ref) noexcept : _Store(in_place, _STD addressof(static_cast<_Ty&>(_Ref))) {}
+
+        template <class _Uty>
+            requires is_convertible_v<_Uty&, _Ty&>
+        constexpr explicit expected(in_place_t, _Uty& _Ref) noexcept
+            : _Store(in_place, _STD addressof(static_cast<_Ty&>(_Ref))) {}
+
+        template <class _UErr>
+            requires is_constructible_v<_Err, const _UErr&>
+        constexpr explicit(!is_convertible_v<const _UErr&, _Err>) expected(const unexpected<_UErr>& _Other) //
+            noexcept(is_nothrow_constructible_v<_Err, const _UErr&>) // strengthened
+            : _Store(_EXPECTED_UNTRACKED(unexpect), _Other.error()) {}
+
+        template <class _UErr>
+            requires is_constructible_v<_Err, _UErr>
+        constexpr explicit(!is_convertible_v<_UErr, _Err>) expected(unexpected<_UErr>&& _Other) //
+            noexcept(is_nothrow_constructible_v<_Err, _UErr>) // strengthened
+            : _Store(_EXPECTED_UNTRACKED(unexpect), _STD move(_Other.error())) {}
+
+        template <class... _Args>
+            requires is_constructible_v<_Err, _Args...>
+        constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_t, _Site), _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Err, _Args...>) // strengthened
+            : _Store(_EXPECTED_PASS_SITE(_Site, unexpect), _STD forward<_Args>(_Vals)...) {}
+
+        template <class _Fn, class... _Args>
+            requires _Is_invoke_constructible_as<_Err, _Fn, _Args...>
+        constexpr explicit expected(_EXPECTED_SITE_PARAM(unexpect_from_t, _Site), _Fn&& _Func, _Args&&... _Vals) noexcept(
+            _Is_nothrow_invoke_constructible_as<_Err, _Fn, _Args...>)
+            : _Store(_EXPECTED_PASS_SITE(_Site, unexpect_from), _STD forward<_Fn>(_Func), _STD forward<_Args>(_Vals)...) {}
+
+        // [expected.ref.assign]
+        template <class _UErr>
+            requires is_constructible_v<_Err, const _UErr&> && is_assignable_v<_Err&, const _UErr&>
+        constexpr expected& operator=(const unexpected<_UErr>& _Other) noexcept(
+            is_nothrow_constructible_v<_Err, const _UErr&>&& is_nothrow_assignable_v<_Err&, const _UErr&>) /* strengthened */ {
+            _Store = _Other;
+            return *this;
+        }
+
+        template <class _UErr>
+            requires is_constructible_v<_Err, _UErr> && is_assignable_v<_Err&, _UErr>
+        constexpr expected& operator=(unexpected<_UErr>&& _Other) noexcept(
+            is_nothrow_constructible_v<_Err, _UErr>&& is_nothrow_assignable_v<_Err&, _UErr>) /* strengthened */ {
+            _Store = _STD move(_Other);
+            return *this;
+        }
+
+        // rebinds to _Ref
+        template <class _Uty>
+            requires is_convertible_v<_Uty&, _Ty&>
+        constexpr _Ty& emplace(_Uty& _Ref) noexcept {
+            _Ty& _Target = _Ref;
+            _Store.emplace(_STD addressof(_Target));
+            return _Target;
+        }
+
+        // [expected.ref.swap]
+        constexpr void swap(expected& _Other) noexcept(noexcept(_Store.swap(_Other._Store))) {
+            _Store.swap(_Other._Store);
+        }
+
+        friend constexpr void swap(expected& _Left, expected& _Right) noexcept(noexcept(_Left.swap(_Right))) {
+            _Left.swap(_Right);
+        }
+
+        // [expected.ref.obs]
+        _NODISCARD constexpr _Ty* operator->() const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(has_value(), "expected stores an error, not a value");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return *_Store;
+        }
+
+        _NODISCARD constexpr _Ty& operator*() const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(has_value(), "expected stores an error, not a value");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return **_Store;
+        }
+
+        _NODISCARD constexpr explicit operator bool() const noexcept {
+            return has_value();
+        }
+        _NODISCARD constexpr bool has_value() const noexcept {
+            return _Store.has_value();
+        }
+
+        _NODISCARD constexpr _Ty& value() const& {
+            if (has_value()) [[likely]] {
+                return **_Store;
+            }
+
+            _Throw_bad_expected_access(_Store.error());
+        }
+        _NODISCARD constexpr _Ty& value() && {
+            if (has_value()) [[likely]] {
+                return **_Store;
+            }
+
+            _Throw_bad_expected_access_moved(_Store.error());
+        }
+
+        _NODISCARD constexpr const _Err& error() const& noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return _Store.error();
+        }
+        _NODISCARD constexpr _Err& error() & noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return _Store.error();
+        }
+        _NODISCARD constexpr const _Err&& error() const&& noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return _STD move(_Store).error();
+        }
+        _NODISCARD constexpr _Err&& error() && noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+            _STL_VERIFY(!has_value(), "expected stores a value, not an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+            return _STD move(_Store).error();
+        }
+
+        // Returns a reference to the value or to _Other; selecting between the two addresses compiles to a
+        // conditional move. A temporary fallback would dangle, so rvalues are rejected.
+        _NODISCARD constexpr _Ty& value_or(_Ty& _Other) const noexcept {
+            return *(has_value() ? *_Store : _STD addressof(_Other));
+        }
+        void value_or(remove_cv_t<_Ty>&&) const = delete;
+        void value_or(const remove_cv_t<_Ty>&&) const = delete;
+
+        template <class _Uty = _Err>
+        _NODISCARD constexpr _Err error_or(_Uty&& _Other) const& noexcept(
+            is_nothrow_copy_constructible_v<_Err>&& is_nothrow_convertible_v<_Uty, _Err>) /* strengthened */ {
+            static_assert(
+                is_copy_constructible_v<_Err>, "is_copy_constructible_v<E> must be true. (N4950 [expected.object.obs]/22)");
+            static_assert(
+                is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.object.obs]/22)");
+
+            if (has_value()) {
+                return _STD forward<_Uty>(_Other);
+            }
+            else {
+                return _Store.error();
+            }
+        }
+
+        template <class _Uty = _Err>
+        _NODISCARD constexpr _Err error_or(_Uty&& _Other) && noexcept(
+            is_nothrow_move_constructible_v<_Err>&& is_nothrow_convertible_v<_Uty, _Err>) /* strengthened */ {
+            static_assert(
+                is_move_constructible_v<_Err>, "is_move_constructible_v<E> must be true. (N4950 [expected.object.obs]/24)");
+            static_assert(
+                is_convertible_v<_Uty, _Err>, "is_convertible_v<G, E> must be true. (N4950 [expected.object.obs]/24)");
+
+            if (has_value()) {
+                return _STD forward<_Uty>(_Other);
+            }
+            else {
+                return _STD move(_Store).error();
+            }
+        }
+
+        // [expected.ref.monadic]
+        // The value is always passed on as a _Ty&; only the error is copied or moved according to *this.
+        template <class _Fn>
+            requires is_copy_constructible_v<_Err>
+        constexpr auto and_then(_Fn&& _Func) const& {
+            using _Uty = remove_cvref_t<invoke_result_t<_Fn, _Ty&>>;
+
+            static_assert(_Is_specialization_v<_Uty, expected>,
+                "expected<T&, E>::and_then(F) requires the return type of F to be a specialization of expected.");
+            static_assert(is_same_v<typename _Uty::error_type, _Err>,
+                "expected<T&, E>::and_then(F) requires the error type of the return type of F to be E.");
+
+            if (has_value()) [[likely]] {
+                return _STD invoke(_STD forward<_Fn>(_Func), **_Store);
+            }
+            else {
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _Store.error() };
+            }
+        }
+
+        template <class _Fn>
+            requires is_move_constructible_v<_Err>
+        constexpr auto and_then(_Fn&& _Func) && {
+            using _Uty = remove_cvref_t<invoke_result_t<_Fn, _Ty&>>;
+
+            static_assert(_Is_specialization_v<_Uty, expected>,
+                "expected<T&, E>::and_then(F) requires the return type of F to be a specialization of expected.");
+            static_assert(is_same_v<typename _Uty::error_type, _Err>,
+                "expected<T&, E>::and_then(F) requires the error type of the return type of F to be E.");
+
+            if (has_value()) [[likely]] {
+                return _STD invoke(_STD forward<_Fn>(_Func), **_Store);
+            }
+            else {
+                return _Uty{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Store).error() };
+            }
+        }
+
+        template <class _Fn>
+        constexpr auto or_else(_Fn&& _Func) const& {
+            using _Uty = remove_cvref_t<invoke_result_t<_Fn, const _Err&>>;
+
+            static_assert(_Is_specialization_v<_Uty, expected>,
+                "expected<T&, E>::or_else(F) requires the return type of F to be a specialization of expected.");
+            static_assert(is_same_v<typename _Uty::value_type, _Ty&>,
+                "expected<T&, E>::or_else(F) requires the value type of the return type of F to be T&.");
+
+            if (has_value()) [[likely]] {
+                return _Uty{ in_place, **_Store };
+            }
+            else {
+                return _STD invoke(_STD forward<_Fn>(_Func), _Store.error());
+            }
+        }
+
+        template <class _Fn>
+        constexpr auto or_else(_Fn&& _Func) && {
+            using _Uty = remove_cvref_t<invoke_result_t<_Fn, _Err&&>>;
+
+            static_assert(_Is_specialization_v<_Uty, expected>,
+                "expected<T&, E>::or_else(F) requires the return type of F to be a specialization of expected.");
+            static_assert(is_same_v<typename _Uty::value_type, _Ty&>,
+                "expected<T&, E>::or_else(F) requires the value type of the return type of F to be T&.");
+
+            if (has_value()) [[likely]] {
+                return _Uty{ in_place, **_Store };
+            }
+            else {
+                return _STD invoke(_STD forward<_Fn>(_Func), _STD move(_Store).error());
+            }
+        }
+
+        template <class _Fn>
+            requires is_copy_constructible_v<_Err>
+        constexpr auto transform(_Fn&& _Func) const& {
+            using _Uty = _Ref_transform_result_t<_Fn>;
+
+            if (has_value()) [[likely]] {
+                return _Transform_value<_Uty>(_STD forward<_Fn>(_Func));
+            }
+            else {
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _Store.error() };
+            }
+        }
+
+        template <class _Fn>
+            requires is_move_constructible_v<_Err>
+        constexpr auto transform(_Fn&& _Func) && {
+            using _Uty = _Ref_transform_result_t<_Fn>;
+
+            if (has_value()) [[likely]] {
+                return _Transform_value<_Uty>(_STD forward<_Fn>(_Func));
+            }
+            else {
+                return expected<_Uty, _Err>{ _EXPECTED_UNTRACKED(unexpect), _STD move(_Store).error() };
+            }
+        }
+
+        template <class _Fn>
+        constexpr auto transform_error(_Fn&& _Func) const& {
+            using _Gty = remove_cv_t<invoke_result_t<_Fn, const _Err&>>;
+            static_assert(_Check_unexpected_argument<_Gty>::value);
+
+            if (has_value()) [[likely]] {
+                return expected<_Ty&, _Gty>{ in_place, **_Store };
+            }
+            else {
+                return expected<_Ty&, _Gty>{ unexpect_from, _STD forward<_Fn>(_Func), _Store.error() };
+            }
+        }
+
+        template <class _Fn>
+        constexpr auto transform_error(_Fn&& _Func) && {
+            using _Gty = remove_cv_t<invoke_result_t<_Fn, _Err&&>>;
+            static_assert(_Check_unexpected_argument<_Gty>::value);
+
+            if (has_value()) [[likely]] {
+                return expected<_Ty&, _Gty>{ in_place, **_Store };
+            }
+            else {
+                return expected<_Ty&, _Gty>{ unexpect_from, _STD forward<_Fn>(_Func), _STD move(_Store).error() };
+            }
+        }
+
+        // [expected.ref.eq]
+        // compares the referenced values, as expected<T, E> compares its own
+        template <class _Uty, class _UErr>
+            requires (!is_void_v<_Uty>)
+        _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const expected<_Uty, _UErr>& _Right) {
+            if (_Left.has_value() != _Right.has_value()) {
+                return false;
+            }
+            else if (_Left.has_value()) {
+                return static_cast<bool>(*_Left == *_Right);
+            }
+            else {
+                return static_cast<bool>(_Left.error() == _Right.error());
+            }
+        }
+
+        template <class _Uty>
+        _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const _Uty& _Right) {
+            return _Left.has_value() && static_cast<bool>(*_Left == _Right);
+        }
+
+        template <class _UErr>
+        _NODISCARD_FRIEND constexpr bool operator==(const expected& _Left, const unexpected<_UErr>& _Right) {
+            return !_Left.has_value() && static_cast<bool>(_Left.error() == _Right.error());
+        }
+
+    private:
+        // An lvalue reference result stays a reference; any other result is a new value, as for expected<T, E>
+        template <class _Fn>
+        using _Ref_transform_result_t = conditional_t<is_lvalue_reference_v<invoke_result_t<_Fn, _Ty&>>,
+            invoke_result_t<_Fn, _Ty&>, remove_cvref_t<invoke_result_t<_Fn, _Ty&>>>;
+
+        template <class _Uty, class _Fn>
+        constexpr expected<_Uty, _Err> _Transform_value(_Fn&& _Func) const {
+            if constexpr (is_void_v<_Uty>) {
+                _STD invoke(_STD forward<_Fn>(_Func), **_Store);
+                return expected<_Uty, _Err>{};
+            }
+            else if constexpr (is_lvalue_reference_v<_Uty>) {
+                return expected<_Uty, _Err>{ in_place, _STD invoke(_STD forward<_Fn>(_Func), **_Store) };
+            }
+            else {
+                return expected<_Uty, _Err>{ in_place_from, _STD forward<_Fn>(_Func), **_Store };
+            }
+        }
+
+        _Storage _Store;
+    };
+
+    // [expected.reloc] (extension)
+    // A type is trivially relocatable when move-constructing an object into new storage and destroying the source
+    // is equivalent to copying its bytes. Trivially copyable types qualify; specialize is_trivially_relocatable<T>
+    // for other types that do (such as unique_ptr), but never for types holding pointers into themselves.
+    _EXPORT_STD template <class _Ty>
+        struct is_trivially_relocatable : bool_constant<is_trivially_copyable_v<_Ty>> {};
+
+    _EXPORT_STD template <class _Ty>
+        inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<_Ty>::value;
+
+    template <class _Err>
+    struct is_trivially_relocatable<unexpected<_Err>> : is_trivially_relocatable<_Err>::type {};
+
+    // The discriminant, whether a bool, a niche or a byte of tail padding, is relocated along with the alternatives.
+    template <class _Ty, class _Err>
+    struct is_trivially_relocatable<expected<_Ty, _Err>>
+        : bool_constant<(is_void_v<_Ty> || is_lvalue_reference_v<_Ty> || is_trivially_relocatable_v<_Ty>)
+                        && is_trivially_relocatable_v<_Err>> {};
+
+}
+
+namespace std {
+
+    // [expected.alloc] (extension)
+    template <class _Ty, class _Err, class _Alloc>
+    struct uses_allocator<experimental::expected<_Ty, _Err>, _Alloc>
+        : bool_constant<!is_reference_v<_Ty> && (uses_allocator_v<_Ty, _Alloc> || uses_allocator_v<_Err, _Alloc>)> {};
+
 }
 
 #pragma pop_macro("new")
 _STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
 #pragma warning(pop)
 #pragma pack(pop)
+#endif // _MSC_VER
 #endif // _STL_COMPILER_PREPROCESSOR
 #endif // _EXPECTED_
 
@@ -0,0 +1,180 @@
+#pragma once
+
+// expected_batch experimental header
+
+#ifndef _EXPECTED_BATCH_
+#define _EXPECTED_BATCH_
+#include "expected.h"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [expected.batch] (extension)
+    // batch_transform, batch_and_then and batch_transform_error apply the monadic operation of the same name to
+    // every element of _In and store the results in _Out, which must have the same size.
+    // When the payload and error types are arithmetic or enumeration types of 1, 2, 4 or 8 bytes, and neither
+    // expected uses a niche, each element is processed without branching on has_value(): _Func is called
+    // for every element, receiving a value-initialized argument for the elements that hold the other
+    // alternative, and its result is blended with the passed-through alternative by a bit mask. That keeps
+    // batches with a few percent of unpredictable errors free of mispredictions and lets the compiler vectorize
+    // the loop; _Func must therefore be side-effect free and accept value-initialized arguments.
+    // Other types fall back to calling the member function on each element.
+
+    template <class _Ty>
+    _NODISCARD consteval bool _Is_batch_scalar() noexcept {
+        if constexpr (is_arithmetic_v<_Ty> || is_enum_v<_Ty>) {
+            return sizeof(_Ty) == 1 || sizeof(_Ty) == 2 || sizeof(_Ty) == 4 || sizeof(_Ty) == 8;
+        }
+        else {
+            return false;
+        }
+    }
+
+    struct _Expected_batch {
+        template <class _Ty, class _Err>
+        _NODISCARD static consteval bool _Is_branchless() noexcept {
+            if constexpr (_Is_batch_scalar<_Ty>() && _Is_batch_scalar<_Err>()) {
+                return expected<_Ty, _Err>::_Niche == _Expected_niche::_None;
+            }
+            else {
+                return false;
+            }
+        }
+
+        template <class _Bits>
+        _NODISCARD static _Bits _Mask(const bool _Ok) noexcept {
+            return static_cast<_Bits>(0 - static_cast<_Bits>(_Ok));
+        }
+
+        // The bytes of the union holding either alternative; when the alternative asked for is the smaller,
+        // inactive one the trailing bytes are indeterminate, and every caller masks them off.
+        template <class _Alt, class _Ty, class _Err>
+        _NODISCARD static _Unsigned_of_size<sizeof(_Alt)> _Load(const expected<_Ty, _Err>& _Src) noexcept {
+            _Unsigned_of_size<sizeof(_Alt)> _Bits;
+            _CSTD memcpy(&_Bits, _STD addressof(_Src._Un), sizeof(_Alt));
+            return _Bits;
+        }
+
+        template <class _Ty, class _Err>
+        using _Image = _Unsigned_of_size<sizeof(_Expected_union<_Ty, _Err>)>;
+
+        // zero-extends the object representation of _Val to the size of _Image, keeping its bytes first in memory
+        template <class _Image_ty, class _Alt>
+        _NODISCARD static _Image_ty _Widen(const _Alt& _Val) noexcept {
+            _Image_ty _Bits = 0;
+            _CSTD memcpy(&_Bits, _STD addressof(_Val), sizeof(_Alt));
+            return _Bits;
+        }
+
+        template <class _Ty, class _Err>
+        static void _Store(expected<_Ty, _Err>& _Dest, const _Image<_Ty, _Err> _Bits, const bool _Ok) noexcept {
+            _CSTD memcpy(static_cast<void*>(_STD addressof(_Dest._Un)), &_Bits, sizeof(_Bits));
+            _Dest._Has_value = _Ok;
+        }
+
+        template <class _Ty, class _Err, class _Uty, class _Fn>
+        static void _Transform(const expected<_Ty, _Err>& _Src, expected<_Uty, _Err>& _Dest, _Fn& _Func) {
+            using _Out = _Image<_Uty, _Err>;
+            const bool _Ok = _Src.has_value();
+            const _Ty _Arg = _STD bit_cast<_Ty>(
+                static_cast<_Unsigned_of_size<sizeof(_Ty)>>(_Load<_Ty>(_Src) & _Mask<_Unsigned_of_size<sizeof(_Ty)>>(_Ok)));
+            const _Uty _Res = _STD invoke(_Func, _Arg);
+            const _Out _Sel = _Mask<_Out>(_Ok);
+            _Store(_Dest, static_cast<_Out>((_Widen<_Out>(_Res) & _Sel) | (_Widen<_Out>(_Load<_Err>(_Src)) & ~_Sel)), _Ok);
+        }
+
+        template <class _Ty, class _Err, class _Uty, class _Fn>
+        static void _And_then(const expected<_Ty, _Err>& _Src, expected<_Uty, _Err>& _Dest, _Fn& _Func) {
+            using _Out = _Image<_Uty, _Err>;
+            const bool _Ok = _Src.has_value();
+            const _Ty _Arg = _STD bit_cast<_Ty>(
+                static_cast<_Unsigned_of_size<sizeof(_Ty)>>(_Load<_Ty>(_Src) & _Mask<_Unsigned_of_size<sizeof(_Ty)>>(_Ok)));
+            const expected<_Uty, _Err> _Res = _STD invoke(_Func, _Arg);
+            _Out _Res_bits;
+            _CSTD memcpy(&_Res_bits, _STD addressof(_Res._Un), sizeof(_Res_bits));
+            const _Out _Sel = _Mask<_Out>(_Ok);
+            _Store(_Dest, static_cast<_Out>((_Res_bits & _Sel) | (_Widen<_Out>(_Load<_Err>(_Src)) & ~_Sel)),
+                _Ok & _Res.has_value());
+        }
+
+        template <class _Ty, class _Err, class _Gty, class _Fn>
+        static void _Transform_error(const expected<_Ty, _Err>& _Src, expected<_Ty, _Gty>& _Dest, _Fn& _Func) {
+            using _Out = _Image<_Ty, _Gty>;
+            const bool _Ok = _Src.has_value();
+            const _Err _Arg = _STD bit_cast<_Err>(
+                static_cast<_Unsigned_of_size<sizeof(_Err)>>(_Load<_Err>(_Src) & ~_Mask<_Unsigned_of_size<sizeof(_Err)>>(_Ok)));
+            const _Gty _Res = _STD invoke(_Func, _Arg);
+            const _Out _Sel = _Mask<_Out>(_Ok);
+            _Store(_Dest, static_cast<_Out>((_Widen<_Out>(_Load<_Ty>(_Src)) & _Sel) | (_Widen<_Out>(_Res) & ~_Sel)), _Ok);
+        }
+    };
+
+    _EXPORT_STD template <class _Ty, class _Err, class _Uty, class _Fn>
+        void batch_transform(span<const expected<_Ty, _Err>> _In, span<expected<_Uty, _Err>> _Out, _Fn&& _Func) {
+        _STL_VERIFY(_In.size() == _Out.size(), "batch_transform requires input and output of the same size");
+        if constexpr (_Expected_batch::_Is_branchless<_Ty, _Err>() && _Expected_batch::_Is_branchless<_Uty, _Err>()) {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Expected_batch::_Transform(_In[_Idx], _Out[_Idx], _Func);
+            }
+        }
+        else {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Out[_Idx] = _In[_Idx].transform(_Func);
+            }
+        }
+    }
+
+    _EXPORT_STD template <class _Ty, class _Err, class _Uty, class _Fn>
+        void batch_and_then(span<const expected<_Ty, _Err>> _In, span<expected<_Uty, _Err>> _Out, _Fn&& _Func) {
+        _STL_VERIFY(_In.size() == _Out.size(), "batch_and_then requires input and output of the same size");
+        if constexpr (_Expected_batch::_Is_branchless<_Ty, _Err>() && _Expected_batch::_Is_branchless<_Uty, _Err>()) {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Expected_batch::_And_then(_In[_Idx], _Out[_Idx], _Func);
+            }
+        }
+        else {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Out[_Idx] = _In[_Idx].and_then(_Func);
+            }
+        }
+    }
+
+    _EXPORT_STD template <class _Ty, class _Err, class _Gty, class _Fn>
+        void batch_transform_error(span<const expected<_Ty, _Err>> _In, span<expected<_Ty, _Gty>> _Out, _Fn&& _Func) {
+        _STL_VERIFY(_In.size() == _Out.size(), "batch_transform_error requires input and output of the same size");
+        if constexpr (_Expected_batch::_Is_branchless<_Ty, _Err>() && _Expected_batch::_Is_branchless<_Ty, _Gty>()) {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Expected_batch::_Transform_error(_In[_Idx], _Out[_Idx], _Func);
+            }
+        }
+        else {
+            for (size_t _Idx = 0; _Idx < _In.size(); ++_Idx) {
+                _Out[_Idx] = _In[_Idx].transform_error(_Func);
+            }
+        }
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_BATCH_
@@ -0,0 +1,250 @@
+#pragma once
+
+// expected_boxed experimental header
+
+#ifndef _EXPECTED_BOXED_
+#define _EXPECTED_BOXED_
+#include "expected.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [expected.boxed] (extension)
+    // boxed_error<E> holds an E out of line, so that expected<T, boxed_error<E>> is the size of expected<T, E*>
+    // however large E is: a rich error costs a pointer in every result, and its bytes are touched only on the
+    // error path. Boxes come from a per-thread free list of E-sized blocks, so that after warm-up constructing and
+    // destroying an error does not reach the allocator; a box may be freed on another thread than the one that
+    // allocated it. Moving a boxed_error moves the pointer and never allocates; copying allocates a new box.
+    // A moved-from boxed_error may only be destroyed or assigned to. Since a boxed_error is never null, expected
+    // keeps its discriminant in the pointer where no other bytes are needed: expected<void, boxed_error<E>> is the
+    // size of a pointer. boxed_error is not usable in constant expressions.
+
+    // the address held by a moved-from boxed_error, which owns nothing
+    inline constexpr unsigned char _Boxed_error_moved_from{};
+
+    // Caches up to _Capacity freed boxes of one error type for the current thread.
+    template <class _Err>
+    class _Boxed_error_pool {
+    public:
+        static constexpr size_t _Block_size = sizeof(_Err) < sizeof(void*) ? sizeof(void*) : sizeof(_Err);
+        static constexpr size_t _Block_align = alignof(_Err) < alignof(void*) ? alignof(void*) : alignof(_Err);
+        static constexpr size_t _Capacity = 64;
+
+        _Boxed_error_pool() = default;
+        _Boxed_error_pool(const _Boxed_error_pool&) = delete;
+        _Boxed_error_pool& operator=(const _Boxed_error_pool&) = delete;
+
+        ~_Boxed_error_pool() {
+            _Destroyed = true;
+            while (_Free) {
+                _Deallocate(_Pop());
+            }
+        }
+
+        _NODISCARD static void* _Allocate() {
+            if (_Destroyed) [[unlikely]] {
+                return _Allocate_new();
+            }
+
+            _Boxed_error_pool& _Pool = _Local();
+            if (_Pool._Free) [[likely]] {
+                return _Pool._Pop();
+            }
+
+            return _Allocate_new();
+        }
+
+        static void _Release(void* const _Block) noexcept {
+            if (_Destroyed) [[unlikely]] {
+                _Deallocate(_Block);
+                return;
+            }
+
+            _Boxed_error_pool& _Pool = _Local();
+            if (_Pool._Cached < _Capacity) [[likely]] {
+                _CSTD memcpy(_Block, &_Pool._Free, sizeof(void*));
+                _Pool._Free = _Block;
+                ++_Pool._Cached;
+            }
+            else {
+                _Deallocate(_Block);
+            }
+        }
+
+    private:
+        _NODISCARD static _Boxed_error_pool& _Local() noexcept {
+            thread_local _Boxed_error_pool _Pool;
+            return _Pool;
+        }
+
+        void* _Pop() noexcept {
+            void* const _Block = _Free;
+            _CSTD memcpy(&_Free, _Block, sizeof(void*));
+            --_Cached;
+            return _Block;
+        }
+
+        _EXPECTED_NOINLINE static void* _Allocate_new() {
+            return ::operator new(_Block_size, align_val_t{_Block_align});
+        }
+
+        static void _Deallocate(void* const _Block) noexcept {
+            ::operator delete(_Block, _Block_size, align_val_t{_Block_align});
+        }
+
+        void* _Free = nullptr;
+        size_t _Cached = 0;
+
+        // Set once this thread's pool is destroyed. Boxes destroyed later in thread or program exit, by a static or
+        // by another thread_local's destructor, go straight to the allocator; being trivially destructible, the flag
+        // itself stays usable until the thread ends.
+        static inline thread_local bool _Destroyed = false;
+    };
+
+    _EXPORT_STD template <class _Err>
+        class boxed_error {
+        static_assert(is_object_v<_Err> && !is_const_v<_Err> && !is_volatile_v<_Err> && !is_array_v<_Err>,
+            "boxed_error requires a non-const, non-volatile, non-array object type.");
+
+        public:
+            using element_type = _Err;
+
+            template <class... _Args>
+                requires is_constructible_v<_Err, _Args...>
+            explicit boxed_error(in_place_t, _Args&&... _Vals) : _Ptr(_Box(_STD forward<_Args>(_Vals)...)) {}
+
+            template <class _Uty = _Err>
+                requires (!is_same_v<remove_cvref_t<_Uty>, boxed_error> && !is_same_v<remove_cvref_t<_Uty>, in_place_t>
+                          && is_constructible_v<_Err, _Uty>)
+            explicit(!is_convertible_v<_Uty, _Err>) boxed_error(_Uty&& _Val) : _Ptr(_Box(_STD forward<_Uty>(_Val))) {}
+
+            boxed_error(const boxed_error& _Other) : _Ptr(_Box(*_Other)) {}
+
+            boxed_error(boxed_error&& _Other) noexcept : _Ptr(_STD exchange(_Other._Ptr, _Moved_from())) {}
+
+            ~boxed_error() {
+                _Tidy();
+            }
+
+            // assigns the error in place when both boxes are live, reusing the box
+            boxed_error& operator=(const boxed_error& _Other) {
+                if (this != _STD addressof(_Other)) {
+                    if (_Ptr != _Moved_from()) {
+                        **this = *_Other;
+                    }
+                    else {
+                        _Ptr = _Box(*_Other);
+                    }
+                }
+
+                return *this;
+            }
+
+            boxed_error& operator=(boxed_error&& _Other) noexcept {
+                if (this != _STD addressof(_Other)) {
+                    _Tidy();
+                    _Ptr = _STD exchange(_Other._Ptr, _Moved_from());
+                }
+
+                return *this;
+            }
+
+            void swap(boxed_error& _Other) noexcept {
+                _STD swap(_Ptr, _Other._Ptr);
+            }
+
+            friend void swap(boxed_error& _Left, boxed_error& _Right) noexcept {
+                _Left.swap(_Right);
+            }
+
+            _NODISCARD _Err* get() const noexcept {
+                return static_cast<_Err*>(_Ptr);
+            }
+
+            _NODISCARD _Err& operator*() const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Ptr != _Moved_from(), "cannot dereference a moved-from boxed_error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return *get();
+            }
+
+            _NODISCARD _Err* operator->() const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Ptr != _Moved_from(), "cannot dereference a moved-from boxed_error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return get();
+            }
+
+            // compare the boxed errors, so that expected<T, boxed_error<E>> compares as expected<T, E> would
+            _NODISCARD_FRIEND bool operator==(const boxed_error& _Left, const boxed_error& _Right) {
+                return static_cast<bool>(*_Left == *_Right);
+            }
+
+            template <class _Uty>
+                requires (!is_same_v<_Uty, boxed_error>)
+            _NODISCARD_FRIEND bool operator==(const boxed_error& _Left, const _Uty& _Right) {
+                return static_cast<bool>(*_Left == _Right);
+            }
+
+        private:
+            _NODISCARD static void* _Moved_from() noexcept {
+                return const_cast<unsigned char*>(&_Boxed_error_moved_from);
+            }
+
+            template <class... _Args>
+            _NODISCARD static void* _Box(_Args&&... _Vals) {
+                _Block_guard _Guard{ _Boxed_error_pool<_Err>::_Allocate() };
+                ::new (_Guard._Block) _Err(_STD forward<_Args>(_Vals)...);
+                return _STD exchange(_Guard._Block, nullptr);
+            }
+
+            // returns the block to the pool if the error's constructor throws
+            struct _NODISCARD _Block_guard {
+                void* _Block;
+
+                ~_Block_guard() {
+                    if (_Block) {
+                        _Boxed_error_pool<_Err>::_Release(_Block);
+                    }
+                }
+            };
+
+            void _Tidy() noexcept {
+                if (_Ptr != _Moved_from()) {
+                    get()->~_Err();
+                    _Boxed_error_pool<_Err>::_Release(_Ptr);
+                }
+            }
+
+            void* _Ptr; // never null
+    };
+
+    // A live boxed_error never holds null, so null marks an expected<T, boxed_error<E>> that holds a value
+    template <class _Err>
+    struct niche_traits<boxed_error<_Err>> : pointer_niche_traits<boxed_error<_Err>, 0> {};
+
+    template <class _Err>
+    struct is_trivially_relocatable<boxed_error<_Err>> : true_type {};
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_BOXED_
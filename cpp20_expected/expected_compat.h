@@ -0,0 +1,49 @@
+#pragma once
+
+// expected_compat experimental header
+
+#ifndef _EXPECTED_COMPAT_
+#define _EXPECTED_COMPAT_
+#include "expected_config.h"
+#if _STL_COMPILER_PREPROCESSOR
+
+// [expected.compat] (extension)
+// std::experimental::compat names the native std::expected family when the standard library provides it and
+// _EXPECTED_USE_NATIVE is nonzero (the default), and the copy in expected.h otherwise. Code written against
+// compat:: compiles to the same types as plain std:: code in C++23 translation units, and still builds as C++20.
+// The extensions of the copy (niche_traits, value_or_select, the batch algorithms, expected_vector) are only
+// usable on the copy; check compat::is_native before relying on them.
+#ifndef _EXPECTED_USE_NATIVE
+#define _EXPECTED_USE_NATIVE 1
+#endif // _EXPECTED_USE_NATIVE
+
+#if _EXPECTED_USE_NATIVE && __has_include(<expected>) && _HAS_CXX23
+#include <expected>
+#endif // _EXPECTED_USE_NATIVE && __has_include(<expected>) && _HAS_CXX23
+
+#if _EXPECTED_USE_NATIVE && defined(__cpp_lib_expected)
+namespace std::experimental::compat {
+    _EXPORT_STD using _STD expected;
+    _EXPORT_STD using _STD unexpected;
+    _EXPORT_STD using _STD bad_expected_access;
+    _EXPORT_STD using _STD unexpect_t;
+    _EXPORT_STD using _STD unexpect;
+
+    _EXPORT_STD inline constexpr bool is_native = true;
+}
+#else // ^^^ native / copy vvv
+#include "expected.h"
+
+namespace std::experimental::compat {
+    _EXPORT_STD using _STD experimental::expected;
+    _EXPORT_STD using _STD experimental::unexpected;
+    _EXPORT_STD using _STD experimental::bad_expected_access;
+    _EXPORT_STD using _STD experimental::unexpect_t;
+    _EXPORT_STD using _STD experimental::unexpect;
+
+    _EXPORT_STD inline constexpr bool is_native = false;
+}
+#endif // ^^^ copy ^^^
+
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_COMPAT_
@@ -0,0 +1,84 @@
+#pragma once
+
+// expected_config experimental header
+
+// Supplies the parts of the MSVC STL internals (<yvals.h>, <xutility>) that the experimental headers use, so that
+// they also build with GCC and Clang against libstdc++ or libc++. With MSVC (and clang-cl) the real headers are used.
+
+#ifndef _EXPECTED_CONFIG_
+#define _EXPECTED_CONFIG_
+#ifdef _MSC_VER
+#include <yvals.h>
+#include <xutility>
+#else // ^^^ MSVC STL / libstdc++, libc++ vvv
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#define _STL_COMPILER_PREPROCESSOR 1
+#define _HAS_CXX23 (__cplusplus > 202002L)
+
+#define _STD ::std::
+#define _CSTD ::
+#define _EXPORT_STD
+#define _NODISCARD [[nodiscard]]
+#define _NODISCARD_FRIEND [[nodiscard]] friend
+#define _MSVC_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#define __CLR_OR_THIS_CALL
+
+#ifdef __clang__
+#define _STL_DISABLE_CLANG_WARNINGS                                     \
+    _Pragma("clang diagnostic push")                                    \
+    _Pragma("clang diagnostic ignored \"-Wunknown-warning-option\"")    \
+    _Pragma("clang diagnostic ignored \"-Wreserved-identifier\"")       \
+    _Pragma("clang diagnostic ignored \"-Wreserved-macro-identifier\"")
+#define _STL_RESTORE_CLANG_WARNINGS _Pragma("clang diagnostic pop")
+#else // ^^^ Clang / GCC vvv
+#define _STL_DISABLE_CLANG_WARNINGS
+#define _STL_RESTORE_CLANG_WARNINGS
+#endif // ^^^ GCC ^^^
+
+// The debug checks follow the assertion modes of the standard library in use, as they follow
+// _ITERATOR_DEBUG_LEVEL with MSVC.
+#ifndef _CONTAINER_DEBUG_LEVEL
+#if defined(_GLIBCXX_ASSERTIONS) || defined(_LIBCPP_ENABLE_ASSERTIONS) \
+    || (defined(_LIBCPP_HARDENING_MODE) && _LIBCPP_HARDENING_MODE != _LIBCPP_HARDENING_MODE_NONE)
+#define _CONTAINER_DEBUG_LEVEL 1
+#else // ^^^ assertions enabled / assertions disabled vvv
+#define _CONTAINER_DEBUG_LEVEL 0
+#endif // ^^^ assertions disabled ^^^
+#endif // _CONTAINER_DEBUG_LEVEL
+
+#define _STL_VERIFY(_Cond, _Mesg)                                              \
+    do {                                                                       \
+        if (!(_Cond)) {                                                        \
+            _STD experimental::_Stl_verify_failed(__FILE__, __LINE__, _Mesg); \
+        }                                                                      \
+    } while (false)
+
+namespace std::experimental {
+
+    [[noreturn]] inline void _Stl_verify_failed(const char* const _File, const int _Line, const char* const _Mesg) noexcept {
+        _CSTD fprintf(stderr, "%s(%d): %s\n", _File, _Line, _Mesg);
+        _CSTD abort();
+    }
+
+    template <class _Type, template <class...> class _Template>
+    inline constexpr bool _Is_specialization_v = false; // true if and only if _Type is a specialization of _Template
+    template <template <class...> class _Template, class... _Types>
+    inline constexpr bool _Is_specialization_v<_Template<_Types...>, _Template> = true;
+
+    template <class _Ty>
+    void _Fake_copy_init(_Ty) noexcept;
+    // _Fake_copy_init<T>(E):
+    // (1) has type T [decay_t<decltype((E))> if T is deduced],
+    // (2) is well-formed if and only if E is implicitly convertible to T and T is destructible, and
+    // (3) is non-throwing if and only if both conversion from decltype((E)) to T and destruction of T are non-throwing.
+
+}
+
+#endif // ^^^ libstdc++, libc++ ^^^
+#endif // _EXPECTED_CONFIG_
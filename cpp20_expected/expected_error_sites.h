@@ -0,0 +1,331 @@
+#pragma once
+
+// expected_error_sites experimental header
+
+#ifndef _EXPECTED_ERROR_SITES_
+#define _EXPECTED_ERROR_SITES_
+#include "expected_config.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#if _STL_COMPILER_PREPROCESSOR
+
+#if _EXPECTED_ERROR_TRACES
+#include "expected_error_traces.h"
+#endif // _EXPECTED_ERROR_TRACES
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+#ifndef _EXPECTED_NOINLINE
+#if defined(__GNUC__) || defined(__clang__)
+#define _EXPECTED_NOINLINE __attribute__((noinline))
+#else // ^^^ GCC, Clang / MSVC vvv
+#define _EXPECTED_NOINLINE __declspec(noinline)
+#endif // ^^^ MSVC ^^^
+#endif // _EXPECTED_NOINLINE
+
+namespace std::experimental {
+
+    // [expected.sites] (extension)
+    // With _EXPECTED_ERROR_SITES defined to 1 before expected.h is included, constructing an unexpected, or an
+    // expected through unexpect or unexpect_from, counts one error at the source location of that construction.
+    // The operations of expected that carry an existing error along (and_then, transform, conversion from an
+    // unexpected, pipelines, ...) do not count it again: only the site that produced an error is counted.
+    // Each thread counts into a table of its own, without locks or shared cache lines; take_error_site_snapshot()
+    // merges the tables of all threads, including threads that have exited, and format_error_sites_text() and
+    // format_error_sites_json() render the result. A thread counts at most _Capacity distinct sites; errors at
+    // further sites are reported as dropped.
+    // The same points capture the stack traces of [expected.traces] in expected_error_traces.h, which may be enabled
+    // with or without counting sites.
+    // With _EXPECTED_ERROR_SITES and _EXPECTED_ERROR_TRACES 0, the default, expected.h does not include this header
+    // and its constructors are unchanged, so the generated code is the same as without these facilities. Including
+    // this header anyway gives snapshots with no sites. _EXPECTED_ERROR_SITES must have the same value in every
+    // translation unit of a program.
+
+    _EXPORT_STD struct error_site_count {
+        string_view file;
+        string_view function;
+        uint_least32_t line   = 0;
+        uint_least32_t column = 0;
+        uint64_t count        = 0;
+    };
+
+    _EXPORT_STD struct error_site_snapshot {
+        vector<error_site_count> sites; // by descending count
+        uint64_t dropped = 0; // errors at sites for which their thread's table had no room
+    };
+
+    struct _Error_site_slot {
+        atomic<const char*> _File{ nullptr }; // stored last: a slot with a file is complete
+        const char* _Function  = nullptr;
+        uint_least32_t _Line   = 0;
+        uint_least32_t _Column = 0;
+        atomic<uint64_t> _Count{ 0 };
+    };
+
+    class _Error_site_shard;
+
+    // The tables of the live threads, and the merged counts of the threads that have exited
+    struct _Error_site_registry {
+        using _Key = tuple<string_view, uint_least32_t, uint_least32_t, string_view>; // file, line, column, function
+
+        mutex _Mtx;
+        _Error_site_shard* _Shards = nullptr;
+        map<_Key, uint64_t> _Retired;
+        uint64_t _Retired_dropped = 0;
+
+        _NODISCARD static _Error_site_registry& _Instance() {
+            static _Error_site_registry _Registry;
+            return _Registry;
+        }
+    };
+
+    class _Error_site_shard {
+    public:
+        static constexpr size_t _Capacity = 256; // a power of two
+
+        _Error_site_shard() : _Registry(_Error_site_registry::_Instance()) {
+            lock_guard _Lock{ _Registry._Mtx };
+            _Next = _Registry._Shards;
+            if (_Next) {
+                _Next->_Prev = this;
+            }
+            _Registry._Shards = this;
+        }
+
+        _Error_site_shard(const _Error_site_shard&)            = delete;
+        _Error_site_shard& operator=(const _Error_site_shard&) = delete;
+
+        ~_Error_site_shard() {
+            lock_guard _Lock{ _Registry._Mtx };
+            _Add_to(_Registry._Retired, _Registry._Retired_dropped);
+            (_Prev ? _Prev->_Next : _Registry._Shards) = _Next;
+            if (_Next) {
+                _Next->_Prev = _Prev;
+            }
+        }
+
+        _NODISCARD static _Error_site_shard& _Local() {
+            thread_local _Error_site_shard _Shard;
+            return _Shard;
+        }
+
+        // Only the owning thread writes to a shard, so a count is a plain load and store, not a locked increment
+        void _Record(const source_location& _Loc) noexcept {
+            const char* const _File     = _Loc.file_name();
+            const uint_least32_t _Line   = _Loc.line();
+            const uint_least32_t _Column = _Loc.column();
+            size_t _Idx = (reinterpret_cast<uintptr_t>(_File) >> 4 ^ _Line * 0x9E3779B1u ^ _Column) & (_Capacity - 1);
+            for (size_t _Probe = 0; _Probe < _Capacity; ++_Probe, _Idx = (_Idx + 1) & (_Capacity - 1)) {
+                _Error_site_slot& _Slot      = _Slots[_Idx];
+                const char* const _Slot_file = _Slot._File.load(memory_order_relaxed);
+                if (_Slot_file == _File && _Slot._Line == _Line && _Slot._Column == _Column) {
+                    _Slot._Count.store(_Slot._Count.load(memory_order_relaxed) + 1, memory_order_relaxed);
+                    return;
+                }
+
+                if (!_Slot_file) {
+                    _Slot._Function = _Loc.function_name();
+                    _Slot._Line     = _Line;
+                    _Slot._Column   = _Column;
+                    _Slot._Count.store(1, memory_order_relaxed);
+                    _Slot._File.store(_File, memory_order_release);
+                    return;
+                }
+            }
+
+            _Dropped.store(_Dropped.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        }
+
+        // called with the registry locked
+        void _Add_to(map<_Error_site_registry::_Key, uint64_t>& _Counts, uint64_t& _Dropped_count) const {
+            for (const _Error_site_slot& _Slot : _Slots) {
+                if (const char* const _File = _Slot._File.load(memory_order_acquire)) {
+                    _Counts[{ _File, _Slot._Line, _Slot._Column, _Slot._Function }] +=
+                        _Slot._Count.load(memory_order_relaxed);
+                }
+            }
+
+            _Dropped_count += _Dropped.load(memory_order_relaxed);
+        }
+
+        _Error_site_shard* _Next = nullptr;
+
+    private:
+        _Error_site_registry& _Registry;
+        _Error_site_shard* _Prev = nullptr;
+        array<_Error_site_slot, _Capacity> _Slots{};
+        atomic<uint64_t> _Dropped{ 0 };
+    };
+
+    _EXPECTED_NOINLINE inline void _Record_error_site_at(const source_location& _Loc) noexcept {
+        _Error_site_shard::_Local()._Record(_Loc);
+    }
+
+    constexpr void _Record_error_site(const source_location& _Loc) noexcept {
+        if (!_STD is_constant_evaluated()) {
+#if _EXPECTED_ERROR_SITES
+            _STD experimental::_Record_error_site_at(_Loc);
+#else // ^^^ error sites / no error sites vvv
+            (void) _Loc;
+#endif // ^^^ no error sites ^^^
+#if _EXPECTED_ERROR_TRACES
+            _STD experimental::_Record_error_trace();
+#endif // _EXPECTED_ERROR_TRACES
+        }
+    }
+
+    struct _Untracked_error_site_t {
+        explicit _Untracked_error_site_t() = default;
+    };
+
+    inline constexpr _Untracked_error_site_t _Untracked_error_site{};
+
+    // The type of the unexpect, unexpect_from or in_place parameter of a constructor that counts error sites.
+    // Converting the tag argument to it captures the location of the call. expected's own operations pass an
+    // untracked one, or the one they received when they delegate.
+    template <class _Tag>
+    struct _Error_site_tag {
+        constexpr _Error_site_tag(_Tag, const source_location _Loc = source_location::current()) noexcept
+            : _Site(_Loc), _Tracked(true) {}
+
+        constexpr explicit _Error_site_tag(_Untracked_error_site_t) noexcept : _Site(), _Tracked(false) {}
+
+        template <class _Other_tag>
+        constexpr explicit _Error_site_tag(const _Error_site_tag<_Other_tag>& _Other) noexcept
+            : _Site(_Other._Site), _Tracked(_Other._Tracked) {}
+
+        constexpr operator _Tag() const noexcept {
+            return _Tag{};
+        }
+
+        source_location _Site;
+        bool _Tracked;
+    };
+
+    template <class _Tag>
+    constexpr void _Record_error_site(const _Error_site_tag<_Tag>& _Tag_arg) noexcept {
+        if (_Tag_arg._Tracked) {
+            _STD experimental::_Record_error_site(_Tag_arg._Site);
+        }
+    }
+
+    _EXPORT_STD _NODISCARD inline error_site_snapshot take_error_site_snapshot() {
+        _Error_site_registry& _Registry = _Error_site_registry::_Instance();
+        error_site_snapshot _Result;
+        map<_Error_site_registry::_Key, uint64_t> _Counts;
+        {
+            lock_guard _Lock{ _Registry._Mtx };
+            _Counts         = _Registry._Retired;
+            _Result.dropped = _Registry._Retired_dropped;
+            for (const _Error_site_shard* _Shard = _Registry._Shards; _Shard; _Shard = _Shard->_Next) {
+                _Shard->_Add_to(_Counts, _Result.dropped);
+            }
+        }
+
+        _Result.sites.reserve(_Counts.size());
+        for (const auto& [_Key, _Count] : _Counts) {
+            const auto& [_File, _Line, _Column, _Function] = _Key;
+            _Result.sites.push_back({ _File, _Function, _Line, _Column, _Count });
+        }
+
+        _STD stable_sort(_Result.sites.begin(), _Result.sites.end(),
+            [](const error_site_count& _Left, const error_site_count& _Right) { return _Left.count > _Right.count; });
+        return _Result;
+    }
+
+    // one line per site: count, file:line:column, function
+    _EXPORT_STD _NODISCARD inline string format_error_sites_text(const error_site_snapshot& _Snapshot) {
+        uint64_t _Total = _Snapshot.dropped;
+        for (const error_site_count& _Site : _Snapshot.sites) {
+            _Total += _Site.count;
+        }
+
+        char _Buf[96];
+        _CSTD snprintf(_Buf, sizeof(_Buf), "error sites: %llu errors at %zu sites, %llu dropped\n",
+            static_cast<unsigned long long>(_Total), _Snapshot.sites.size(),
+            static_cast<unsigned long long>(_Snapshot.dropped));
+        string _Result = _Buf;
+        for (const error_site_count& _Site : _Snapshot.sites) {
+            _CSTD snprintf(_Buf, sizeof(_Buf), "%12llu  ", static_cast<unsigned long long>(_Site.count));
+            _Result.append(_Buf);
+            _Result.append(_Site.file);
+            _CSTD snprintf(_Buf, sizeof(_Buf), ":%lu:%lu  ", static_cast<unsigned long>(_Site.line),
+                static_cast<unsigned long>(_Site.column));
+            _Result.append(_Buf);
+            _Result.append(_Site.function);
+            _Result.push_back('\n');
+        }
+
+        return _Result;
+    }
+
+    inline void _Append_json_string(string& _Out, const string_view _Str) {
+        _Out.push_back('"');
+        for (const char _Ch : _Str) {
+            if (_Ch == '"' || _Ch == '\\') {
+                _Out.push_back('\\');
+                _Out.push_back(_Ch);
+            }
+            else if (static_cast<unsigned char>(_Ch) < 0x20) {
+                char _Escape[8];
+                _CSTD snprintf(_Escape, sizeof(_Escape), "\\u%04x", static_cast<unsigned int>(_Ch));
+                _Out.append(_Escape);
+            }
+            else {
+                _Out.push_back(_Ch);
+            }
+        }
+        _Out.push_back('"');
+    }
+
+    // {"dropped":N,"sites":[{"file":"...","line":N,"column":N,"function":"...","count":N},...]}
+    _EXPORT_STD _NODISCARD inline string format_error_sites_json(const error_site_snapshot& _Snapshot) {
+        char _Buf[64];
+        _CSTD snprintf(
+            _Buf, sizeof(_Buf), "{\"dropped\":%llu,\"sites\":[", static_cast<unsigned long long>(_Snapshot.dropped));
+        string _Result = _Buf;
+        for (size_t _Idx = 0; _Idx < _Snapshot.sites.size(); ++_Idx) {
+            const error_site_count& _Site = _Snapshot.sites[_Idx];
+            _Result.append(_Idx == 0 ? "{\"file\":" : ",{\"file\":");
+            _STD experimental::_Append_json_string(_Result, _Site.file);
+            _CSTD snprintf(_Buf, sizeof(_Buf), ",\"line\":%lu,\"column\":%lu,\"function\":",
+                static_cast<unsigned long>(_Site.line), static_cast<unsigned long>(_Site.column));
+            _Result.append(_Buf);
+            _STD experimental::_Append_json_string(_Result, _Site.function);
+            _CSTD snprintf(_Buf, sizeof(_Buf), ",\"count\":%llu}", static_cast<unsigned long long>(_Site.count));
+            _Result.append(_Buf);
+        }
+
+        _Result.append("]}");
+        return _Result;
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_ERROR_SITES_
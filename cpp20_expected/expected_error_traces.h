@@ -0,0 +1,307 @@
+#pragma once
+
+// expected_error_traces experimental header
+
+#ifndef _EXPECTED_ERROR_TRACES_
+#define _EXPECTED_ERROR_TRACES_
+#include "expected_config.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#if _STL_COMPILER_PREPROCESSOR
+
+#if defined(__linux__) && defined(__GLIBC__) && (defined(__GNUC__) || defined(__clang__))
+#define _EXPECTED_HAS_FRAME_WALK 1
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#else // ^^^ glibc, GCC or Clang / other vvv
+#define _EXPECTED_HAS_FRAME_WALK 0
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif // ^^^ MSVC ^^^
+#endif // ^^^ other ^^^
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+#ifndef _EXPECTED_NOINLINE
+#if defined(__GNUC__) || defined(__clang__)
+#define _EXPECTED_NOINLINE __attribute__((noinline))
+#else // ^^^ GCC, Clang / MSVC vvv
+#define _EXPECTED_NOINLINE __declspec(noinline)
+#endif // ^^^ MSVC ^^^
+#endif // _EXPECTED_NOINLINE
+
+// The frame walk reads the frame records of other functions, which AddressSanitizer would report
+#if _EXPECTED_HAS_FRAME_WALK
+#define _EXPECTED_NO_SANITIZE_ADDRESS __attribute__((no_sanitize("address", "hwaddress")))
+#else // ^^^ frame walk / no frame walk vvv
+#define _EXPECTED_NO_SANITIZE_ADDRESS
+#endif // ^^^ no frame walk ^^^
+
+namespace std::experimental {
+
+    // [expected.traces] (extension)
+    // With _EXPECTED_ERROR_TRACES defined to 1 before expected.h is included, one error in N that a thread
+    // creates (at the points where [expected.sites] counts errors) has the return addresses of its call stack
+    // captured into a ring of error_trace_capacity traces shared by all threads. Nothing is symbolized when a trace
+    // is captured: take_error_traces() empties the ring, and format_error_traces_text() writes each frame as a
+    // module and an offset, for addr2line -Cfipe <module> <offset>, or any other offline symbolizer.
+    // set_error_trace_sampling(N) chooses N: 0 captures nothing, 1 every error; the default is 100. An error that
+    // is not sampled costs a decrement of a thread-local counter.
+    // The stack is walked through the frame pointers, within the bounds of the thread's stack: code built without
+    // frame pointers (-fomit-frame-pointer, the default at -O2 on x86-64) ends the trace early or skips frames, so
+    // build with -fno-omit-frame-pointer for complete traces. The walk needs GCC or Clang with glibc; elsewhere a
+    // trace holds only the innermost frame.
+    // After the first capture on a thread, which looks up the bounds of its stack (glibc may allocate and, on the
+    // main thread, read /proc/self/maps for that), capturing never blocks and never allocates: threads claim slots
+    // of the ring with a compare-and-swap, and when the ring is full the trace is dropped and counted in
+    // error_trace_snapshot::dropped. Taking the traces locks a mutex that only other calls to take_error_traces()
+    // use. A thread preempted while it writes a trace holds back the traces captured after it until it resumes, so
+    // take the traces often enough for the ring to absorb such pauses.
+    // _EXPECTED_ERROR_TRACES must have the same value in every translation unit of a program.
+
+    _EXPORT_STD inline constexpr size_t error_trace_depth    = 16;
+    _EXPORT_STD inline constexpr size_t error_trace_capacity = 1024; // a power of two
+
+    _EXPORT_STD struct error_trace {
+        size_t depth = 0;
+        array<const void*, error_trace_depth> frames{}; // return addresses, innermost first
+    };
+
+    _EXPORT_STD struct error_trace_snapshot {
+        vector<error_trace> traces; // in the order they were captured
+        uint64_t dropped = 0; // traces not captured because the ring was full, since the last snapshot
+    };
+
+    inline atomic<uint_least32_t> _Error_trace_period{ 100 };
+    inline thread_local uint_least32_t _Error_trace_countdown = 0; // errors to let pass before the next capture
+
+    // The slots of the ring are used in laps: in lap L, a slot is free for a producer while its stamp is
+    // L * error_trace_capacity, and holds a trace for the consumer once the stamp is one more. Taking the trace
+    // moves the slot to the next lap. A zero-initialized ring is empty.
+    struct _Error_trace_slot {
+        atomic<size_t> _Stamp{ 0 };
+        error_trace _Trace;
+    };
+
+    class _Error_trace_ring {
+    public:
+        static constexpr size_t _Mask = error_trace_capacity - 1;
+
+        // Claims the slot for the next trace, or returns null when the ring is full
+        _NODISCARD _Error_trace_slot* _Claim(size_t& _Lap) noexcept {
+            size_t _Pos = _Head.load(memory_order_relaxed);
+            for (;;) {
+                _Error_trace_slot& _Slot = _Slots[_Pos & _Mask];
+                _Lap                     = _Pos & ~_Mask;
+                const auto _Diff = static_cast<ptrdiff_t>(_Slot._Stamp.load(memory_order_acquire) - _Lap);
+                if (_Diff == 0) {
+                    if (_Head.compare_exchange_weak(_Pos, _Pos + 1, memory_order_relaxed)) {
+                        return &_Slot;
+                    }
+                }
+                else if (_Diff < 0) { // still holds the trace of the previous lap
+                    _Dropped.fetch_add(1, memory_order_relaxed);
+                    return nullptr;
+                }
+                else { // claimed by another thread since _Pos was read
+                    _Pos = _Head.load(memory_order_relaxed);
+                }
+            }
+        }
+
+        static void _Publish(_Error_trace_slot& _Slot, const size_t _Lap) noexcept {
+            _Slot._Stamp.store(_Lap + 1, memory_order_release);
+        }
+
+        // A slot claimed but not yet published ends the take; the traces after it are left for the next one
+        void _Take(error_trace_snapshot& _Snapshot) {
+            lock_guard _Lock{ _Consumer_mtx };
+            for (;;) {
+                _Error_trace_slot& _Slot = _Slots[_Tail & _Mask];
+                const size_t _Lap        = _Tail & ~_Mask;
+                if (_Slot._Stamp.load(memory_order_acquire) != _Lap + 1) {
+                    break;
+                }
+
+                _Snapshot.traces.push_back(_Slot._Trace);
+                _Slot._Stamp.store(_Lap + error_trace_capacity, memory_order_release);
+                ++_Tail;
+            }
+
+            _Snapshot.dropped = _Dropped.exchange(0, memory_order_relaxed);
+        }
+
+    private:
+        alignas(64) atomic<size_t> _Head{ 0 };
+        alignas(64) atomic<uint64_t> _Dropped{ 0 };
+        alignas(64) mutex _Consumer_mtx;
+        size_t _Tail = 0;
+        array<_Error_trace_slot, error_trace_capacity> _Slots{};
+    };
+
+    inline _Error_trace_ring _Error_trace_ring_instance;
+
+#if _EXPECTED_HAS_FRAME_WALK
+    struct _Error_trace_stack {
+        uintptr_t _Low  = 0;
+        uintptr_t _High = 0; // 0 until the bounds are looked up, then 1 if they are unknown
+    };
+
+    inline thread_local _Error_trace_stack _Error_trace_stack_bounds;
+
+    inline const _Error_trace_stack& _Current_error_trace_stack() noexcept {
+        _Error_trace_stack& _Stack = _Error_trace_stack_bounds;
+        if (_Stack._High == 0) {
+            _Stack._High = 1;
+            pthread_attr_t _Attr;
+            if (pthread_getattr_np(pthread_self(), &_Attr) == 0) {
+                void* _Addr   = nullptr;
+                size_t _Size  = 0;
+                if (pthread_attr_getstack(&_Attr, &_Addr, &_Size) == 0) {
+                    _Stack._Low  = reinterpret_cast<uintptr_t>(_Addr);
+                    _Stack._High = _Stack._Low + _Size;
+                }
+                pthread_attr_destroy(&_Attr);
+            }
+        }
+
+        return _Stack;
+    }
+#endif // _EXPECTED_HAS_FRAME_WALK
+
+    // Not inlined, so that its frame is the first one walked and its return address is the code creating the error
+    _EXPECTED_NOINLINE _EXPECTED_NO_SANITIZE_ADDRESS inline void _Capture_error_trace() noexcept {
+#if _EXPECTED_HAS_FRAME_WALK
+        // before claiming a slot: the first lookup on a thread may allocate, and a claimed slot holds back the
+        // consumer until it is published
+        const _Error_trace_stack& _Stack = _STD experimental::_Current_error_trace_stack();
+#endif // _EXPECTED_HAS_FRAME_WALK
+        size_t _Lap;
+        _Error_trace_slot* const _Slot = _Error_trace_ring_instance._Claim(_Lap);
+        if (!_Slot) {
+            return;
+        }
+
+        error_trace& _Trace = _Slot->_Trace;
+#if _EXPECTED_HAS_FRAME_WALK
+        // A frame record is the caller's frame pointer followed by the return address, on x86-64 and AArch64 alike.
+        // The records of the callers are at increasing addresses within the thread's stack.
+        auto _Frame = static_cast<void* const*>(__builtin_frame_address(0));
+        size_t _Depth = 0;
+        for (;;) {
+            if (!_Frame[1]) {
+                break;
+            }
+
+            _Trace.frames[_Depth++] = _Frame[1];
+            const auto _Next = reinterpret_cast<uintptr_t>(_Frame[0]);
+            if (_Depth == error_trace_depth || _Next <= reinterpret_cast<uintptr_t>(_Frame) || _Next < _Stack._Low
+                || _Next + 2 * sizeof(void*) > _Stack._High || _Next % alignof(void*) != 0) {
+                break;
+            }
+
+            _Frame = reinterpret_cast<void* const*>(_Next);
+        }
+        _Trace.depth = _Depth;
+#elif defined(_MSC_VER) && !defined(__clang__)
+        _Trace.frames[0] = _ReturnAddress();
+        _Trace.depth     = 1;
+#else // ^^^ MSVC / GCC, Clang without glibc vvv
+        _Trace.frames[0] = __builtin_return_address(0);
+        _Trace.depth     = 1;
+#endif // ^^^ GCC, Clang without glibc ^^^
+
+        _Error_trace_ring::_Publish(*_Slot, _Lap);
+    }
+
+    inline void _Record_error_trace() noexcept {
+        const uint_least32_t _Period = _Error_trace_period.load(memory_order_relaxed);
+        if (_Period == 0) {
+            return;
+        }
+
+        uint_least32_t& _Left = _Error_trace_countdown;
+        if (_Left - 1 < _Period - 1) { // 0 < _Left < _Period
+            --_Left;
+            return;
+        }
+
+        _Left = _Period - 1;
+        _STD experimental::_Capture_error_trace();
+    }
+
+    _EXPORT_STD inline void set_error_trace_sampling(const uint_least32_t _Every) noexcept {
+        _Error_trace_period.store(_Every, memory_order_relaxed);
+    }
+
+    _EXPORT_STD _NODISCARD inline uint_least32_t error_trace_sampling() noexcept {
+        return _Error_trace_period.load(memory_order_relaxed);
+    }
+
+    // Removes the captured traces from the ring
+    _EXPORT_STD _NODISCARD inline error_trace_snapshot take_error_traces() {
+        error_trace_snapshot _Snapshot;
+        _Error_trace_ring_instance._Take(_Snapshot);
+        return _Snapshot;
+    }
+
+    // one line per frame: index, address, module+offset. The offset is that of the call instruction (the return
+    // address minus one) relative to the addresses of the module's file, as addr2line expects.
+    _EXPORT_STD _NODISCARD inline string format_error_traces_text(const error_trace_snapshot& _Snapshot) {
+        char _Buf[96];
+        _CSTD snprintf(_Buf, sizeof(_Buf), "error traces: %zu captured, %llu dropped\n", _Snapshot.traces.size(),
+            static_cast<unsigned long long>(_Snapshot.dropped));
+        string _Result = _Buf;
+        for (size_t _Idx = 0; _Idx < _Snapshot.traces.size(); ++_Idx) {
+            const error_trace& _Trace = _Snapshot.traces[_Idx];
+            _CSTD snprintf(_Buf, sizeof(_Buf), "trace %zu:\n", _Idx + 1);
+            _Result.append(_Buf);
+            for (size_t _Frame = 0; _Frame < _Trace.depth; ++_Frame) {
+                const auto _Addr = reinterpret_cast<uintptr_t>(_Trace.frames[_Frame]) - 1;
+                _CSTD snprintf(_Buf, sizeof(_Buf), "  #%-2zu 0x%016llx", _Frame, static_cast<unsigned long long>(_Addr));
+                _Result.append(_Buf);
+#if _EXPECTED_HAS_FRAME_WALK
+                Dl_info _Info;
+                link_map* _Module = nullptr;
+                if (dladdr1(reinterpret_cast<const void*>(_Addr), &_Info, reinterpret_cast<void**>(&_Module),
+                        RTLD_DL_LINKMAP)
+                        != 0
+                    && _Module) {
+                    _CSTD snprintf(_Buf, sizeof(_Buf), "+0x%llx",
+                        static_cast<unsigned long long>(_Addr - static_cast<uintptr_t>(_Module->l_addr)));
+                    _Result.push_back(' ');
+                    _Result.append(_Info.dli_fname && *_Info.dli_fname ? _Info.dli_fname : "?");
+                    _Result.append(_Buf);
+                }
+#endif // _EXPECTED_HAS_FRAME_WALK
+                _Result.push_back('\n');
+            }
+        }
+
+        return _Result;
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_ERROR_TRACES_
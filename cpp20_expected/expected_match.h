@@ -0,0 +1,321 @@
+#pragma once
+
+// expected_match experimental header
+
+#ifndef _EXPECTED_MATCH_
+#define _EXPECTED_MATCH_
+#include "error_enum.h"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+#ifndef _EXPECTED_UNREACHABLE
+#if defined(__GNUC__) || defined(__clang__)
+#define _EXPECTED_UNREACHABLE __builtin_unreachable()
+#else // ^^^ GCC, Clang / MSVC vvv
+#define _EXPECTED_UNREACHABLE __assume(false)
+#endif // ^^^ MSVC ^^^
+#endif // _EXPECTED_UNREACHABLE
+
+namespace std::experimental {
+
+    // [expected.match] (extension)
+    // match(e, on_value, on_error<E::A>(f_a), on_error<E::B>(f_b), ...) calls on_value with the value of e, or the
+    // handler of its error code with the error, replacing `if (!e)` followed by a switch on e.error(). The state of
+    // e and its error code are folded into one index, 0 for a value and 1 + error_enum_index(e.error()) for an
+    // error, and dispatched by a single switch, which compilers lower to one jump table.
+    // Every enumerator of E (as found by error_enum.h) needs a handler, or the call does not compile; on_error(f),
+    // without a code, handles the codes that have no handler of their own, including values of E that are not
+    // enumerators. Without it, such a value throws bad_expected_access<E>, as value() would.
+    // Handlers take the error or nothing, and on_value takes the value, or nothing for expected<void, E>; both
+    // receive them with the value category of e. match returns the common type of the results of all handlers.
+
+    template <auto _Code, class _Fn>
+    struct _Match_error_handler {
+        _Fn _Func;
+    };
+
+    template <class _Fn>
+    struct _Match_other_errors_handler {
+        _Fn _Func;
+    };
+
+    _EXPORT_STD template <auto _Code, class _Fn>
+        requires is_enum_v<decltype(_Code)>
+    _NODISCARD constexpr _Match_error_handler<_Code, decay_t<_Fn>> on_error(_Fn&& _Func) {
+        return { _STD forward<_Fn>(_Func) };
+    }
+
+    _EXPORT_STD template <class _Fn>
+    _NODISCARD constexpr _Match_other_errors_handler<decay_t<_Fn>> on_error(_Fn&& _Func) {
+        return { _STD forward<_Fn>(_Func) };
+    }
+
+    template <class _Fn, class _Arg>
+    constexpr decltype(auto) _Match_invoke(_Fn& _Func, _Arg&& _Val) {
+        if constexpr (is_invocable_v<_Fn&, _Arg>) {
+            return _STD invoke(_Func, _STD forward<_Arg>(_Val));
+        }
+        else {
+            return _STD invoke(_Func);
+        }
+    }
+
+    template <class _Handler, class _Err_ref>
+    using _Match_handler_result_t =
+        decltype(_STD experimental::_Match_invoke(_STD declval<decltype((_STD declval<_Handler&>()._Func))>(),
+            _STD declval<_Err_ref>()));
+
+    template <class _Expected, class _On_value, bool = is_void_v<typename remove_cvref_t<_Expected>::value_type>>
+    struct _Match_value_result {
+        using type = invoke_result_t<_On_value&, decltype(*_STD declval<_Expected>())>;
+    };
+
+    template <class _Expected, class _On_value>
+    struct _Match_value_result<_Expected, _On_value, true> {
+        using type = invoke_result_t<_On_value&>;
+    };
+
+    template <class _Expected, class _On_value>
+    using _Match_value_result_t = typename _Match_value_result<_Expected, _On_value>::type;
+
+    template <class _Expected, class _On_value, class... _Handlers>
+    using _Match_result_t = common_type_t<_Match_value_result_t<_Expected, _On_value>,
+        _Match_handler_result_t<remove_reference_t<_Handlers>, decltype(_STD declval<_Expected>().error())>...>;
+
+    struct _Match_handler_info {
+        bool _Is_handler = false;
+        bool _Is_other = false;
+        bool _Is_enumerator = false;
+        size_t _Index = 0;
+    };
+
+    template <class _Err, class _Handler>
+    struct _Match_handler_traits {
+        static constexpr _Match_handler_info _Info{};
+    };
+
+    template <class _Err, auto _Code, class _Fn>
+    struct _Match_handler_traits<_Err, _Match_error_handler<_Code, _Fn>> {
+        static constexpr _Match_handler_info _Info = [] {
+            if constexpr (is_same_v<decltype(_Code), _Err>) {
+                const size_t _Idx = _STD experimental::error_enum_index(_Code);
+                return _Match_handler_info{ true, false, _Idx != error_enum_count<_Err>, _Idx };
+            }
+            else {
+                return _Match_handler_info{ true, false, false, 0 };
+            }
+        }();
+    };
+
+    template <class _Err, class _Fn>
+    struct _Match_handler_traits<_Err, _Match_other_errors_handler<_Fn>> {
+        static constexpr _Match_handler_info _Info{ true, true, false, 0 };
+    };
+
+    // Which handler each arm of the switch calls: arm 0 is the value, arm 1 + i the enumerator
+    // error_enum_values<E>[i], and the last arm any other value of E.
+    template <class _Err, class... _Handlers>
+    struct _Match_plan {
+        static constexpr size_t _Count = error_enum_count<_Err>;
+        static constexpr size_t _Arms  = _Count + 2;
+        static constexpr size_t _None  = sizeof...(_Handlers);
+
+        static constexpr array<_Match_handler_info, sizeof...(_Handlers)> _Infos = {
+            _Match_handler_traits<_Err, _Handlers>::_Info...
+        };
+
+        static constexpr bool _All_handlers = [] {
+            for (const _Match_handler_info& _Info : _Infos) {
+                if (!_Info._Is_handler) {
+                    return false;
+                }
+            }
+            return true;
+        }();
+
+        static constexpr bool _All_enumerators = [] {
+            for (const _Match_handler_info& _Info : _Infos) {
+                if (_Info._Is_handler && !_Info._Is_other && !_Info._Is_enumerator) {
+                    return false;
+                }
+            }
+            return true;
+        }();
+
+        static constexpr size_t _Other = [] {
+            size_t _Result = _None;
+            for (size_t _Pos = 0; _Pos < _Infos.size(); ++_Pos) {
+                if (_Infos[_Pos]._Is_other) {
+                    _Result = _Result == _None ? _Pos : _None + 1;
+                }
+            }
+            return _Result;
+        }();
+
+        // the handler of each enumerator that has one of its own, _None for those without, _None + 1 for those
+        // with several
+        static constexpr array<size_t, _Count> _Own_handlers = [] {
+            array<size_t, _Count> _Result{};
+            _Result.fill(_None);
+            for (size_t _Pos = 0; _Pos < _Infos.size(); ++_Pos) {
+                if (_Infos[_Pos]._Is_enumerator) {
+                    size_t& _Handler = _Result[_Infos[_Pos]._Index];
+                    _Handler         = _Handler == _None ? _Pos : _None + 1;
+                }
+            }
+            return _Result;
+        }();
+
+        static constexpr bool _Duplicates = [] {
+            for (const size_t _Handler : _Own_handlers) {
+                if (_Handler == _None + 1) {
+                    return true;
+                }
+            }
+            return false;
+        }();
+
+        static constexpr bool _Exhaustive = [] {
+            for (const size_t _Handler : _Own_handlers) {
+                if (_Handler == _None && _Other == _None) {
+                    return false;
+                }
+            }
+            return true;
+        }();
+
+        // the handler called by arm _Arm > 0; _None or more when that arm throws (or the call is ill-formed)
+        _NODISCARD static constexpr size_t _Handler_of(const size_t _Arm) noexcept {
+            if (_Arm <= _Count && _Own_handlers[_Arm - 1] != _None) {
+                return _Own_handlers[_Arm - 1];
+            }
+            return _Other;
+        }
+    };
+
+    template <size_t _Arm, class _Result, class _Plan, class _Expected, class _On_value, class _Handler_tuple>
+    constexpr _Result _Match_invoke_arm(_Expected&& _Exp, _On_value& _Value_handler, _Handler_tuple& _Handlers) {
+        if constexpr (_Arm == 0) {
+            if constexpr (is_void_v<typename remove_cvref_t<_Expected>::value_type>) {
+                return _STD invoke(_Value_handler);
+            }
+            else {
+                return _STD invoke(_Value_handler, *_STD forward<_Expected>(_Exp));
+            }
+        }
+        else if constexpr (constexpr size_t _Handler = _Plan::_Handler_of(_Arm); _Handler < _Plan::_None) {
+            return _STD experimental::_Match_invoke(_STD get<_Handler>(_Handlers)._Func, _STD forward<_Expected>(_Exp).error());
+        }
+        else {
+            _STD experimental::_Throw_bad_expected_access(_STD as_const(_Exp.error()));
+        }
+    }
+
+#define _EXPECTED_MATCH_CASE(_Idx)                                                                     \
+    case (_Idx):                                                                                       \
+        if constexpr ((_Idx) < _Plan::_Arms) {                                                         \
+            return _STD experimental::_Match_invoke_arm<(_Idx), _Result, _Plan>(                       \
+                _STD forward<_Expected>(_Exp), _Value_handler, _Handlers);                             \
+        }                                                                                              \
+        _EXPECTED_UNREACHABLE;                                                                         \
+        [[fallthrough]]
+
+#define _EXPECTED_MATCH_STAMP4(_Idx)   \
+    _EXPECTED_MATCH_CASE(_Idx);        \
+    _EXPECTED_MATCH_CASE((_Idx) + 1);  \
+    _EXPECTED_MATCH_CASE((_Idx) + 2);  \
+    _EXPECTED_MATCH_CASE((_Idx) + 3)
+#define _EXPECTED_MATCH_STAMP16(_Idx)   \
+    _EXPECTED_MATCH_STAMP4(_Idx);       \
+    _EXPECTED_MATCH_STAMP4((_Idx) + 4); \
+    _EXPECTED_MATCH_STAMP4((_Idx) + 8); \
+    _EXPECTED_MATCH_STAMP4((_Idx) + 12)
+#define _EXPECTED_MATCH_STAMP64(_Idx)     \
+    _EXPECTED_MATCH_STAMP16(_Idx);        \
+    _EXPECTED_MATCH_STAMP16((_Idx) + 16); \
+    _EXPECTED_MATCH_STAMP16((_Idx) + 32); \
+    _EXPECTED_MATCH_STAMP16((_Idx) + 48)
+#define _EXPECTED_MATCH_STAMP256(_Idx)     \
+    _EXPECTED_MATCH_STAMP64(_Idx);         \
+    _EXPECTED_MATCH_STAMP64((_Idx) + 64);  \
+    _EXPECTED_MATCH_STAMP64((_Idx) + 128); \
+    _EXPECTED_MATCH_STAMP64((_Idx) + 192)
+
+#define _EXPECTED_MATCH_SWITCH(_Stamp) \
+    switch (_Arm) {                    \
+        _Stamp(0);                     \
+    default:                           \
+        _EXPECTED_UNREACHABLE;         \
+    }
+
+    // one switch over every arm, stamped out to the smallest of 4, 16, 64 or 256 cases that holds them
+    template <class _Result, class _Plan, class _Expected, class _On_value, class _Handler_tuple>
+    constexpr _Result _Match_dispatch(
+        const size_t _Arm, _Expected&& _Exp, _On_value& _Value_handler, _Handler_tuple& _Handlers) {
+        if constexpr (_Plan::_Arms <= 4) {
+            _EXPECTED_MATCH_SWITCH(_EXPECTED_MATCH_STAMP4)
+        }
+        else if constexpr (_Plan::_Arms <= 16) {
+            _EXPECTED_MATCH_SWITCH(_EXPECTED_MATCH_STAMP16)
+        }
+        else if constexpr (_Plan::_Arms <= 64) {
+            _EXPECTED_MATCH_SWITCH(_EXPECTED_MATCH_STAMP64)
+        }
+        else {
+            _EXPECTED_MATCH_SWITCH(_EXPECTED_MATCH_STAMP256)
+        }
+    }
+
+#undef _EXPECTED_MATCH_SWITCH
+#undef _EXPECTED_MATCH_STAMP256
+#undef _EXPECTED_MATCH_STAMP64
+#undef _EXPECTED_MATCH_STAMP16
+#undef _EXPECTED_MATCH_STAMP4
+#undef _EXPECTED_MATCH_CASE
+
+    _EXPORT_STD template <class _Expected, class _On_value, class... _Handlers>
+        requires _Is_specialization_v<remove_cvref_t<_Expected>, expected>
+    constexpr _Match_result_t<_Expected, _On_value, _Handlers...> match(
+        _Expected&& _Exp, _On_value&& _Value_handler, _Handlers&&... _Error_handlers) {
+        using _Err  = typename remove_cvref_t<_Expected>::error_type;
+        using _Plan = _Match_plan<_Err, remove_cvref_t<_Handlers>...>;
+        static_assert(is_enum_v<_Err>, "match dispatches on the error code, so E must be an enum.");
+        static_assert(_Plan::_Arms <= 256, "match supports error enums of at most 254 enumerators.");
+        static_assert(_Plan::_All_handlers, "The handlers after on_value must be on_error<code>(f) or on_error(f).");
+        static_assert(_Plan::_All_enumerators, "on_error<code> requires an enumerator of the error type.");
+        static_assert(!_Plan::_Duplicates, "An enumerator has more than one on_error<code> handler.");
+        static_assert(_Plan::_Other <= _Plan::_None, "There may be at most one on_error(f) handler.");
+        static_assert(_Plan::_Exhaustive, "Every enumerator of the error type needs an on_error<code> handler, "
+                                          "unless there is an on_error(f) handler for the others.");
+
+        using _Result = _Match_result_t<_Expected, _On_value, _Handlers...>;
+
+        tuple<remove_reference_t<_Handlers>&...> _Handler_refs{ _Error_handlers... };
+        const size_t _Arm = _Exp.has_value() ? 0 : 1 + _STD experimental::error_enum_index(_Exp.error());
+        return _STD experimental::_Match_dispatch<_Result, _Plan>(
+            _Arm, _STD forward<_Expected>(_Exp), _Value_handler, _Handler_refs);
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_MATCH_
@@ -0,0 +1,396 @@
+#pragma once
+
+// expected_pipeline experimental header
+
+#ifndef _EXPECTED_PIPELINE_
+#define _EXPECTED_PIPELINE_
+#include "expected.h"
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [expected.pipeline] (extension)
+    // pipeline(_Src).then(f).map(g).map_error(h).recover(k).run() computes the same result as
+    // _Src.and_then(f).transform(g).transform_error(h).or_else(k), but in a single pass: no intermediate expected
+    // is built, has_value() is tested only where a stage can change it, and an error is forwarded by reference from
+    // the stage that produced it to the final result, into which it is moved (or, coming from an lvalue source,
+    // copied) exactly once. map_error and recover stages receive the error as an lvalue when it comes from an
+    // lvalue source and as an rvalue otherwise, so they should accept both.
+    // A pipeline refers to a source that is an lvalue, which must outlive it, and holds a source that is an rvalue,
+    // moved into it, so that auto _Pipe = pipeline(_Make()).map(g); does not dangle. It is consumed by run().
+    // Stages are stored by value, so prefer function objects to function pointers, which compilers do not
+    // reliably inline once stored.
+
+    enum class _Pipeline_kind { _Then, _Map, _Map_error, _Recover };
+
+    template <_Pipeline_kind _Kind, class _Fn>
+    struct _Pipeline_stage {
+        static constexpr _Pipeline_kind _Stage_kind = _Kind;
+
+        _Fn _Func;
+    };
+
+    // stands in for the value of an expected<void, E> on its way through the stages
+    struct _Pipeline_no_value {};
+
+    template <class _Fn, class _Val>
+    constexpr decltype(auto) _Pipeline_invoke(_Fn& _Func, _Val&& _Value) {
+        if constexpr (is_same_v<remove_cvref_t<_Val>, _Pipeline_no_value>) {
+            return _STD invoke(_Func);
+        }
+        else {
+            return _STD invoke(_Func, _STD forward<_Val>(_Value));
+        }
+    }
+
+    template <class _Fn, class _Val>
+    using _Pipeline_invoke_result_t = decltype(_STD experimental::_Pipeline_invoke(_STD declval<_Fn&>(), _STD declval<_Val>()));
+
+    template <class _Ty>
+    using _Pipeline_value_ref = conditional_t<is_void_v<_Ty>, _Pipeline_no_value, _Ty>&&;
+
+    // The value type after a map stage applied to a value of type _Ty. On a reference, as expected<T&, E>::transform
+    // gives it: an lvalue reference result stays a reference, any other result is a new value. On a value, where
+    // expected<T, E>::transform rejects a reference result, the stage copies the referenced value instead.
+    template <class _Ty, class _Fn, class _Val>
+    using _Pipeline_map_result_t =
+        conditional_t<is_reference_v<_Ty> && is_lvalue_reference_v<_Pipeline_invoke_result_t<_Fn, _Val>>,
+            _Pipeline_invoke_result_t<_Fn, _Val>, remove_cvref_t<_Pipeline_invoke_result_t<_Fn, _Val>>>;
+
+    // The type of run(): _Ty is the current value type, _Val the reference the next value stage receives, _Err the
+    // current error type
+    template <class _Ty, class _Val, class _Err, class... _Stages>
+    struct _Pipeline_result {
+        using type = expected<_Ty, _Err>;
+    };
+
+    template <class _Ty, class _Val, class _Err, class _Fn, class... _Rest>
+    struct _Pipeline_result<_Ty, _Val, _Err, _Pipeline_stage<_Pipeline_kind::_Then, _Fn>, _Rest...> {
+        using _Uty = remove_cvref_t<_Pipeline_invoke_result_t<_Fn, _Val>>;
+
+        static_assert(_Is_specialization_v<_Uty, expected>,
+            "pipeline then(F) requires the return type of F to be a specialization of expected.");
+        static_assert(is_same_v<typename _Uty::error_type, _Err>,
+            "pipeline then(F) requires the error type of the return type of F to be the current error type.");
+
+        using type = typename _Pipeline_result<typename _Uty::value_type,
+            _Pipeline_value_ref<typename _Uty::value_type>, _Err, _Rest...>::type;
+    };
+
+    template <class _Ty, class _Val, class _Err, class _Fn, class... _Rest>
+    struct _Pipeline_result<_Ty, _Val, _Err, _Pipeline_stage<_Pipeline_kind::_Map, _Fn>, _Rest...> {
+        using _Uty = _Pipeline_map_result_t<_Ty, _Fn, _Val>;
+
+        using type = typename _Pipeline_result<_Uty, _Pipeline_value_ref<_Uty>, _Err, _Rest...>::type;
+    };
+
+    template <class _Ty, class _Val, class _Err, class _Fn, class... _Rest>
+    struct _Pipeline_result<_Ty, _Val, _Err, _Pipeline_stage<_Pipeline_kind::_Map_error, _Fn>, _Rest...> {
+        using _Gty = remove_cv_t<invoke_result_t<_Fn&, _Err>>;
+
+        static_assert(_Check_unexpected_argument<_Gty>::value);
+
+        using type = typename _Pipeline_result<_Ty, _Val, _Gty, _Rest...>::type;
+    };
+
+    template <class _Ty, class _Val, class _Err, class _Fn, class... _Rest>
+    struct _Pipeline_result<_Ty, _Val, _Err, _Pipeline_stage<_Pipeline_kind::_Recover, _Fn>, _Rest...> {
+        using _Gty = remove_cvref_t<invoke_result_t<_Fn&, _Err>>;
+
+        static_assert(_Is_specialization_v<_Gty, expected>,
+            "pipeline recover(F) requires the return type of F to be a specialization of expected.");
+        static_assert(is_same_v<typename _Gty::value_type, _Ty>,
+            "pipeline recover(F) requires the value type of the return type of F to be the current value type.");
+
+        using type = typename _Pipeline_result<_Ty, _Val, typename _Gty::error_type, _Rest...>::type;
+    };
+
+    struct _Pipeline_construct_t {
+        explicit _Pipeline_construct_t() = default;
+    };
+
+    template <class... _Stages>
+    struct _Expected_adaptor;
+
+    template <class _Source, class... _Stages>
+    class _Expected_pipeline {
+    private:
+        using _Source_expected = remove_cvref_t<_Source>;
+        using _Source_value    = conditional_t<is_void_v<typename _Source_expected::value_type>, _Pipeline_no_value&&,
+            decltype(*_STD declval<_Source>())>;
+
+    public:
+        using result_type =
+            typename _Pipeline_result<typename _Source_expected::value_type, _Source_value,
+                typename _Source_expected::error_type, _Stages...>::type;
+
+        // and_then
+        template <class _Fn>
+        _NODISCARD constexpr auto then(_Fn&& _Func) && {
+            return _Append<_Pipeline_kind::_Then>(_STD forward<_Fn>(_Func));
+        }
+
+        // transform
+        template <class _Fn>
+        _NODISCARD constexpr auto map(_Fn&& _Func) && {
+            return _Append<_Pipeline_kind::_Map>(_STD forward<_Fn>(_Func));
+        }
+
+        // transform_error
+        template <class _Fn>
+        _NODISCARD constexpr auto map_error(_Fn&& _Func) && {
+            return _Append<_Pipeline_kind::_Map_error>(_STD forward<_Fn>(_Func));
+        }
+
+        // or_else
+        template <class _Fn>
+        _NODISCARD constexpr auto recover(_Fn&& _Func) && {
+            return _Append<_Pipeline_kind::_Recover>(_STD forward<_Fn>(_Func));
+        }
+
+        _NODISCARD constexpr result_type run() && {
+            if (_Src.has_value()) [[likely]] {
+                if constexpr (is_void_v<typename _Source_expected::value_type>) {
+                    return _Run_value<0>(_Pipeline_no_value{});
+                }
+                else {
+                    return _Run_value<0>(*_STD forward<_Source>(_Src));
+                }
+            }
+            else {
+                return _Run_error<0>(_STD forward<_Source>(_Src).error());
+            }
+        }
+
+        // lets e | and_then(f) | ... initialize or be returned as an expected
+        constexpr operator result_type() && {
+            return _STD move(*this).run();
+        }
+
+        template <class... _Added>
+        _NODISCARD friend constexpr _Expected_pipeline<_Source, _Stages..., _Added...> operator|(
+            _Expected_pipeline&& _Left, _Expected_adaptor<_Added...> _Right) {
+            return { _Pipeline_construct_t{}, _STD forward<_Source>(_Left._Src),
+                _STD tuple_cat(_STD move(_Left._Mystages), _STD move(_Right._Mystages)) };
+        }
+
+        constexpr _Expected_pipeline(_Pipeline_construct_t, _Source&& _Src_, tuple<_Stages...>&& _Stages_)
+            : _Src(_STD forward<_Source>(_Src_)), _Mystages(_STD move(_Stages_)) {}
+
+    private:
+        template <_Pipeline_kind _Kind, class _Fn>
+        constexpr auto _Append(_Fn&& _Func) {
+            using _New_stage = _Pipeline_stage<_Kind, decay_t<_Fn>>;
+            return _Expected_pipeline<_Source, _Stages..., _New_stage>{ _Pipeline_construct_t{},
+                _STD forward<_Source>(_Src),
+                _STD tuple_cat(_STD move(_Mystages), tuple<_New_stage>{ _New_stage{ _STD forward<_Fn>(_Func) } }) };
+        }
+
+        // Both walkers pass their argument on by reference; a value or error produced by a stage is a temporary
+        // that lives until the final result has been constructed from it.
+        template <size_t _Idx, class _Val>
+        constexpr result_type _Run_value(_Val&& _Value) {
+            if constexpr (_Idx == sizeof...(_Stages)) {
+                if constexpr (is_void_v<typename result_type::value_type>) {
+                    return result_type{};
+                }
+                else {
+                    return result_type{ in_place, _STD forward<_Val>(_Value) };
+                }
+            }
+            else {
+                auto& _Stage = _STD get<_Idx>(_Mystages);
+                constexpr _Pipeline_kind _Kind = remove_reference_t<decltype(_Stage)>::_Stage_kind;
+                if constexpr (_Kind == _Pipeline_kind::_Then) {
+                    auto _Res = _STD experimental::_Pipeline_invoke(_Stage._Func, _STD forward<_Val>(_Value));
+                    if (_Res.has_value()) [[likely]] {
+                        if constexpr (is_void_v<typename decltype(_Res)::value_type>) {
+                            return _Run_value<_Idx + 1>(_Pipeline_no_value{});
+                        }
+                        else {
+                            return _Run_value<_Idx + 1>(*_STD move(_Res));
+                        }
+                    }
+                    else {
+                        return _Run_error<_Idx + 1>(_STD move(_Res).error());
+                    }
+                }
+                else if constexpr (_Kind == _Pipeline_kind::_Map) {
+                    if constexpr (is_void_v<_Pipeline_invoke_result_t<decltype(_Stage._Func), _Val>>) {
+                        _STD experimental::_Pipeline_invoke(_Stage._Func, _STD forward<_Val>(_Value));
+                        return _Run_value<_Idx + 1>(_Pipeline_no_value{});
+                    }
+                    else if constexpr (_Next_value_stage<_Idx + 1>() == sizeof...(_Stages)
+                                       && !is_reference_v<typename result_type::value_type>) {
+                        // the last value stage: its result becomes the value of the result without a move
+                        if constexpr (is_same_v<remove_cvref_t<_Val>, _Pipeline_no_value>) {
+                            return result_type{ in_place_from, _Stage._Func };
+                        }
+                        else {
+                            return result_type{ in_place_from, _Stage._Func, _STD forward<_Val>(_Value) };
+                        }
+                    }
+                    else {
+                        return _Run_value<_Idx + 1>(
+                            _STD experimental::_Pipeline_invoke(_Stage._Func, _STD forward<_Val>(_Value)));
+                    }
+                }
+                else { // map_error and recover only see errors
+                    return _Run_value<_Idx + 1>(_STD forward<_Val>(_Value));
+                }
+            }
+        }
+
+        // the index of the first then or map stage at or after _Idx, or sizeof...(_Stages)
+        template <size_t _Idx>
+        static constexpr size_t _Next_value_stage() {
+            if constexpr (_Idx == sizeof...(_Stages)) {
+                return _Idx;
+            }
+            else if constexpr (tuple_element_t<_Idx, tuple<_Stages...>>::_Stage_kind == _Pipeline_kind::_Then
+                               || tuple_element_t<_Idx, tuple<_Stages...>>::_Stage_kind == _Pipeline_kind::_Map) {
+                return _Idx;
+            }
+            else {
+                return _Next_value_stage<_Idx + 1>();
+            }
+        }
+
+        // the index of the first map_error or recover stage at or after _Idx, or sizeof...(_Stages)
+        template <size_t _Idx>
+        static constexpr size_t _Next_error_stage() {
+            if constexpr (_Idx == sizeof...(_Stages)) {
+                return _Idx;
+            }
+            else if constexpr (tuple_element_t<_Idx, tuple<_Stages...>>::_Stage_kind == _Pipeline_kind::_Then
+                               || tuple_element_t<_Idx, tuple<_Stages...>>::_Stage_kind == _Pipeline_kind::_Map) {
+                return _Next_error_stage<_Idx + 1>();
+            }
+            else {
+                return _Idx;
+            }
+        }
+
+        // Every stage that can fail continues here, so each error stage is emitted once and shared by all of
+        // them instead of being inlined at every failure point.
+        template <size_t _Idx, class _Errv>
+        constexpr result_type _Run_error(_Errv&& _Error) {
+            constexpr size_t _Next = _Next_error_stage<_Idx>();
+            if constexpr (_Next == sizeof...(_Stages)) {
+                return result_type{ _EXPECTED_UNTRACKED(unexpect), _STD forward<_Errv>(_Error) };
+            }
+            else {
+                return _Run_error_stage<_Next>(_STD forward<_Errv>(_Error));
+            }
+        }
+
+        template <size_t _Idx, class _Errv>
+        _EXPECTED_NOINLINE constexpr result_type _Run_error_stage(_Errv&& _Error) {
+            auto& _Stage = _STD get<_Idx>(_Mystages);
+            if constexpr (remove_reference_t<decltype(_Stage)>::_Stage_kind == _Pipeline_kind::_Map_error) {
+                if constexpr (_Next_error_stage<_Idx + 1>() == sizeof...(_Stages)) {
+                    // the last error stage: its result becomes the error of the result without a move
+                    return result_type{ unexpect_from, _Stage._Func, _STD forward<_Errv>(_Error) };
+                }
+                else {
+                    return _Run_error<_Idx + 1>(_STD invoke(_Stage._Func, _STD forward<_Errv>(_Error)));
+                }
+            }
+            else {
+                auto _Res = _STD invoke(_Stage._Func, _STD forward<_Errv>(_Error));
+                if (_Res.has_value()) {
+                    if constexpr (is_void_v<typename decltype(_Res)::value_type>) {
+                        return _Run_value<_Idx + 1>(_Pipeline_no_value{});
+                    }
+                    else {
+                        return _Run_value<_Idx + 1>(*_STD move(_Res));
+                    }
+                }
+                else {
+                    return _Run_error<_Idx + 1>(_STD move(_Res).error());
+                }
+            }
+        }
+
+        _Source _Src; // _Ty& for an lvalue source, _Ty for an rvalue one
+        tuple<_Stages...> _Mystages;
+    };
+
+    _EXPORT_STD template <class _Source>
+    _NODISCARD constexpr _Expected_pipeline<_Source> pipeline(_Source&& _Src) noexcept(
+        is_nothrow_constructible_v<_Source, _Source>) {
+        static_assert(_Is_specialization_v<remove_cvref_t<_Source>, expected>,
+            "pipeline(e) requires e to be a specialization of expected.");
+        return _Expected_pipeline<_Source>{ _Pipeline_construct_t{}, _STD forward<_Source>(_Src), tuple<>{} };
+    }
+
+    // [expected.pipe] (extension)
+    // e | and_then(f) | transform(g) | transform_error(h) | or_else(k) builds pipeline(e) with those stages, so the
+    // chain is evaluated in a single pass as described above. Adaptors also compose on their own:
+    // auto _Steps = and_then(f) | transform(g); e | _Steps | _Steps. The expression converts to the expected it
+    // computes (or call run() on it), and like a pipeline it refers to e when e is an lvalue and holds it otherwise.
+    template <class... _Stages>
+    struct _Expected_adaptor {
+        tuple<_Stages...> _Mystages;
+
+        template <class _Source>
+            requires _Is_specialization_v<remove_cvref_t<_Source>, expected>
+        _NODISCARD friend constexpr _Expected_pipeline<_Source, _Stages...> operator|(
+            _Source&& _Left, _Expected_adaptor _Right) {
+            return { _Pipeline_construct_t{}, _STD forward<_Source>(_Left), _STD move(_Right._Mystages) };
+        }
+
+        template <class... _Added>
+        _NODISCARD friend constexpr _Expected_adaptor<_Stages..., _Added...> operator|(
+            _Expected_adaptor _Left, _Expected_adaptor<_Added...> _Right) {
+            return { _STD tuple_cat(_STD move(_Left._Mystages), _STD move(_Right._Mystages)) };
+        }
+    };
+
+    template <_Pipeline_kind _Kind, class _Fn>
+    constexpr _Expected_adaptor<_Pipeline_stage<_Kind, decay_t<_Fn>>> _Make_expected_adaptor(_Fn&& _Func) {
+        return { tuple<_Pipeline_stage<_Kind, decay_t<_Fn>>>{ { _STD forward<_Fn>(_Func) } } };
+    }
+
+    _EXPORT_STD template <class _Fn>
+    _NODISCARD constexpr auto and_then(_Fn&& _Func) {
+        return _STD experimental::_Make_expected_adaptor<_Pipeline_kind::_Then>(_STD forward<_Fn>(_Func));
+    }
+
+    _EXPORT_STD template <class _Fn>
+    _NODISCARD constexpr auto transform(_Fn&& _Func) {
+        return _STD experimental::_Make_expected_adaptor<_Pipeline_kind::_Map>(_STD forward<_Fn>(_Func));
+    }
+
+    _EXPORT_STD template <class _Fn>
+    _NODISCARD constexpr auto transform_error(_Fn&& _Func) {
+        return _STD experimental::_Make_expected_adaptor<_Pipeline_kind::_Map_error>(_STD forward<_Fn>(_Func));
+    }
+
+    _EXPORT_STD template <class _Fn>
+    _NODISCARD constexpr auto or_else(_Fn&& _Func) {
+        return _STD experimental::_Make_expected_adaptor<_Pipeline_kind::_Recover>(_STD forward<_Fn>(_Func));
+    }
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_PIPELINE_
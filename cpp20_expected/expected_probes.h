@@ -0,0 +1,140 @@
+#pragma once
+
+// expected_probes experimental header
+
+#ifndef _EXPECTED_PROBES_
+#define _EXPECTED_PROBES_
+#include "expected_config.h"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+// [expected.probes] (extension)
+// With _EXPECTED_PROBES defined to 1 before expected.h is included, the error-state constructors of expected,
+// the constructors of unexpected and the failure path of value() contain USDT probes, the static tracepoints of
+// <sys/sdt.h>, which bpftrace, perf and SystemTap attach to in a running program:
+//   cpp20_expected:unexpected      an unexpected was constructed
+//   cpp20_expected:expected_error  an expected was constructed holding an error (this includes errors carried
+//                                  along by and_then and or_else, which construct a new expected)
+//   cpp20_expected:bad_access      value() is about to throw, or fail, with bad_expected_access
+// Each probe has three arguments: the name of the error type (a string), the address of the error, and its value
+// converted to long long when it is of integral or enum type, 0 otherwise. For example:
+//   bpftrace -e 'usdt:./server:cpp20_expected:unexpected { @[str(arg0), arg2] = count(); }'
+// A probe nobody is attached to is a nop; its arguments are left in registers or memory that the nop does not
+// read. The probes are described by .note.stapsdt ELF notes, so they exist only with GCC or Clang on ELF targets
+// (x86-64 and AArch64); elsewhere _EXPECTED_PROBES has no effect.
+
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__aarch64__))
+#define _EXPECTED_HAS_USDT 1
+#else // ^^^ ELF, GCC or Clang, x86-64 or AArch64 / other vvv
+#define _EXPECTED_HAS_USDT 0
+#endif // ^^^ other ^^^
+
+#if _EXPECTED_HAS_USDT
+// One probe in the v3 format of <sys/sdt.h>: a nop, and a note naming it with the address of the nop and the
+// location of each argument. The note joins the section group of the function (the "?" flags), so that it is
+// discarded together with the duplicate copies of an inline function.
+#define _EXPECTED_USDT_PROBE(_Name, _Type, _Addr, _Value)                                 \
+    __asm__ __volatile__("990: nop\n"                                                     \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n"                    \
+                         ".balign 4\n"                                                    \
+                         ".4byte 992f-991f, 994f-993f, 3\n"                               \
+                         "991: .asciz \"stapsdt\"\n"                                      \
+                         "992: .balign 4\n"                                               \
+                         "993: .8byte 990b\n"                                             \
+                         ".8byte _.stapsdt.base\n"                                        \
+                         ".8byte 0\n"                                                     \
+                         ".asciz \"cpp20_expected\"\n"                                    \
+                         ".asciz \"" #_Name "\"\n"                                        \
+                         ".asciz \"8@%[_Probe_type] 8@%[_Probe_addr] -8@%[_Probe_value]\"\n" \
+                         "994: .balign 4\n"                                               \
+                         ".popsection\n"                                                  \
+                         ".ifndef _.stapsdt.base\n"                                       \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                         ".weak _.stapsdt.base\n"                                         \
+                         ".hidden _.stapsdt.base\n"                                       \
+                         "_.stapsdt.base: .space 1\n"                                     \
+                         ".size _.stapsdt.base, 1\n"                                      \
+                         ".popsection\n"                                                  \
+                         ".endif\n"                                                       \
+                         :                                                                \
+                         : [_Probe_type] "nor"(_Type), [_Probe_addr] "nor"(_Addr),        \
+                         [_Probe_value] "nor"(_Value))
+#endif // _EXPECTED_HAS_USDT
+
+namespace std::experimental {
+
+    // The name of _Ty as the compiler spells it, as a null-terminated array
+    template <class _Ty>
+    _NODISCARD consteval string_view _Probe_type_name_view() noexcept {
+        constexpr string_view _Sig   = __PRETTY_FUNCTION__;
+        constexpr size_t _First      = _Sig.find("_Ty = ") + 6;
+        constexpr size_t _Last       = _Sig.find_first_of(";]", _First);
+        return _Sig.substr(_First, _Last - _First);
+    }
+
+    template <class _Ty>
+    inline constexpr auto _Probe_type_name = [] {
+        constexpr string_view _Name = _Probe_type_name_view<_Ty>();
+        array<char, _Name.size() + 1> _Result{};
+        for (size_t _Idx = 0; _Idx < _Name.size(); ++_Idx) {
+            _Result[_Idx] = _Name[_Idx];
+        }
+        _Result[_Name.size()] = '\0'; // assigned, not only value-initialized: GCC 12 rejects reading it otherwise
+        return _Result;
+    }();
+
+    template <class _Err>
+    _NODISCARD constexpr long long _Probe_value(const _Err& _Error) noexcept {
+        if constexpr (is_integral_v<_Err> || is_enum_v<_Err>) {
+            return static_cast<long long>(_Error);
+        }
+        else {
+            (void) _Error;
+            return 0;
+        }
+    }
+
+#if _EXPECTED_HAS_USDT
+#define _EXPECTED_DEFINE_PROBE(_Name)                                                                     \
+    template <class _Err>                                                                                 \
+    __attribute__((always_inline)) constexpr void _Probe_##_Name(const _Err& _Error) noexcept {           \
+        if (!_STD is_constant_evaluated()) {                                                              \
+            _EXPECTED_USDT_PROBE(_Name, _Probe_type_name<_Err>.data(), _STD addressof(_Error),             \
+                _STD experimental::_Probe_value(_Error));                                                  \
+        }                                                                                                 \
+    }
+#else // ^^^ USDT / no USDT vvv
+#define _EXPECTED_DEFINE_PROBE(_Name)                             \
+    template <class _Err>                                         \
+    constexpr void _Probe_##_Name(const _Err&) noexcept {}
+#endif // ^^^ no USDT ^^^
+
+    _EXPECTED_DEFINE_PROBE(unexpected)
+    _EXPECTED_DEFINE_PROBE(expected_error)
+    _EXPECTED_DEFINE_PROBE(bad_access)
+
+#undef _EXPECTED_DEFINE_PROBE
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_PROBES_
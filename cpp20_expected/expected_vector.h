@@ -0,0 +1,524 @@
+#pragma once
+
+// expected_vector experimental header
+
+#ifndef _EXPECTED_VECTOR_
+#define _EXPECTED_VECTOR_
+#include "expected.h"
+#include "relocating_vector.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifndef _USE_EXPECTED_VECTOR_ALGORITHMS
+#define _USE_EXPECTED_VECTOR_ALGORITHMS 1
+#endif // _USE_EXPECTED_VECTOR_ALGORITHMS
+
+#if _USE_EXPECTED_VECTOR_ALGORITHMS && defined(__AVX2__)
+#define _EXPECTED_VECTOR_AVX2 1
+#include <immintrin.h>
+#elif _USE_EXPECTED_VECTOR_ALGORITHMS \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define _EXPECTED_VECTOR_SSE2 1
+#include <emmintrin.h>
+#endif // ^^^ SSE2 ^^^
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // Bitmap kernels over _Count 64-bit words. Bits past the logical end must be zero.
+    // The vector paths are selected at compile time from the target ISA (/arch:AVX2 or -mavx2 for AVX2).
+    _NODISCARD inline size_t _Bitmap_count_ones(const uint64_t* const _Words, const size_t _Count) noexcept {
+        size_t _Idx = 0;
+        size_t _Result = 0;
+#if defined(_EXPECTED_VECTOR_AVX2)
+        // nibble lookup table population count (Mula), summed per 64-bit lane by vpsadbw
+        const __m256i _Lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i _Low_nibbles = _mm256_set1_epi8(0x0f);
+        __m256i _Acc = _mm256_setzero_si256();
+        for (; _Idx + 4 <= _Count; _Idx += 4) {
+            const __m256i _Vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_Words + _Idx));
+            const __m256i _Lo = _mm256_and_si256(_Vec, _Low_nibbles);
+            const __m256i _Hi = _mm256_and_si256(_mm256_srli_epi16(_Vec, 4), _Low_nibbles);
+            const __m256i _Bytes =
+                _mm256_add_epi8(_mm256_shuffle_epi8(_Lookup, _Lo), _mm256_shuffle_epi8(_Lookup, _Hi));
+            _Acc = _mm256_add_epi64(_Acc, _mm256_sad_epu8(_Bytes, _mm256_setzero_si256()));
+        }
+
+        alignas(32) uint64_t _Lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(_Lanes), _Acc);
+        _Result = static_cast<size_t>(_Lanes[0] + _Lanes[1] + _Lanes[2] + _Lanes[3]);
+#elif defined(_EXPECTED_VECTOR_SSE2) && !defined(__POPCNT__)
+        // without a popcnt instruction, a SWAR count two words at a time beats the scalar fallback
+        const __m128i _Mask1 = _mm_set1_epi8(0x55);
+        const __m128i _Mask2 = _mm_set1_epi8(0x33);
+        const __m128i _Mask4 = _mm_set1_epi8(0x0f);
+        __m128i _Acc = _mm_setzero_si128();
+        for (; _Idx + 2 <= _Count; _Idx += 2) {
+            __m128i _Vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_Words + _Idx));
+            _Vec = _mm_sub_epi8(_Vec, _mm_and_si128(_mm_srli_epi64(_Vec, 1), _Mask1));
+            _Vec = _mm_add_epi8(_mm_and_si128(_Vec, _Mask2), _mm_and_si128(_mm_srli_epi64(_Vec, 2), _Mask2));
+            _Vec = _mm_and_si128(_mm_add_epi8(_Vec, _mm_srli_epi64(_Vec, 4)), _Mask4);
+            _Acc = _mm_add_epi64(_Acc, _mm_sad_epu8(_Vec, _mm_setzero_si128()));
+        }
+
+        alignas(16) uint64_t _Lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(_Lanes), _Acc);
+        _Result = static_cast<size_t>(_Lanes[0] + _Lanes[1]);
+#endif // ^^^ SSE2 ^^^
+        for (; _Idx < _Count; ++_Idx) {
+            _Result += static_cast<size_t>(_STD popcount(_Words[_Idx]));
+        }
+
+        return _Result;
+    }
+
+    // Returns the index of the first set bit at or after bit _First, or _Count * 64 when there is none.
+    _NODISCARD inline size_t _Bitmap_find_first_one(
+        const uint64_t* const _Words, const size_t _Count, const size_t _First) noexcept {
+        size_t _Idx = _First / 64;
+        if (_Idx >= _Count) {
+            return _Count * 64;
+        }
+
+        const uint64_t _Head = _Words[_Idx] & (~uint64_t{0} << (_First % 64));
+        if (_Head != 0) {
+            return _Idx * 64 + static_cast<size_t>(_STD countr_zero(_Head));
+        }
+
+        ++_Idx;
+#if defined(_EXPECTED_VECTOR_AVX2)
+        for (; _Idx + 4 <= _Count; _Idx += 4) {
+            const __m256i _Vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_Words + _Idx));
+            if (!_mm256_testz_si256(_Vec, _Vec)) {
+                break;
+            }
+        }
+#elif defined(_EXPECTED_VECTOR_SSE2)
+        for (; _Idx + 2 <= _Count; _Idx += 2) {
+            const __m128i _Vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_Words + _Idx));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_Vec, _mm_setzero_si128())) != 0xFFFF) {
+                break;
+            }
+        }
+#endif // ^^^ SSE2 ^^^
+        for (; _Idx < _Count; ++_Idx) {
+            if (_Words[_Idx] != 0) {
+                return _Idx * 64 + static_cast<size_t>(_STD countr_zero(_Words[_Idx]));
+            }
+        }
+
+        return _Count * 64;
+    }
+
+    _NODISCARD inline bool _Bitmap_none(const uint64_t* const _Words, const size_t _Count) noexcept {
+        size_t _Idx = 0;
+#if defined(_EXPECTED_VECTOR_AVX2)
+        // OR 1024 bits together before each test to keep the early exit off the critical path
+        for (; _Idx + 16 <= _Count; _Idx += 16) {
+            const __m256i* const _Ptr = reinterpret_cast<const __m256i*>(_Words + _Idx);
+            const __m256i _Vec = _mm256_or_si256(_mm256_or_si256(_mm256_loadu_si256(_Ptr), _mm256_loadu_si256(_Ptr + 1)),
+                _mm256_or_si256(_mm256_loadu_si256(_Ptr + 2), _mm256_loadu_si256(_Ptr + 3)));
+            if (!_mm256_testz_si256(_Vec, _Vec)) {
+                return false;
+            }
+        }
+#elif defined(_EXPECTED_VECTOR_SSE2)
+        for (; _Idx + 8 <= _Count; _Idx += 8) {
+            const __m128i* const _Ptr = reinterpret_cast<const __m128i*>(_Words + _Idx);
+            const __m128i _Vec = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(_Ptr), _mm_loadu_si128(_Ptr + 1)),
+                _mm_or_si128(_mm_loadu_si128(_Ptr + 2), _mm_loadu_si128(_Ptr + 3)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_Vec, _mm_setzero_si128())) != 0xFFFF) {
+                return false;
+            }
+        }
+#endif // ^^^ SSE2 ^^^
+        uint64_t _Any = 0;
+        for (; _Idx < _Count; ++_Idx) {
+            _Any |= _Words[_Idx];
+        }
+
+        return _Any == 0;
+    }
+
+    template <class _Err>
+    struct _Expected_vector_error_entry {
+        template <class... _Args>
+        explicit _Expected_vector_error_entry(const size_t _Idx, _Args&&... _Vals) noexcept(
+            is_nothrow_constructible_v<_Err, _Args...>)
+            : _Index(_Idx), _Error(_STD forward<_Args>(_Vals)...) {}
+
+        size_t _Index;
+        _Err _Error;
+    };
+
+    template <class _Err>
+    struct is_trivially_relocatable<_Expected_vector_error_entry<_Err>> : is_trivially_relocatable<_Err>::type {};
+
+    // [expected.vector] (extension)
+    // A sequence of expected<_Ty, _Err> stored as a structure of arrays: one slot per element in a dense value
+    // array (unused by errors), the errors in a side table sorted by index, and a bitmap with one bit set per
+    // error. count_errors(), find_first_error() and all_ok() scan only the bitmap.
+    _EXPORT_STD template <class _Ty, class _Err>
+        class expected_vector {
+        static_assert(is_object_v<_Ty> && !is_const_v<_Ty> && !is_volatile_v<_Ty>,
+            "expected_vector requires a non-const, non-volatile object value type.");
+        static_assert(_Check_expected_argument<_Ty>::value);
+        static_assert(_Check_unexpected_argument<_Err>::value);
+
+        using _Entry = _Expected_vector_error_entry<_Err>;
+
+        public:
+            using value_type = expected<_Ty, _Err>;
+            using size_type = size_t;
+
+            expected_vector() noexcept = default;
+
+            expected_vector(const expected_vector& _Other)
+                : _Errors(_Other._Errors), _Errbits(_Other._Errbits) {
+                if (_Other._Mysize != 0) {
+                    _Value_guard _Newvals{_Errbits.data(), allocator<_Ty>{}.allocate(_Other._Mysize), _Other._Mysize, 0};
+                    _For_each_value_index(_Errbits.data(), _Other._Mysize, [&](const size_type _Idx) {
+                        _STD construct_at(_Newvals._Buf + _Idx, _Other._Myvalues[_Idx]);
+                        _Newvals._Last = _Idx + 1;
+                    });
+
+                    _Myvalues = _STD exchange(_Newvals._Buf, nullptr);
+                    _Mysize = _Other._Mysize;
+                    _Mycapacity = _Other._Mysize;
+                }
+            }
+
+            expected_vector(expected_vector&& _Other) noexcept
+                : _Errors(_STD move(_Other._Errors)), _Errbits(_STD move(_Other._Errbits)),
+                _Myvalues(_STD exchange(_Other._Myvalues, nullptr)), _Mysize(_STD exchange(_Other._Mysize, 0)),
+                _Mycapacity(_STD exchange(_Other._Mycapacity, 0)) {}
+
+            expected_vector& operator=(const expected_vector& _Other) {
+                if (this != _STD addressof(_Other)) {
+                    expected_vector _Tmp(_Other);
+                    swap(_Tmp);
+                }
+
+                return *this;
+            }
+
+            expected_vector& operator=(expected_vector&& _Other) noexcept {
+                if (this != _STD addressof(_Other)) {
+                    expected_vector _Tmp(_STD move(_Other));
+                    swap(_Tmp);
+                }
+
+                return *this;
+            }
+
+            ~expected_vector() {
+                _Tidy_values();
+            }
+
+            _NODISCARD bool empty() const noexcept {
+                return _Mysize == 0;
+            }
+            _NODISCARD size_type size() const noexcept {
+                return _Mysize;
+            }
+            _NODISCARD size_type capacity() const noexcept {
+                return _Mycapacity;
+            }
+
+            void reserve(const size_type _Newcapacity) {
+                if (_Newcapacity > _Mycapacity) {
+                    _Errbits.reserve(_Words_for(_Newcapacity));
+                    _Reallocate_values(_Newcapacity);
+                }
+            }
+
+            void clear() noexcept {
+                _Destroy_values(_Errbits.data(), _Myvalues, _Mysize);
+                _Errors.clear();
+                _Errbits.clear();
+                _Mysize = 0;
+            }
+
+            _NODISCARD bool has_value(const size_type _Idx) const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Idx < _Mysize, "expected_vector index out of range");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return (_Errbits[_Idx / 64] & (uint64_t{1} << (_Idx % 64))) == 0;
+            }
+
+            // Preconditions: has_value(_Idx)
+            _NODISCARD _Ty& value(const size_type _Idx) noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(has_value(_Idx), "expected_vector::value() called on an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return _Myvalues[_Idx];
+            }
+            _NODISCARD const _Ty& value(const size_type _Idx) const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(has_value(_Idx), "expected_vector::value() called on an error");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return _Myvalues[_Idx];
+            }
+
+            // Preconditions: !has_value(_Idx)
+            _NODISCARD _Err& error(const size_type _Idx) noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(!has_value(_Idx), "expected_vector::error() called on a value");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return _Find_error(_Idx)->_Error;
+            }
+            _NODISCARD const _Err& error(const size_type _Idx) const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(!has_value(_Idx), "expected_vector::error() called on a value");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return const_cast<expected_vector*>(this)->_Find_error(_Idx)->_Error;
+            }
+
+            _NODISCARD expected<_Ty, _Err> get(const size_type _Idx) const {
+                if (has_value(_Idx)) {
+                    return expected<_Ty, _Err>{ in_place, _Myvalues[_Idx] };
+                }
+                else {
+                    return expected<_Ty, _Err>{ _EXPECTED_UNTRACKED(unexpect), error(_Idx) };
+                }
+            }
+
+            template <class... _Args>
+            void emplace_back(_Args&&... _Vals) {
+                _Reserve_one_more();
+                _STD construct_at(_Myvalues + _Mysize, _STD forward<_Args>(_Vals)...);
+                if (_Mysize % 64 == 0) {
+                    _Errbits.push_back(0);
+                }
+                ++_Mysize;
+            }
+
+            template <class... _Args>
+            void emplace_back(unexpect_t, _Args&&... _Vals) {
+                _Reserve_one_more();
+                _Errors.emplace_back(_Mysize, _STD forward<_Args>(_Vals)...);
+                if (_Mysize % 64 == 0) {
+                    _Errbits.push_back(0);
+                }
+                _Errbits[_Mysize / 64] |= uint64_t{1} << (_Mysize % 64);
+                ++_Mysize;
+            }
+
+            void push_back(const expected<_Ty, _Err>& _Val) {
+                if (_Val.has_value()) {
+                    emplace_back(*_Val);
+                }
+                else {
+                    emplace_back(unexpect, _Val.error());
+                }
+            }
+
+            void push_back(expected<_Ty, _Err>&& _Val) {
+                if (_Val.has_value()) {
+                    emplace_back(_STD move(*_Val));
+                }
+                else {
+                    emplace_back(unexpect, _STD move(_Val.error()));
+                }
+            }
+
+            void pop_back() noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Mysize != 0, "pop_back() called on empty expected_vector");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                const size_type _Idx = _Mysize - 1;
+                if (has_value(_Idx)) {
+                    _STD destroy_at(_Myvalues + _Idx);
+                }
+                else {
+                    _Errors.pop_back();
+                    _Errbits[_Idx / 64] &= ~(uint64_t{1} << (_Idx % 64));
+                }
+
+                if (_Idx % 64 == 0) {
+                    _Errbits.pop_back();
+                }
+                _Mysize = _Idx;
+            }
+
+            // Replaces element _Idx; a change of alternative moves the element between the value array and the
+            // error table
+            template <class _Uty>
+                requires is_same_v<remove_cvref_t<_Uty>, expected<_Ty, _Err>>
+            void set(const size_type _Idx, _Uty&& _Val) {
+                if (has_value(_Idx)) {
+                    if (_Val.has_value()) {
+                        _Myvalues[_Idx] = *_STD forward<_Uty>(_Val);
+                    }
+                    else {
+                        _Errors.emplace(_Lower_bound_error(_Idx), _Idx, _STD forward<_Uty>(_Val).error());
+                        _STD destroy_at(_Myvalues + _Idx);
+                        _Errbits[_Idx / 64] |= uint64_t{1} << (_Idx % 64);
+                    }
+                }
+                else {
+                    _Entry* const _Where = _Find_error(_Idx);
+                    if (_Val.has_value()) {
+                        _STD construct_at(_Myvalues + _Idx, *_STD forward<_Uty>(_Val));
+                        _Errors.erase(_Where);
+                        _Errbits[_Idx / 64] &= ~(uint64_t{1} << (_Idx % 64));
+                    }
+                    else {
+                        _Where->_Error = _STD forward<_Uty>(_Val).error();
+                    }
+                }
+            }
+
+            _NODISCARD size_type count_errors() const noexcept {
+                return _Bitmap_count_ones(_Errbits.data(), _Errbits.size());
+            }
+
+            // Returns the index of the first error at or after _First, or size() when there is none
+            _NODISCARD size_type find_first_error(const size_type _First = 0) const noexcept {
+                return (_STD min)(_Bitmap_find_first_one(_Errbits.data(), _Errbits.size(), _First), _Mysize);
+            }
+
+            _NODISCARD bool all_ok() const noexcept {
+                return _Bitmap_none(_Errbits.data(), _Errbits.size());
+            }
+
+            void swap(expected_vector& _Other) noexcept {
+                _Errors.swap(_Other._Errors);
+                _Errbits.swap(_Other._Errbits);
+                _STD swap(_Myvalues, _Other._Myvalues);
+                _STD swap(_Mysize, _Other._Mysize);
+                _STD swap(_Mycapacity, _Other._Mycapacity);
+            }
+
+            friend void swap(expected_vector& _Left, expected_vector& _Right) noexcept {
+                _Left.swap(_Right);
+            }
+
+        private:
+            _NODISCARD static constexpr size_type _Words_for(const size_type _Count) noexcept {
+                return (_Count + 63) / 64;
+            }
+
+            // calls _Func(_Idx) for every index below _Count whose bit in _Bits is clear, in increasing order
+            template <class _Fn>
+            static void _For_each_value_index(const uint64_t* const _Bits, const size_type _Count, _Fn _Func) {
+                for (size_type _Word = 0; _Word < _Words_for(_Count); ++_Word) {
+                    uint64_t _Live = ~_Bits[_Word];
+                    const size_type _Remaining = _Count - _Word * 64;
+                    if (_Remaining < 64) {
+                        _Live &= (uint64_t{1} << _Remaining) - 1;
+                    }
+
+                    for (; _Live != 0; _Live &= _Live - 1) {
+                        _Func(_Word * 64 + static_cast<size_type>(_STD countr_zero(_Live)));
+                    }
+                }
+            }
+
+            static void _Destroy_values(const uint64_t* const _Bits, _Ty* const _Buf, const size_type _Count) noexcept {
+                if constexpr (!is_trivially_destructible_v<_Ty>) {
+                    _For_each_value_index(_Bits, _Count, [_Buf](const size_type _Idx) { _STD destroy_at(_Buf + _Idx); });
+                }
+            }
+
+            struct _NODISCARD _Value_guard { // destroys the values below _Last in a new buffer, then frees it
+                ~_Value_guard() {
+                    if (_Buf) {
+                        _Destroy_values(_Bits, _Buf, _Last);
+                        allocator<_Ty>{}.deallocate(_Buf, _Capacity);
+                    }
+                }
+                const uint64_t* _Bits;
+                _Ty* _Buf;
+                size_type _Capacity;
+                size_type _Last;
+            };
+
+            void _Reallocate_values(const size_type _Newcapacity) {
+                _Value_guard _Newvals{_Errbits.data(), allocator<_Ty>{}.allocate(_Newcapacity), _Newcapacity, 0};
+                if constexpr (is_trivially_relocatable_v<_Ty>) {
+                    // the slots of errors hold no object, but copying their bytes along is harmless
+                    if (_Mysize != 0) {
+                        _CSTD memcpy(static_cast<void*>(_Newvals._Buf), static_cast<const void*>(_Myvalues),
+                            _Mysize * sizeof(_Ty));
+                    }
+                }
+                else if constexpr (is_nothrow_move_constructible_v<_Ty> || !is_copy_constructible_v<_Ty>) {
+                    _For_each_value_index(_Errbits.data(), _Mysize, [&](const size_type _Idx) {
+                        _STD construct_at(_Newvals._Buf + _Idx, _STD move(_Myvalues[_Idx]));
+                        _STD destroy_at(_Myvalues + _Idx);
+                    });
+                }
+                else {
+                    _For_each_value_index(_Errbits.data(), _Mysize, [&](const size_type _Idx) {
+                        _STD construct_at(_Newvals._Buf + _Idx, _Myvalues[_Idx]);
+                        _Newvals._Last = _Idx + 1;
+                    });
+                    _Destroy_values(_Errbits.data(), _Myvalues, _Mysize);
+                }
+
+                if (_Myvalues) {
+                    allocator<_Ty>{}.deallocate(_Myvalues, _Mycapacity);
+                }
+                _Myvalues = _STD exchange(_Newvals._Buf, nullptr);
+                _Mycapacity = _Newcapacity;
+            }
+
+            void _Reserve_one_more() {
+                if (_Mysize == _Mycapacity) {
+                    reserve((_STD max)(_Mysize + 1, _Mycapacity + _Mycapacity / 2));
+                }
+                else if (_Mysize % 64 == 0) {
+                    _Errbits.reserve(_Words_for(_Mysize + 1));
+                }
+            }
+
+            _NODISCARD _Entry* _Lower_bound_error(const size_type _Idx) noexcept {
+                return _STD lower_bound(_Errors.begin(), _Errors.end(), _Idx,
+                    [](const _Entry& _Left, const size_type _Right) { return _Left._Index < _Right; });
+            }
+
+            _NODISCARD _Entry* _Find_error(const size_type _Idx) noexcept {
+                _Entry* const _Where = _Lower_bound_error(_Idx);
+                _STL_VERIFY(_Where != _Errors.end() && _Where->_Index == _Idx, "expected_vector error table corrupted");
+                return _Where;
+            }
+
+            void _Tidy_values() noexcept {
+                if (_Myvalues) {
+                    _Destroy_values(_Errbits.data(), _Myvalues, _Mysize);
+                    allocator<_Ty>{}.deallocate(_Myvalues, _Mycapacity);
+                    _Myvalues = nullptr;
+                }
+            }
+
+            relocating_vector<_Entry> _Errors;
+            relocating_vector<uint64_t> _Errbits;
+            _Ty* _Myvalues = nullptr;
+            size_type _Mysize = 0;
+            size_type _Mycapacity = 0;
+    };
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _EXPECTED_VECTOR_
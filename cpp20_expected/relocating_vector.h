@@ -0,0 +1,439 @@
+#pragma once
+
+// relocating_vector experimental header
+
+#ifndef _RELOCATING_VECTOR_
+#define _RELOCATING_VECTOR_
+#include "expected.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#if _STL_COMPILER_PREPROCESSOR
+
+#ifdef _MSC_VER
+#pragma pack(push, _CRT_PACKING)
+#pragma warning(push, _STL_WARNING_LEVEL)
+#pragma warning(disable : _STL_DISABLED_WARNINGS)
+#endif // _MSC_VER
+_STL_DISABLE_CLANG_WARNINGS
+#pragma push_macro("new")
+#undef new
+
+namespace std::experimental {
+
+    // [relocating.vector] (extension)
+    // A contiguous sequence container that moves its elements to new storage by relocation. When
+    // is_trivially_relocatable_v<_Ty> holds, reallocation, insert and erase shift elements with memcpy/memmove
+    // and never run their move constructors or destructors; otherwise they behave like vector.
+    _EXPORT_STD template <class _Ty>
+        class relocating_vector {
+        static_assert(is_object_v<_Ty> && !is_const_v<_Ty> && !is_volatile_v<_Ty>,
+            "relocating_vector requires a non-const, non-volatile object type.");
+
+        public:
+            using value_type = _Ty;
+            using size_type = size_t;
+            using difference_type = ptrdiff_t;
+            using reference = _Ty&;
+            using const_reference = const _Ty&;
+            using pointer = _Ty*;
+            using const_pointer = const _Ty*;
+            using iterator = _Ty*;
+            using const_iterator = const _Ty*;
+
+            static constexpr bool _Trivial_relocation = is_trivially_relocatable_v<_Ty>;
+
+            relocating_vector() noexcept = default;
+
+            relocating_vector(initializer_list<_Ty> _Ilist) {
+                _Append_copies(_Ilist.begin(), _Ilist.end());
+            }
+
+            relocating_vector(const relocating_vector& _Other) {
+                _Append_copies(_Other._Myfirst, _Other._Mylast);
+            }
+
+            relocating_vector(relocating_vector&& _Other) noexcept
+                : _Myfirst(_STD exchange(_Other._Myfirst, nullptr)), _Mylast(_STD exchange(_Other._Mylast, nullptr)),
+                _Myend(_STD exchange(_Other._Myend, nullptr)) {}
+
+            relocating_vector& operator=(const relocating_vector& _Other) {
+                if (this != _STD addressof(_Other)) {
+                    relocating_vector _Tmp(_Other);
+                    swap(_Tmp);
+                }
+
+                return *this;
+            }
+
+            relocating_vector& operator=(relocating_vector&& _Other) noexcept {
+                if (this != _STD addressof(_Other)) {
+                    _Tidy();
+                    _Myfirst = _STD exchange(_Other._Myfirst, nullptr);
+                    _Mylast = _STD exchange(_Other._Mylast, nullptr);
+                    _Myend = _STD exchange(_Other._Myend, nullptr);
+                }
+
+                return *this;
+            }
+
+            ~relocating_vector() {
+                _Tidy();
+            }
+
+            _NODISCARD iterator begin() noexcept {
+                return _Myfirst;
+            }
+            _NODISCARD const_iterator begin() const noexcept {
+                return _Myfirst;
+            }
+            _NODISCARD iterator end() noexcept {
+                return _Mylast;
+            }
+            _NODISCARD const_iterator end() const noexcept {
+                return _Mylast;
+            }
+            _NODISCARD const_iterator cbegin() const noexcept {
+                return _Myfirst;
+            }
+            _NODISCARD const_iterator cend() const noexcept {
+                return _Mylast;
+            }
+
+            _NODISCARD bool empty() const noexcept {
+                return _Myfirst == _Mylast;
+            }
+            _NODISCARD size_type size() const noexcept {
+                return static_cast<size_type>(_Mylast - _Myfirst);
+            }
+            _NODISCARD size_type capacity() const noexcept {
+                return static_cast<size_type>(_Myend - _Myfirst);
+            }
+            _NODISCARD static constexpr size_type max_size() noexcept {
+                return static_cast<size_type>(PTRDIFF_MAX) / sizeof(_Ty);
+            }
+
+            _NODISCARD _Ty* data() noexcept {
+                return _Myfirst;
+            }
+            _NODISCARD const _Ty* data() const noexcept {
+                return _Myfirst;
+            }
+
+            _NODISCARD _Ty& operator[](const size_type _Pos) noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Pos < size(), "relocating_vector subscript out of range");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return _Myfirst[_Pos];
+            }
+            _NODISCARD const _Ty& operator[](const size_type _Pos) const noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Pos < size(), "relocating_vector subscript out of range");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                return _Myfirst[_Pos];
+            }
+
+            _NODISCARD _Ty& front() noexcept {
+                return *_Myfirst;
+            }
+            _NODISCARD const _Ty& front() const noexcept {
+                return *_Myfirst;
+            }
+            _NODISCARD _Ty& back() noexcept {
+                return _Mylast[-1];
+            }
+            _NODISCARD const _Ty& back() const noexcept {
+                return _Mylast[-1];
+            }
+
+            void reserve(const size_type _Newcapacity) {
+                if (_Newcapacity > capacity()) {
+                    if (_Newcapacity > max_size()) {
+                        _Xlength();
+                    }
+
+                    _Reallocate(_Newcapacity);
+                }
+            }
+
+            void shrink_to_fit() {
+                if (_Mylast != _Myend) {
+                    if (_Myfirst == _Mylast) {
+                        _Tidy();
+                    }
+                    else {
+                        _Reallocate(size());
+                    }
+                }
+            }
+
+            void clear() noexcept {
+                _STD destroy(_Myfirst, _Mylast);
+                _Mylast = _Myfirst;
+            }
+
+            template <class... _Valty>
+            _Ty& emplace_back(_Valty&&... _Val) {
+                if (_Mylast != _Myend) {
+                    _STD construct_at(_Mylast, _STD forward<_Valty>(_Val)...);
+                    return *_Mylast++;
+                }
+
+                return *_Emplace_reallocate(_Mylast, _STD forward<_Valty>(_Val)...);
+            }
+
+            void push_back(const _Ty& _Val) {
+                emplace_back(_Val);
+            }
+
+            void push_back(_Ty&& _Val) {
+                emplace_back(_STD move(_Val));
+            }
+
+            void pop_back() noexcept {
+#if _CONTAINER_DEBUG_LEVEL > 0
+                _STL_VERIFY(_Myfirst != _Mylast, "pop_back() called on empty relocating_vector");
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+                --_Mylast;
+                _STD destroy_at(_Mylast);
+            }
+
+            template <class... _Valty>
+            iterator emplace(const_iterator _Where, _Valty&&... _Val) {
+                _Ty* const _Whereptr = const_cast<_Ty*>(_Where);
+                if (_Mylast == _Myend) {
+                    return _Emplace_reallocate(_Whereptr, _STD forward<_Valty>(_Val)...);
+                }
+
+                if (_Whereptr == _Mylast) {
+                    _STD construct_at(_Mylast, _STD forward<_Valty>(_Val)...);
+                    ++_Mylast;
+                    return _Whereptr;
+                }
+
+                if constexpr (_Trivial_relocation) {
+                    // build the element aside first (_Val may alias an element), then open the gap and relocate it in
+                    alignas(_Ty) unsigned char _Buf[sizeof(_Ty)];
+                    _Ty* const _Tmp = _STD construct_at(reinterpret_cast<_Ty*>(_Buf), _STD forward<_Valty>(_Val)...);
+                    _Relocate(_Whereptr, _Mylast, _Whereptr + 1);
+                    _Relocate(_Tmp, _Tmp + 1, _Whereptr);
+                    ++_Mylast;
+                }
+                else {
+                    _Ty _Tmp(_STD forward<_Valty>(_Val)...);
+                    _STD construct_at(_Mylast, _STD move(_Mylast[-1]));
+                    ++_Mylast;
+                    _STD move_backward(_Whereptr, _Mylast - 2, _Mylast - 1);
+                    *_Whereptr = _STD move(_Tmp);
+                }
+
+                return _Whereptr;
+            }
+
+            iterator insert(const_iterator _Where, const _Ty& _Val) {
+                return emplace(_Where, _Val);
+            }
+
+            iterator insert(const_iterator _Where, _Ty&& _Val) {
+                return emplace(_Where, _STD move(_Val));
+            }
+
+            iterator erase(const_iterator _Where) noexcept(_Trivial_relocation || is_nothrow_move_assignable_v<_Ty>) {
+                return erase(_Where, _Where + 1);
+            }
+
+            iterator erase(const_iterator _First, const_iterator _Last) noexcept(
+                _Trivial_relocation || is_nothrow_move_assignable_v<_Ty>) {
+                _Ty* const _Firstptr = const_cast<_Ty*>(_First);
+                _Ty* const _Lastptr = const_cast<_Ty*>(_Last);
+                if (_Firstptr != _Lastptr) {
+                    if constexpr (_Trivial_relocation) {
+                        _STD destroy(_Firstptr, _Lastptr);
+                        _Relocate(_Lastptr, _Mylast, _Firstptr);
+                        _Mylast -= _Lastptr - _Firstptr;
+                    }
+                    else {
+                        _Ty* const _Newlast = _STD move(_Lastptr, _Mylast, _Firstptr);
+                        _STD destroy(_Newlast, _Mylast);
+                        _Mylast = _Newlast;
+                    }
+                }
+
+                return _Firstptr;
+            }
+
+            void swap(relocating_vector& _Other) noexcept {
+                _STD swap(_Myfirst, _Other._Myfirst);
+                _STD swap(_Mylast, _Other._Mylast);
+                _STD swap(_Myend, _Other._Myend);
+            }
+
+            friend void swap(relocating_vector& _Left, relocating_vector& _Right) noexcept {
+                _Left.swap(_Right);
+            }
+
+        private:
+            struct _NODISCARD _Buffer_guard { // frees a new buffer unless released
+                ~_Buffer_guard() {
+                    if (_Ptr) {
+                        allocator<_Ty>{}.deallocate(_Ptr, _Capacity);
+                    }
+                }
+                _Ty* _Ptr;
+                size_type _Capacity;
+            };
+
+            struct _NODISCARD _Tidy_guard { // empties a vector under construction unless released
+                ~_Tidy_guard() {
+                    if (_Target) {
+                        _Target->_Tidy();
+                    }
+                }
+                relocating_vector* _Target;
+            };
+
+            struct _NODISCARD _Destroy_guard { // destroys [_First, _Last) unless released
+                ~_Destroy_guard() {
+                    _STD destroy(_First, _Last);
+                }
+                _Ty* _First;
+                _Ty* _Last;
+            };
+
+            // moves the bytes of [_First, _Last) to _Dest; the ranges may overlap and the source is left dead
+            static void _Relocate(_Ty* const _First, _Ty* const _Last, _Ty* const _Dest) noexcept {
+                static_assert(_Trivial_relocation);
+                if (_First != _Last) {
+                    _CSTD memmove(static_cast<void*>(_Dest), static_cast<const void*>(_First),
+                        static_cast<size_t>(_Last - _First) * sizeof(_Ty));
+                }
+            }
+
+            // relocates [_First, _Last) into fresh storage _Dest one element at a time, by move when that cannot
+            // throw; otherwise copies everything first so that an exception leaves the source untouched
+            static void _Relocate_elementwise(_Ty* _First, _Ty* const _Last, _Ty* _Dest) {
+                if constexpr (is_nothrow_move_constructible_v<_Ty> || !is_copy_constructible_v<_Ty>) {
+                    for (; _First != _Last; ++_First, (void) ++_Dest) {
+                        _STD construct_at(_Dest, _STD move(*_First));
+                        _STD destroy_at(_First);
+                    }
+                }
+                else {
+                    _STD uninitialized_copy(_First, _Last, _Dest);
+                    _STD destroy(_First, _Last);
+                }
+            }
+
+            _NODISCARD size_type _Calculate_growth(const size_type _Newsize) const {
+                const size_type _Oldcapacity = capacity();
+                if (_Newsize > max_size()) {
+                    _Xlength();
+                }
+
+                if (_Oldcapacity > max_size() - _Oldcapacity / 2) {
+                    return max_size();
+                }
+
+                return (_STD max)(_Newsize, _Oldcapacity + _Oldcapacity / 2);
+            }
+
+            void _Reallocate(const size_type _Newcapacity) {
+                const size_type _Oldsize = size();
+                _Buffer_guard _Newvec{allocator<_Ty>{}.allocate(_Newcapacity), _Newcapacity};
+                if constexpr (_Trivial_relocation) {
+                    _Relocate(_Myfirst, _Mylast, _Newvec._Ptr);
+                }
+                else {
+                    _Relocate_elementwise(_Myfirst, _Mylast, _Newvec._Ptr);
+                }
+
+                _Deallocate();
+                _Myfirst = _STD exchange(_Newvec._Ptr, nullptr);
+                _Mylast = _Myfirst + _Oldsize;
+                _Myend = _Myfirst + _Newcapacity;
+            }
+
+            template <class... _Valty>
+            _Ty* _Emplace_reallocate(_Ty* const _Whereptr, _Valty&&... _Val) {
+                const size_type _Whereoff = static_cast<size_type>(_Whereptr - _Myfirst);
+                const size_type _Oldsize = size();
+                const size_type _Newcapacity = _Calculate_growth(_Oldsize + 1);
+                _Buffer_guard _Newvec{allocator<_Ty>{}.allocate(_Newcapacity), _Newcapacity};
+
+                // construct the new element before touching the old buffer, which _Val may point into
+                _Ty* const _Constructed = _Newvec._Ptr + _Whereoff;
+                _STD construct_at(_Constructed, _STD forward<_Valty>(_Val)...);
+                if constexpr (_Trivial_relocation) {
+                    _Relocate(_Myfirst, _Whereptr, _Newvec._Ptr);
+                    _Relocate(_Whereptr, _Mylast, _Constructed + 1);
+                }
+                else {
+                    if constexpr (is_nothrow_move_constructible_v<_Ty> || !is_copy_constructible_v<_Ty>) {
+                        _Relocate_elementwise(_Myfirst, _Whereptr, _Newvec._Ptr);
+                        _Relocate_elementwise(_Whereptr, _Mylast, _Constructed + 1);
+                    }
+                    else {
+                        _Destroy_guard _Prefix{_Constructed, _Constructed + 1};
+                        _STD uninitialized_copy(_Myfirst, _Whereptr, _Newvec._Ptr);
+                        _Prefix._First = _Newvec._Ptr;
+                        _STD uninitialized_copy(_Whereptr, _Mylast, _Constructed + 1);
+                        _Prefix._Last = _Prefix._First; // release
+                        _STD destroy(_Myfirst, _Mylast);
+                    }
+                }
+
+                _Deallocate();
+                _Myfirst = _STD exchange(_Newvec._Ptr, nullptr);
+                _Mylast = _Myfirst + _Oldsize + 1;
+                _Myend = _Myfirst + _Newcapacity;
+                return _Constructed;
+            }
+
+            template <class _Iter>
+            void _Append_copies(_Iter _First, const _Iter _Last) {
+                const auto _Count = static_cast<size_type>(_STD distance(_First, _Last));
+                if (_Count != 0) {
+                    reserve(_Count);
+                    // called from constructors, whose failure runs no destructor to free the buffer
+                    _Tidy_guard _Guard{this};
+                    _Mylast = _STD uninitialized_copy(_First, _Last, _Myfirst);
+                    _Guard._Target = nullptr;
+                }
+            }
+
+            void _Deallocate() noexcept {
+                if (_Myfirst) {
+                    allocator<_Ty>{}.deallocate(_Myfirst, capacity());
+                }
+            }
+
+            void _Tidy() noexcept {
+                _STD destroy(_Myfirst, _Mylast);
+                _Deallocate();
+                _Myfirst = nullptr;
+                _Mylast = nullptr;
+                _Myend = nullptr;
+            }
+
+            [[noreturn]] static void _Xlength() {
+                _EXPECTED_THROW(length_error{ "relocating_vector too long" });
+            }
+
+            _Ty* _Myfirst = nullptr;
+            _Ty* _Mylast = nullptr;
+            _Ty* _Myend = nullptr;
+    };
+
+}
+
+#pragma pop_macro("new")
+_STL_RESTORE_CLANG_WARNINGS
+#ifdef _MSC_VER
+#pragma warning(pop)
+#pragma pack(pop)
+#endif // _MSC_VER
+#endif // _STL_COMPILER_PREPROCESSOR
+#endif // _RELOCATING_VECTOR_
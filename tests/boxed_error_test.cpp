@@ -0,0 +1,211 @@
+// boxed_error: moves and copies, boxes freed on another thread than the one that allocated them or after the
+// thread's pool is gone, and the niche that makes expected<void, boxed_error<E>> the size of a pointer.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../cpp20_expected/expected_boxed.h"
+
+using std::experimental::boxed_error;
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+// counts the boxes, which the pool takes from the aligned operator new, that are not freed yet
+static std::atomic<int> live_boxes{0};
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    if (void* const ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        ++live_boxes;
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    if (ptr) {
+        --live_boxes;
+        std::free(ptr);
+    }
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept {
+    ::operator delete(ptr, align);
+}
+
+struct Rich {
+    std::string message;
+    int code;
+
+    friend bool operator==(const Rich&, const Rich&) = default;
+};
+
+struct alignas(64) Wide {
+    int code;
+};
+
+static_assert(sizeof(expected<void, boxed_error<Rich>>) == sizeof(void*));
+static_assert(sizeof(expected<int, boxed_error<Rich>>) == sizeof(expected<int, Rich*>));
+static_assert(std::is_nothrow_move_constructible_v<boxed_error<Rich>>);
+static_assert(std::is_nothrow_move_assignable_v<boxed_error<Rich>>);
+
+// destroyed after the main thread's pools, so its box goes straight back to the allocator
+static expected<int, boxed_error<Rich>> program_result{0};
+
+void test_moves() {
+    boxed_error<Rich> first{Rich{"first", 1}};
+    Rich* const box = first.get();
+
+    boxed_error<Rich> second{std::move(first)};
+    assert(second.get() == box);
+    assert(first.get() != box);
+
+    // a moved-from boxed_error may be assigned to, by copy or by move
+    first = second;
+    assert(first.get() != box);
+    assert(*first == *second);
+
+    boxed_error<Rich> third{std::move(first)};
+    first = std::move(third);
+    assert(first->message == "first");
+
+    second = std::move(second);
+    assert(second.get() == box);
+
+    swap(first, second);
+    assert(first.get() == box);
+    assert(*first == *second);
+}
+
+void test_copies() {
+    const boxed_error<Rich> original{std::in_place, "original", 2};
+    boxed_error<Rich> copy{original};
+    assert(copy.get() != original.get());
+    assert(copy == original);
+    assert(copy == (Rich{"original", 2}));
+
+    // assigning between live boxes reuses the target's box
+    boxed_error<Rich> other{Rich{"other", 3}};
+    Rich* const box = other.get();
+    other = original;
+    assert(other.get() == box);
+    assert(*other == *original);
+
+    copy->code = 4;
+    assert(original->code == 2);
+    assert(!(copy == original));
+}
+
+void test_reuse() {
+    const int before = live_boxes;
+    Rich* box;
+    {
+        boxed_error<Rich> error{Rich{"reused", 5}};
+        box = error.get();
+    }
+    boxed_error<Rich> error{Rich{"reused", 6}};
+    assert(error.get() == box);
+    assert(live_boxes <= before + 1);
+
+    const boxed_error<Wide> wide{Wide{7}};
+    assert(reinterpret_cast<std::uintptr_t>(wide.get()) % alignof(Wide) == 0);
+    assert(wide->code == 7);
+}
+
+// boxes made on one thread and freed on another end up back with the allocator once both threads are gone
+void test_cross_thread() {
+    const int before = live_boxes;
+    std::vector<boxed_error<Rich>> errors;
+    std::thread producer([&] {
+        for (int i = 0; i < 100; ++i) {
+            errors.emplace_back(Rich{"crossed", i});
+        }
+    });
+    producer.join();
+    assert(live_boxes == before + 100);
+
+    std::thread consumer([&] {
+        for (int i = 0; i < 100; ++i) {
+            assert(errors[i]->code == i);
+        }
+        errors.clear();
+    });
+    consumer.join();
+    assert(live_boxes == before);
+}
+
+// Constructed before the thread's pool, so destroyed after it: its boxes are freed and allocated with no pool
+struct Late {
+    std::optional<boxed_error<Rich>> error;
+
+    ~Late() {
+        error.reset();
+        boxed_error<Rich> again{Rich{"after the pool", 9}};
+        assert(again->code == 9);
+    }
+};
+
+void test_after_pool() {
+    const int before = live_boxes;
+    std::thread thread([] {
+        thread_local Late late;
+        late.error.emplace(Rich{"before the pool", 8});
+        boxed_error<Rich> cached{*late.error};
+    });
+    thread.join();
+    assert(live_boxes == before);
+}
+
+void test_niche() {
+    expected<void, boxed_error<Rich>> result;
+    assert(result.has_value());
+
+    result = unexpected<boxed_error<Rich>>(std::in_place, Rich{"failed", 10});
+    assert(!result.has_value());
+    assert(result.error()->message == "failed");
+
+    expected<void, boxed_error<Rich>> copy{result};
+    assert(!copy.has_value());
+    assert(copy.error().get() != result.error().get());
+    assert(copy == result);
+
+    expected<void, boxed_error<Rich>> moved{std::move(copy)};
+    assert(!moved.has_value());
+    assert(moved.error()->code == 10);
+
+    result.emplace();
+    assert(result.has_value());
+    assert(!(result == moved));
+
+    swap(result, moved);
+    assert(!result.has_value());
+    assert(moved.has_value());
+    assert(result.error()->code == 10);
+
+    const expected<int, boxed_error<Rich>> value{11};
+    assert(value.value_or(0) == 11);
+    const expected<int, boxed_error<Rich>> error{unexpected<boxed_error<Rich>>(std::in_place, Rich{"no value", 12})};
+    assert(error.value_or(0) == 0);
+    assert(error.error()->code == 12);
+}
+
+int main() {
+    test_moves();
+    test_copies();
+    test_reuse();
+    test_cross_thread();
+    test_after_pool();
+    test_niche();
+
+    program_result = unexpected<boxed_error<Rich>>(std::in_place, Rich{"at exit", 13});
+    assert(program_result.error()->code == 13);
+}
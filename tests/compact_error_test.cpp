@@ -0,0 +1,197 @@
+// compact_error: round trips through error_code for generic, category and interned codes, equality with the meaning
+// of error_code's, registering a domain twice, and the niche that makes expected<void, compact_error> 4 bytes.
+// Built with COMPACT_ERROR_CONFLICTING_ID, it registers a second domain under a taken id, which must abort.
+
+#include <cassert>
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#include "../cpp20_expected/compact_error.h"
+
+using std::experimental::compact_error;
+using std::experimental::compact_error_category;
+using std::experimental::compact_error_domain;
+using std::experimental::compact_error_message;
+using std::experimental::expected;
+using std::experimental::register_compact_error_domain;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+
+static_assert(sizeof(compact_error) == 4);
+static_assert(sizeof(expected<void, compact_error>) == 4);
+static_assert(sizeof(expected<int, compact_error>) == 8);
+
+class NetCategory final : public std::error_category {
+public:
+    const char* name() const noexcept override {
+        return "net";
+    }
+
+    std::string message(int value) const override {
+        return "net error " + std::to_string(value);
+    }
+};
+
+const std::error_category& net_category() noexcept {
+    static const NetCategory category;
+    return category;
+}
+
+constexpr compact_error_message parse_messages[] = {
+    {1, "unexpected token"},
+    {2, "unterminated string"},
+};
+constexpr compact_error_domain parse_errors{1, "parse", parse_messages};
+
+constexpr compact_error_message net_messages[] = {
+    {5, "connection refused"},
+    {-3, "timed out"},
+};
+constexpr compact_error_domain net_errors{2, "net", net_messages, net_category};
+
+// registered by namespace-scope initializers, as a library's domains would be
+const bool parse_registered = register_compact_error_domain(parse_errors);
+const bool net_registered   = register_compact_error_domain(net_errors);
+
+void test_generic() {
+    const compact_error none{};
+    assert(!none);
+    assert(none.domain_id() == compact_error::generic_domain_id);
+    assert(!none.to_error_code());
+
+    const compact_error invalid{std::errc::invalid_argument};
+    assert(invalid);
+    assert(invalid.value() == static_cast<int>(std::errc::invalid_argument));
+    assert(invalid.domain_name() == std::generic_category().name());
+    assert(invalid.message() == std::make_error_code(std::errc::invalid_argument).message());
+
+    const std::error_code code = invalid.to_error_code();
+    assert(code == std::make_error_code(std::errc::invalid_argument));
+    assert(compact_error{code} == invalid);
+    assert(static_cast<std::error_code>(invalid) == code);
+
+    // the cached message of an errc is the same storage on every call
+    assert(invalid.message().data() == compact_error{std::errc::invalid_argument}.message().data());
+}
+
+void test_domains() {
+    const compact_error token{parse_errors, 1};
+    assert(token.domain_id() == 1);
+    assert(token.value() == 1);
+    assert(token.message() == "unexpected token");
+    assert(token.domain_name() == "parse");
+    assert(compact_error(parse_errors, 9).message() == "unknown error");
+
+    // a domain without a category converts to compact_error_category(), holding the handle
+    const std::error_code token_code = token.to_error_code();
+    assert(token_code.category() == compact_error_category());
+    assert(token_code.value() == static_cast<int>(token.handle()));
+    assert(token_code.message() == "unexpected token");
+    assert(compact_error{token_code} == token);
+
+    // a domain with a category converts to codes of that category and back, negative codes included
+    for (const int value : {5, -3, 77}) {
+        const compact_error net{net_errors, value};
+        assert(net.domain_id() == 2);
+        assert(net.value() == value);
+        const std::error_code net_code = net.to_error_code();
+        assert(net_code.category() == net_category());
+        assert(net_code.value() == value);
+        assert(compact_error{net_code} == net);
+        assert(compact_error{std::error_code(value, net_category())} == net);
+    }
+    assert(compact_error(net_errors, -3).message() == "timed out");
+
+    const compact_error unregistered = compact_error::from_handle(0x07000001);
+    assert(unregistered.message() == "unregistered compact_error domain");
+    assert(unregistered.domain_name() == "unregistered");
+    assert(compact_error{unregistered.to_error_code()} == unregistered);
+}
+
+void test_interned() {
+    const std::error_code system_code(5, std::system_category());
+    const compact_error system{system_code};
+    assert(system.domain_id() == compact_error::interned_domain_id);
+    assert(system.value() == 5);
+    assert(system.domain_name() == std::system_category().name());
+    assert(system.message() == system_code.message());
+    assert(system.to_error_code() == system_code);
+
+    // interning a code again finds its entry
+    assert(compact_error{system_code} == system);
+    assert(compact_error{std::error_code(6, std::system_category())} != system);
+
+    // codes of known categories beyond 24 bits are interned too, and keep their value
+    for (const std::error_code& wide : {std::error_code(1 << 24, std::generic_category()),
+             std::error_code(-(1 << 24) - 1, net_category())}) {
+        const compact_error interned{wide};
+        assert(interned.domain_id() == compact_error::interned_domain_id);
+        assert(interned.value() == wide.value());
+        assert(interned.to_error_code() == wide);
+        assert(compact_error{interned.to_error_code()} == interned);
+    }
+}
+
+void test_equality() {
+    assert(compact_error(parse_errors, 2) == compact_error(parse_errors, 2));
+    assert(compact_error(parse_errors, 2) != compact_error(parse_errors, 1));
+
+    // the same value in different domains, as in different categories, is a different error
+    assert(compact_error(parse_errors, 5) != compact_error(net_errors, 5));
+    assert(compact_error{std::errc::io_error} != compact_error{std::error_code(EIO, std::system_category())});
+    assert(compact_error{std::errc::io_error} == compact_error{std::make_error_code(std::errc::io_error)});
+}
+
+void test_registration() {
+    assert(parse_registered && net_registered);
+    assert(!register_compact_error_domain(parse_errors));
+    assert(!register_compact_error_domain(net_errors));
+
+#ifdef COMPACT_ERROR_CONFLICTING_ID
+    static constexpr compact_error_domain impostor{1, "impostor", parse_messages};
+    (void) register_compact_error_domain(impostor);
+#endif // COMPACT_ERROR_CONFLICTING_ID
+}
+
+// every handle but 0xFFFFFFFF is an error, success and the interned codes included
+void test_niche() {
+    expected<void, compact_error> result;
+    assert(result.has_value());
+
+    result = unexpected(compact_error{});
+    assert(!result.has_value());
+    assert(result.error() == compact_error{});
+
+    result.emplace();
+    assert(result.has_value());
+
+    result = unexpected(compact_error{std::error_code(5, std::system_category())});
+    assert(!result.has_value());
+    assert(result.error().value() == 5);
+
+    const expected<void, compact_error> last{unexpect, compact_error::from_handle(0xFFFFFFFEu)};
+    assert(!last.has_value());
+    assert(last.error().handle() == 0xFFFFFFFEu);
+
+    expected<void, compact_error> other{unexpect, compact_error(parse_errors, 2)};
+    swap(result, other);
+    assert(result.error() == compact_error(parse_errors, 2));
+    assert(other.error().value() == 5);
+    assert(result != other);
+
+    const expected<int, compact_error> value{7};
+    assert(value.value_or(0) == 7);
+    const expected<int, compact_error> error{unexpect, std::errc::timed_out};
+    assert(error.value_or(0) == 0);
+    assert(error.error() == compact_error{std::errc::timed_out});
+}
+
+int main() {
+    test_generic();
+    test_domains();
+    test_interned();
+    test_equality();
+    test_registration();
+    test_niche();
+}
@@ -0,0 +1,48 @@
+// emplace() into an expected whose discriminant lives in the tail padding of the value type: constructing the
+// value may overwrite that padding, so has_value() must be set after the construction, from either alternative.
+
+#include <cassert>
+#include <utility>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::unexpect;
+
+enum class EC { A, B };
+
+using Result = expected<std::pair<int, char>, EC>;
+
+#ifndef _MSC_VER // the MSVC ABI does not reuse tail padding
+static_assert(sizeof(Result) == sizeof(std::pair<int, char>));
+#endif // _MSC_VER
+
+[[gnu::noinline]] void emplace_pair(Result& result, const std::pair<int, char>& value) {
+    result.emplace(value);
+}
+
+[[gnu::noinline]] void emplace_parts(Result& result, int first, char second) {
+    result.emplace(first, second);
+}
+
+int main() {
+    // error -> value
+    Result from_error{unexpect, EC::B};
+    emplace_pair(from_error, {1, 'a'});
+    assert(from_error.has_value());
+    assert(from_error->first == 1 && from_error->second == 'a');
+
+    // value -> value
+    Result from_value{std::pair{2, 'b'}};
+    emplace_pair(from_value, {3, 'c'});
+    assert(from_value.has_value());
+    assert(from_value->first == 3 && from_value->second == 'c');
+
+    emplace_parts(from_value, 4, 'd');
+    assert(from_value.has_value());
+    assert(from_value->first == 4 && from_value->second == 'd');
+
+    // and back to an error, which must still read as one
+    from_value = Result{unexpect, EC::A};
+    assert(!from_value.has_value() && from_value.error() == EC::A);
+}
@@ -0,0 +1,154 @@
+// error_enum: the enumerators found for negative, non-contiguous and unsigned enums, values outside
+// error_enum_range, and error_enum_index by subtraction (_Contiguous) and by table (_Indices) checked against a
+// search of error_enum_values.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "../cpp20_expected/error_enum.h"
+
+using std::experimental::_Error_enum_meta;
+using std::experimental::error_enum_count;
+using std::experimental::error_enum_counters;
+using std::experimental::error_enum_index;
+using std::experimental::error_enum_name;
+using std::experimental::error_enum_names;
+using std::experimental::error_enum_values;
+
+enum class Consecutive { ok, not_found, denied };
+enum class Negative : signed char { lowest = -3, lower, low };
+enum class Sparse : int { bottom = -100, minus_one = -1, zero = 0, seven = 7, top = 127 };
+enum class Unsigned : unsigned char { none = 0, many = 200, all = 255 };
+enum class High : std::uint8_t { first = 250, second, third };
+enum class Outside : int { below = -500, inside = 5, above = 500 };
+enum class Wide : short { negative = -1000, positive = 1000 };
+enum class Alias { first = 1, second = 1 };
+enum class Empty {};
+enum Plain { plain_first = 2, plain_second = 4 };
+
+template <>
+struct std::experimental::error_enum_range<Wide> {
+    static constexpr long long min = -1000;
+    static constexpr long long max = 1000;
+};
+
+// error_enum_index of every value of [lo, hi] that Enum can hold, against a linear search
+template <class Enum>
+consteval bool index_matches_search(const long long lo, const long long hi) {
+    using Under = std::underlying_type_t<Enum>;
+    for (long long value = lo; value <= hi; ++value) {
+        if (value < static_cast<long long>((std::numeric_limits<Under>::min)())
+            || value > static_cast<long long>((std::numeric_limits<Under>::max)())) {
+            continue;
+        }
+
+        const auto val = static_cast<Enum>(static_cast<Under>(value));
+        std::size_t expected = error_enum_count<Enum>;
+        for (std::size_t idx = 0; idx < error_enum_count<Enum>; ++idx) {
+            if (error_enum_values<Enum>[idx] == val) {
+                expected = idx;
+            }
+        }
+
+        if (error_enum_index(val) != expected) {
+            return false;
+        }
+
+        if (error_enum_name(val) != (expected == error_enum_count<Enum> ? std::string_view{}
+                                                                          : error_enum_names<Enum>[expected])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// consecutive enumerators take the subtraction
+static_assert(_Error_enum_meta<Consecutive>::_Contiguous);
+static_assert(error_enum_count<Consecutive> == 3);
+static_assert(error_enum_names<Consecutive>[1] == "not_found");
+static_assert(error_enum_index(Consecutive::denied) == 2);
+static_assert(error_enum_index(static_cast<Consecutive>(3)) == 3);
+static_assert(error_enum_index(static_cast<Consecutive>(-1)) == 3);
+static_assert(error_enum_index(static_cast<Consecutive>(1 << 30)) == 3);
+static_assert(index_matches_search<Consecutive>(-300, 300));
+
+static_assert(_Error_enum_meta<Negative>::_Contiguous);
+static_assert(error_enum_values<Negative>[0] == Negative::lowest);
+static_assert(error_enum_index(Negative::low) == 2);
+static_assert(error_enum_index(static_cast<Negative>(-4)) == 3);
+static_assert(error_enum_name(Negative::lower) == "lower");
+static_assert(index_matches_search<Negative>(-128, 127));
+
+static_assert(_Error_enum_meta<High>::_Contiguous);
+static_assert(error_enum_index(High::third) == 2);
+static_assert(error_enum_index(static_cast<High>(0)) == 3);
+static_assert(index_matches_search<High>(0, 255));
+
+// gaps between the enumerators take the table
+static_assert(!_Error_enum_meta<Sparse>::_Contiguous);
+static_assert(error_enum_count<Sparse> == 5);
+static_assert(error_enum_values<Sparse>[0] == Sparse::bottom && error_enum_values<Sparse>[4] == Sparse::top);
+static_assert(error_enum_names<Sparse>[1] == "minus_one");
+static_assert(error_enum_index(Sparse::seven) == 3);
+static_assert(error_enum_index(static_cast<Sparse>(5)) == 5);
+static_assert(error_enum_index(static_cast<Sparse>(-128)) == 5);
+static_assert(error_enum_index(static_cast<Sparse>(128)) == 5);
+static_assert(error_enum_index(static_cast<Sparse>(-100000)) == 5);
+static_assert(error_enum_name(static_cast<Sparse>(6)).empty());
+static_assert(index_matches_search<Sparse>(-1000, 1000));
+
+// an unsigned underlying type ranges over [0, 255]
+static_assert(!_Error_enum_meta<Unsigned>::_Contiguous);
+static_assert(error_enum_count<Unsigned> == 3);
+static_assert(error_enum_index(Unsigned::all) == 2);
+static_assert(error_enum_name(Unsigned::many) == "many");
+static_assert(index_matches_search<Unsigned>(0, 255));
+
+// enumerators outside error_enum_range are other values
+static_assert(error_enum_count<Outside> == 1);
+static_assert(error_enum_values<Outside>[0] == Outside::inside);
+static_assert(error_enum_index(Outside::above) == 1);
+static_assert(error_enum_index(Outside::below) == 1);
+static_assert(error_enum_name(Outside::above).empty());
+static_assert(index_matches_search<Outside>(-600, 600));
+
+// unless error_enum_range is widened
+static_assert(error_enum_count<Wide> == 2);
+static_assert(!_Error_enum_meta<Wide>::_Contiguous);
+static_assert(error_enum_index(Wide::positive) == 1);
+static_assert(error_enum_name(Wide::negative) == "negative");
+static_assert(index_matches_search<Wide>(-1100, 1100));
+
+static_assert(error_enum_count<Alias> == 1);
+static_assert(error_enum_index(Alias::second) == 0);
+
+static_assert(error_enum_count<Empty> == 0);
+static_assert(error_enum_index(static_cast<Empty>(0)) == 0);
+static_assert(error_enum_name(static_cast<Empty>(0)).empty());
+
+static_assert(error_enum_names<Plain>[0] == "plain_first" && error_enum_names<Plain>[1] == "plain_second");
+static_assert(error_enum_index(static_cast<Plain>(3)) == 2);
+static_assert(index_matches_search<Plain>(0, 7));
+
+int main() {
+    error_enum_counters<Sparse> counters;
+    counters.record(Sparse::bottom);
+    counters.record(Sparse::top);
+    counters.record(Sparse::top);
+    counters.record(static_cast<Sparse>(3));
+    counters.record(static_cast<Sparse>(1000));
+
+    assert(counters.count(Sparse::bottom) == 1);
+    assert(counters.count(Sparse::top) == 2);
+    assert(counters.count(Sparse::zero) == 0);
+    assert(counters.count_at(error_enum_count<Sparse>) == 2);
+    assert(counters.count(static_cast<Sparse>(-7)) == 2);
+
+    counters.reset();
+    assert(counters.count(Sparse::top) == 0);
+    assert(counters.count_at(error_enum_count<Sparse>) == 0);
+}
@@ -0,0 +1,101 @@
+// error_map: the tables that must not compile, the fallback for values that are not enumerators, and maps to errc
+// through transform_error and to expected<int, errc> through or_else.
+// Built with ERROR_MAP_DIAGNOSTIC set to 1, 2 or 3, it constructs one of the ill-formed maps for the compiler to
+// reject, naming the reason.
+
+#include <cassert>
+#include <system_error>
+#include <type_traits>
+
+#include "../cpp20_expected/error_map.h"
+
+using std::errc;
+using std::experimental::error_map;
+using std::experimental::expected;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+
+enum class Code { not_found, timed_out, denied };
+enum class Sparse { low = -20, high = 90 };
+
+// whether the error_map made by Build is a constant, as its consteval constructor requires
+template <auto Build>
+concept builds = requires { typename std::bool_constant<(Build(), true)>; };
+
+static_assert(builds<[]() consteval {
+    return error_map<Code, int>{{{Code::not_found, 1}, {Code::timed_out, 2}, {Code::denied, 3}}, 0};
+}>);
+static_assert(!builds<[]() consteval { // not an enumerator
+    return error_map<Code, int>{{{Code::not_found, 1}, {Code::timed_out, 2}, {Code::denied, 3}, {Code{7}, 4}}, 0};
+}>);
+static_assert(!builds<[]() consteval { // mapped twice
+    return error_map<Code, int>{{{Code::not_found, 1}, {Code::timed_out, 2}, {Code::denied, 3}, {Code::denied, 4}}, 0};
+}>);
+static_assert(!builds<[]() consteval { // not mapped
+    return error_map<Code, int>{{{Code::not_found, 1}, {Code::denied, 3}}, 0};
+}>);
+
+#if ERROR_MAP_DIAGNOSTIC == 1
+constexpr error_map<Code, int> not_an_enumerator{
+    {{Code::not_found, 1}, {Code::timed_out, 2}, {Code::denied, 3}, {Code{7}, 4}}, 0};
+#elif ERROR_MAP_DIAGNOSTIC == 2
+constexpr error_map<Code, int> mapped_twice{
+    {{Code::not_found, 1}, {Code::timed_out, 2}, {Code::denied, 3}, {Code::denied, 4}}, 0};
+#elif ERROR_MAP_DIAGNOSTIC == 3
+constexpr error_map<Code, int> not_mapped{{{Code::not_found, 1}, {Code::denied, 3}}, 0};
+#endif // ERROR_MAP_DIAGNOSTIC
+
+// the entries may come in any order
+constexpr error_map<Code, errc> to_errc{
+    {{Code::denied, errc::permission_denied}, {Code::not_found, errc::no_such_file_or_directory},
+        {Code::timed_out, errc::timed_out}},
+    errc::io_error};
+
+static_assert(to_errc(Code::not_found) == errc::no_such_file_or_directory);
+static_assert(to_errc(Code::timed_out) == errc::timed_out);
+static_assert(to_errc(Code::denied) == errc::permission_denied);
+static_assert(to_errc(Code{3}) == errc::io_error);
+static_assert(to_errc(Code{-1}) == errc::io_error);
+static_assert(to_errc(Code{1 << 20}) == errc::io_error);
+static_assert(std::is_nothrow_invocable_r_v<errc, decltype(to_errc), Code>);
+
+constexpr error_map<Sparse, int> sparse_codes{{{Sparse::high, 900}, {Sparse::low, -200}}, 0};
+
+static_assert(sparse_codes(Sparse::low) == -200);
+static_assert(sparse_codes(Sparse::high) == 900);
+static_assert(sparse_codes(Sparse{0}) == 0);
+static_assert(sparse_codes(Sparse{-21}) == 0);
+static_assert(sparse_codes(Sparse{91}) == 0);
+
+// recovers a missing entry as a default value and translates the rest
+constexpr error_map<Code, expected<int, errc>> recover{
+    {{Code::not_found, 0}, {Code::timed_out, unexpected(errc::timed_out)},
+        {Code::denied, unexpected(errc::permission_denied)}},
+    unexpected(errc::io_error)};
+
+int main() {
+    const expected<int, Code> found{42};
+    const expected<int, Code> missing{unexpect, Code::not_found};
+    const expected<int, Code> slow{unexpect, Code::timed_out};
+    const expected<int, Code> refused{unexpect, Code::denied};
+    const expected<int, Code> strange{unexpect, Code{9}};
+
+    const expected<int, errc> found_errc = found.transform_error(to_errc);
+    assert(found_errc.value() == 42);
+    assert(slow.transform_error(to_errc).error() == errc::timed_out);
+    assert(strange.transform_error(to_errc).error() == errc::io_error);
+
+    const expected<int, errc> recovered = missing.or_else(recover);
+    assert(recovered.value() == 0);
+    assert(found.or_else(recover).value() == 42);
+    assert(slow.or_else(recover).error() == errc::timed_out);
+    assert(refused.or_else(recover).error() == errc::permission_denied);
+    assert(strange.or_else(recover).error() == errc::io_error);
+
+    for (int raw = -300; raw <= 300; ++raw) {
+        const Code code{raw};
+        const bool enumerator = raw >= 0 && raw <= 2;
+        assert((to_errc(code) == errc::io_error) == !enumerator);
+        assert(recover(code).has_value() == (code == Code::not_found));
+    }
+}
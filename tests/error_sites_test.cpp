@@ -0,0 +1,98 @@
+// [expected.sites]: built with _EXPECTED_ERROR_SITES=1. An error carried along by and_then and transform is counted
+// once, at the site that produced it; the counts of a thread that has exited are kept; the JSON output escapes the
+// file and function names.
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+enum class EC { A = 1, B };
+
+[[gnu::noinline]] expected<int, EC> fetch(int key) {
+    if (key >= 0) {
+        return unexpected(EC::A);
+    }
+    return key;
+}
+
+[[gnu::noinline]] expected<int, EC> resolve(int key) {
+    return fetch(key).and_then([](int value) { return fetch(value + 1); }).transform([](int value) {
+        return value * 2;
+    });
+}
+
+[[gnu::noinline]] expected<int, EC> fail_on_worker() {
+    return unexpected(EC::B);
+}
+
+// defined at the end, in a file whose name needs escaping
+expected<int, EC> fail_in_odd_file();
+
+const std::experimental::error_site_count* find_site(
+    const std::experimental::error_site_snapshot& snapshot, std::string_view function) {
+    const std::experimental::error_site_count* found = nullptr;
+    for (const auto& site : snapshot.sites) {
+        if (site.function.find(function) != std::string_view::npos) {
+            assert(found == nullptr); // one site per function
+            found = &site;
+        }
+    }
+    return found;
+}
+
+int main() {
+    constexpr int calls = 100;
+    for (int key = 0; key < calls; ++key) {
+        assert(!resolve(key).has_value());
+    }
+
+    std::thread worker{[] {
+        for (int i = 0; i < 7; ++i) {
+            assert(!fail_on_worker().has_value());
+        }
+    }};
+    worker.join();
+
+    assert(!fail_in_odd_file().has_value());
+
+    const auto snapshot = std::experimental::take_error_site_snapshot();
+    assert(snapshot.dropped == 0);
+    assert(snapshot.sites.size() == 3);
+
+    // propagation through and_then and transform is not counted again
+    const auto* fetched = find_site(snapshot, "fetch");
+    assert(fetched != nullptr);
+    assert(fetched->count == calls);
+    assert(find_site(snapshot, "resolve") == nullptr);
+
+    // the worker has exited, its counts are merged
+    const auto* on_worker = find_site(snapshot, "fail_on_worker");
+    assert(on_worker != nullptr);
+    assert(on_worker->count == 7);
+
+    const auto* odd = find_site(snapshot, "fail_in_odd_file");
+    assert(odd != nullptr);
+    assert(odd->count == 1);
+    assert(odd->line == 1001);
+    assert(odd->file == "dir\\sub \"quoted\"\tname.cpp");
+
+    const std::string json = std::experimental::format_error_sites_json(snapshot);
+    assert(json.rfind("{\"dropped\":0,\"sites\":[{\"file\":", 0) == 0);
+    assert(json.find(R"("file":"dir\\sub \"quoted\"\u0009name.cpp","line":1001,)") != std::string::npos);
+    assert(json.find("\"count\":100}") != std::string::npos);
+    assert(json.find("\"count\":7}") != std::string::npos);
+    assert(json.substr(json.size() - 3) == "}]}");
+}
+
+// a backslash, quotes and a tab
+#line 1000 "dir\\sub \"quoted\"\tname.cpp"
+[[gnu::noinline]] expected<int, EC> fail_in_odd_file() {
+    return unexpected(EC::A);
+}
@@ -0,0 +1,79 @@
+// [expected.traces]: built with _EXPECTED_ERROR_TRACES=1 and frame pointers. Sampling 1 captures every error, on
+// any thread, with the frames of its callers where the stack can be walked; a full ring counts the traces it
+// drops; sampling N captures one error in N, and 0 none.
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+enum class EC { A = 1 };
+
+[[gnu::noinline]] expected<int, EC> fetch(int key) {
+    if (key >= 0) {
+        return unexpected(EC::A);
+    }
+    return key;
+}
+
+// two more frames between the caller and the error
+template <int Depth>
+[[gnu::noinline]] expected<int, EC> resolve(int key) {
+    if constexpr (Depth == 0) {
+        return fetch(key);
+    } else {
+        return resolve<Depth - 1>(key).transform([](int value) { return value + Depth; });
+    }
+}
+
+void fail(int errors) {
+    for (int key = 0; key < errors; ++key) {
+        assert(!resolve<2>(key).has_value());
+    }
+}
+
+int main() {
+    namespace ex = std::experimental;
+
+    // every error, on the main thread and on another one
+    ex::set_error_trace_sampling(1);
+    fail(10);
+    std::thread worker{[] { fail(10); }};
+    worker.join();
+
+    const ex::error_trace_snapshot all = ex::take_error_traces();
+    assert(all.traces.size() == 20);
+    assert(all.dropped == 0);
+    for (const ex::error_trace& trace : all.traces) {
+        assert(trace.depth >= 1);
+        assert(trace.frames[0] != nullptr);
+#if _EXPECTED_HAS_FRAME_WALK
+        assert(trace.depth >= 4); // fetch, resolve<0>, resolve<1>, resolve<2>
+#endif // _EXPECTED_HAS_FRAME_WALK
+    }
+    assert(ex::format_error_traces_text(all).rfind("error traces: 20 captured, 0 dropped\n", 0) == 0);
+    assert(ex::take_error_traces().traces.empty());
+
+    // a full ring drops and counts the rest
+    fail(static_cast<int>(ex::error_trace_capacity) + 5);
+    const ex::error_trace_snapshot full = ex::take_error_traces();
+    assert(full.traces.size() == ex::error_trace_capacity);
+    assert(full.dropped == 5);
+
+    // one error in 100
+    ex::set_error_trace_sampling(100);
+    fail(1000);
+    assert(ex::take_error_traces().traces.size() == 10);
+
+    // none
+    ex::set_error_trace_sampling(0);
+    fail(1000);
+    const ex::error_trace_snapshot none = ex::take_error_traces();
+    assert(none.traces.empty());
+    assert(none.dropped == 0);
+}
@@ -0,0 +1,10 @@
+# Runs PROGRAM and passes if it fails, by exit code or by signal, having printed EXPECTED on its standard error.
+# Used for the checks that stop the program, whose abort ctest would report as a failure even with WILL_FAIL.
+
+execute_process(COMMAND "${PROGRAM}" RESULT_VARIABLE result ERROR_VARIABLE error)
+if(result EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} succeeded")
+endif()
+if(NOT error MATCHES "${EXPECTED}")
+    message(FATAL_ERROR "${PROGRAM} failed (${result}) without printing \"${EXPECTED}\":\n${error}")
+endif()
@@ -0,0 +1,124 @@
+// batch_transform, batch_and_then and batch_transform_error give the results of the member functions they stand
+// for, element by element, on mixed values and errors: through the bit-mask blending for scalars of different
+// sizes, and through the fallback for other types.
+
+#include <cassert>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/expected_batch.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+using std::experimental::_Expected_batch;
+
+enum class Code : unsigned char { none, bad, worse };
+
+template <class T, class E>
+std::vector<expected<T, E>> make_inputs(std::initializer_list<T> values, std::initializer_list<E> errors) {
+    // values and errors interleaved, with runs of each, so that both alternatives meet both neighbours
+    std::vector<expected<T, E>> inputs;
+    auto value = values.begin();
+    auto error = errors.begin();
+    for (int i = 0; value != values.end() || error != errors.end(); ++i) {
+        if ((i % 5 == 1 || i % 5 == 2 || value == values.end()) && error != errors.end()) {
+            inputs.push_back(unexpected(*error++));
+        } else {
+            inputs.push_back(*value++);
+        }
+    }
+    return inputs;
+}
+
+template <class T, class E, class U, class Fn>
+void check_transform(const std::vector<expected<T, E>>& in, Fn fn) {
+    std::vector<expected<U, E>> out(in.size(), unexpected(E{}));
+    std::experimental::batch_transform(std::span<const expected<T, E>>(in), std::span<expected<U, E>>(out), fn);
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        assert(out[i] == in[i].transform(fn));
+    }
+}
+
+template <class T, class E, class U, class Fn>
+void check_and_then(const std::vector<expected<T, E>>& in, Fn fn) {
+    std::vector<expected<U, E>> out(in.size());
+    std::experimental::batch_and_then(std::span<const expected<T, E>>(in), std::span<expected<U, E>>(out), fn);
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        assert(out[i] == in[i].and_then(fn));
+    }
+}
+
+template <class T, class E, class G, class Fn>
+void check_transform_error(const std::vector<expected<T, E>>& in, Fn fn) {
+    std::vector<expected<T, G>> out(in.size());
+    std::experimental::batch_transform_error(std::span<const expected<T, E>>(in), std::span<expected<T, G>>(out), fn);
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        assert(out[i] == in[i].transform_error(fn));
+    }
+}
+
+// the scalar cases below take the branchless path
+static_assert(_Expected_batch::_Is_branchless<int, int>());
+static_assert(_Expected_batch::_Is_branchless<long long, int>());
+static_assert(_Expected_batch::_Is_branchless<char, int>());
+static_assert(_Expected_batch::_Is_branchless<int, char>());
+static_assert(_Expected_batch::_Is_branchless<double, Code>());
+static_assert(!_Expected_batch::_Is_branchless<std::string, int>());
+
+int main() {
+    const auto ints = make_inputs<int, int>({0, 1, -7, 123456, 2147483647, -2147483647 - 1, 42}, {1, -1, 99, 0, 65535});
+
+    // int -> long long, int -> char, int -> double
+    check_transform<int, int, long long>(ints, [](int v) { return static_cast<long long>(v) * 3000000000LL; });
+    check_transform<int, int, char>(ints, [](int v) { return static_cast<char>(v & 0x7f); });
+    check_transform<int, int, double>(ints, [](int v) { return v * 0.5; });
+
+    // char -> int, with errors of either size
+    const auto chars = make_inputs<char, int>({'a', 'z', '\0', '\x7f'}, {-2, 1 << 20, 7});
+    check_transform<char, int, int>(chars, [](char c) { return c * 1000; });
+    const auto char_errors = make_inputs<int, char>({5, -5, 1 << 30}, {'x', '\0', '\x7f'});
+    check_transform<int, char, char>(char_errors, [](int v) { return static_cast<char>(v % 100); });
+    check_transform<int, char, long long>(char_errors, [](int v) { return -static_cast<long long>(v); });
+
+    // a value that turns into an error, among inputs that already were errors
+    const auto checked = [](int v) -> expected<int, int> {
+        if (v < 0) {
+            return unexpected(-1000);
+        }
+        return v / 2;
+    };
+    check_and_then<int, int, int>(ints, checked);
+    check_and_then<int, int, long long>(ints, [](int v) -> expected<long long, int> {
+        if (v % 2 != 0) {
+            return unexpected(v);
+        }
+        return static_cast<long long>(v) << 33;
+    });
+    check_and_then<char, int, int>(chars, [](char c) -> expected<int, int> {
+        if (c == '\0') {
+            return unexpected(0xdead);
+        }
+        return c + 1;
+    });
+
+    // int -> long long, int -> char and char -> int errors, and an enum
+    check_transform_error<int, int, long long>(ints, [](int e) { return static_cast<long long>(e) - (1LL << 40); });
+    check_transform_error<int, int, char>(ints, [](int e) { return static_cast<char>(e & 0x3f); });
+    check_transform_error<int, char, int>(char_errors, [](char e) { return e * -3; });
+    const auto codes = make_inputs<double, Code>({1.5, -0.0, 1e300}, {Code::bad, Code::worse});
+    check_transform_error<double, Code, int>(codes, [](Code c) { return static_cast<int>(c) + 10; });
+    check_transform<double, Code, float>(codes, [](double d) { return static_cast<float>(d / 1e300); });
+
+    // the fallback for types that are not scalars
+    const auto strings = make_inputs<std::string, int>({"", "short", std::string(100, 'l')}, {3, 4});
+    check_transform<std::string, int, std::size_t>(strings, [](const std::string& s) { return s.size(); });
+    check_and_then<std::string, int, std::string>(strings, [](const std::string& s) -> expected<std::string, int> {
+        if (s.empty()) {
+            return unexpected(-1);
+        }
+        return s + "!";
+    });
+    const auto string_errors = make_inputs<int, std::string>({1, 2}, {"a", std::string(40, 'e')});
+    check_transform_error<int, std::string, std::size_t>(string_errors, [](const std::string& e) { return e.size(); });
+}
@@ -0,0 +1,153 @@
+// match: the handler called for a value, each enumerator, and the values of E that are not enumerators, with and
+// without on_error(f); the value category handlers receive; expected<void, E>; and the common type of the results.
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../cpp20_expected/expected_match.h"
+
+using std::experimental::bad_expected_access;
+using std::experimental::expected;
+using std::experimental::match;
+using std::experimental::on_error;
+using std::experimental::unexpect;
+
+enum class Code { not_found, timed_out, denied };
+
+// more arms than the smallest switch holds
+enum class Many { e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11, e12, e13, e14, e15, e16, e17, e18, e19 };
+
+constexpr int classify(const expected<int, Code>& result) {
+    return match(result, [](int value) { return value; },
+        on_error<Code::not_found>([] { return -1; }),
+        on_error<Code::timed_out>([](Code) { return -2; }),
+        on_error<Code::denied>([](const Code&) { return -3; }));
+}
+
+static_assert(classify(7) == 7);
+static_assert(classify(expected<int, Code>{unexpect, Code::not_found}) == -1);
+static_assert(classify(expected<int, Code>{unexpect, Code::timed_out}) == -2);
+static_assert(classify(expected<int, Code>{unexpect, Code::denied}) == -3);
+
+// the result is the common type of all handlers
+using Mixed = decltype(match(std::declval<expected<int, Code>&>(), [](int) { return 1; },
+    on_error<Code::not_found>([] { return 2L; }), on_error([](Code) { return 3.0; })));
+static_assert(std::is_same_v<Mixed, double>);
+
+using Text = decltype(match(std::declval<expected<int, Code>&>(), [](int) { return std::string{"value"}; },
+    on_error([] { return "error"; })));
+static_assert(std::is_same_v<Text, std::string>);
+
+using Void = decltype(match(std::declval<expected<void, Code>>(), [] {}, on_error([] {})));
+static_assert(std::is_void_v<Void>);
+
+void test_catch_all() {
+    const auto describe = [](const expected<int, Code>& result) {
+        return match(result, [](int) { return std::string{"value"}; },
+            on_error<Code::timed_out>([] { return "timed out"; }),
+            on_error([](Code code) { return "other " + std::to_string(static_cast<int>(code)); }));
+    };
+
+    assert(describe(1) == "value");
+    assert(describe(expected<int, Code>{unexpect, Code::timed_out}) == "timed out");
+    assert(describe(expected<int, Code>{unexpect, Code::not_found}) == "other 0");
+    assert(describe(expected<int, Code>{unexpect, Code::denied}) == "other 2");
+    assert(describe(expected<int, Code>{unexpect, Code{7}}) == "other 7");
+    assert(describe(expected<int, Code>{unexpect, Code{-1}}) == "other -1");
+}
+
+// without on_error(f), a value that is not an enumerator throws as value() would
+void test_no_catch_all() {
+    for (const int raw : {3, -1, 1000}) {
+        const expected<int, Code> strange{unexpect, Code{raw}};
+        bool threw = false;
+        try {
+            (void) classify(strange);
+        }
+        catch (const bad_expected_access<Code>& error) {
+            threw = error.error() == Code{raw};
+        }
+        assert(threw);
+    }
+}
+
+// handlers receive the value and the error with the value category of the expected
+template <class Expected>
+void check_category(Expected&& result, const bool rvalue, const bool is_const) {
+    const auto category = [&](auto&& arg) {
+        assert(std::is_rvalue_reference_v<decltype(arg)> == rvalue);
+        assert(std::is_const_v<std::remove_reference_t<decltype(arg)>> == is_const);
+        return 0;
+    };
+    (void) match(std::forward<Expected>(result), category, on_error(category));
+}
+
+void test_forwarding() {
+    for (const bool has_value : {true, false}) {
+        expected<std::string, Code> result = has_value ? expected<std::string, Code>{"value"}
+                                                       : expected<std::string, Code>{unexpect, Code::denied};
+        check_category(result, false, false);
+        check_category(std::as_const(result), false, true);
+        check_category(std::move(result), true, false);
+        check_category(std::move(std::as_const(result)), true, true);
+    }
+
+    // an rvalue's value is moved into a handler that takes it by value
+    expected<std::unique_ptr<int>, Code> owner{std::make_unique<int>(5)};
+    const int owned = match(std::move(owner), [](std::unique_ptr<int> ptr) { return *ptr; }, on_error([] { return 0; }));
+    assert(owned == 5);
+    assert(*owner == nullptr);
+}
+
+void test_void() {
+    int calls = 0;
+    const auto run = [&](const expected<void, Code>& result) {
+        return match(result, [&] { ++calls; return 0; },
+            on_error<Code::not_found>([](Code code) { return 10 + static_cast<int>(code); }),
+            on_error([] { return -1; }));
+    };
+
+    assert(run({}) == 0);
+    assert(calls == 1);
+    assert(run(expected<void, Code>{unexpect, Code::not_found}) == 10);
+    assert(run(expected<void, Code>{unexpect, Code::denied}) == -1);
+    assert(run(expected<void, Code>{unexpect, Code{9}}) == -1);
+    assert(calls == 1);
+
+    bool threw = false;
+    try {
+        match(expected<void, Code>{unexpect, Code{9}}, [] {}, on_error<Code::not_found>([] {}),
+            on_error<Code::timed_out>([] {}), on_error<Code::denied>([] {}));
+    }
+    catch (const bad_expected_access<Code>&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_many() {
+    for (int raw = -5; raw <= 30; ++raw) {
+        const expected<int, Many> result{unexpect, Many{raw}};
+        const int arm = match(result, [](int) { return 100; },
+            on_error<Many::e0>([] { return 0; }),
+            on_error<Many::e13>([] { return 13; }),
+            on_error<Many::e19>([] { return 19; }),
+            on_error([](Many code) { return -static_cast<int>(code) - 1000; }));
+        const int expected_arm = raw == 0 || raw == 13 || raw == 19 ? raw : -raw - 1000;
+        assert(arm == expected_arm);
+    }
+
+    const expected<int, Many> value{4};
+    assert(match(value, [](int v) { return v; }, on_error([] { return -1; })) == 4);
+}
+
+int main() {
+    test_catch_all();
+    test_no_catch_all();
+    test_forwarding();
+    test_void();
+    test_many();
+}
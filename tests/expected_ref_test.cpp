@@ -0,0 +1,129 @@
+// expected<T&, E>: assignment rebinds while *e = x assigns through, value_or takes only lvalues, and_then and
+// transform keep reference results, and with an empty E the object is a pointer whose null stands for the error.
+// Both storages are checked: the null pointer for an empty E and expected<T*, E> otherwise.
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::bad_expected_access;
+using std::experimental::expected;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+
+struct Missing {
+    friend bool operator==(Missing, Missing) = default;
+};
+
+struct Record {
+    int id;
+    std::string name;
+};
+
+template <class E, class A>
+concept value_or_accepts = requires(const E& e, A&& a) { e.value_or(std::forward<A>(a)); };
+
+static_assert(sizeof(expected<int&, Missing>) == sizeof(int*));
+static_assert(sizeof(expected<Record&, Missing>) == sizeof(Record*));
+static_assert(sizeof(expected<int&, int>) == sizeof(expected<int*, int>));
+static_assert(std::is_trivially_copyable_v<expected<int&, Missing>>);
+static_assert(std::is_same_v<expected<int&, int>::value_type, int&>);
+
+// binds only to lvalues, and value_or only takes lvalues
+static_assert(std::is_constructible_v<expected<int&, int>, int&>);
+static_assert(!std::is_constructible_v<expected<int&, int>, int>);
+static_assert(!std::is_constructible_v<expected<int&, int>, int&&>);
+static_assert(std::is_constructible_v<expected<const int&, int>, int&>);
+static_assert(value_or_accepts<expected<int&, int>, int&>);
+static_assert(!value_or_accepts<expected<int&, int>, int>);
+static_assert(!value_or_accepts<expected<int&, int>, int&&>);
+static_assert(!value_or_accepts<expected<int&, Missing>, int>);
+static_assert(!value_or_accepts<expected<const int&, int>, int&&>);
+static_assert(!value_or_accepts<expected<const Record&, int>, const Record&&>);
+static_assert(std::is_same_v<decltype(std::declval<const expected<int&, int>&>().value_or(std::declval<int&>())), int&>);
+
+template <class E>
+void check(const E error) {
+    using Ref = expected<int&, E>;
+
+    int a = 1;
+    int b = 2;
+
+    // assignment rebinds, *e = x assigns through
+    Ref ra{a};
+    Ref rb{b};
+    assert(&*ra == &a);
+    ra = rb;
+    assert(&*ra == &b && a == 1 && b == 2);
+    *ra = 20;
+    assert(b == 20 && a == 1);
+    const Ref shallow{a}; // const-shallow: *e is an int&
+    *shallow = 10;
+    assert(a == 10);
+
+    // to an error and back by emplace, which rebinds
+    ra = unexpected(error);
+    assert(!ra.has_value() && ra.error() == error);
+    assert(&ra.value_or(a) == &a);
+    int& rebound = ra.emplace(a);
+    assert(ra.has_value() && &rebound == &a && &*ra == &a);
+    assert(&ra.value_or(b) == &a);
+
+    // swap exchanges the bindings, not the values
+    Ref failed{unexpect, error};
+    ra.swap(failed);
+    assert(!ra.has_value() && &*failed == &a && a == 10);
+
+    bool thrown = false;
+    try {
+        (void) ra.value();
+    } catch (const bad_expected_access<E>& ex) {
+        thrown = ex.error() == error;
+    }
+    assert(thrown);
+
+    // transform keeps lvalue reference results and copies the others
+    Record rec{7, "seven"};
+    expected<Record&, E> found{rec};
+    auto name = found.transform([](Record& r) -> std::string& { return r.name; });
+    static_assert(std::is_same_v<decltype(name), expected<std::string&, E>>);
+    assert(&*name == &rec.name);
+    auto id = found.transform([](Record& r) { return r.id; });
+    static_assert(std::is_same_v<decltype(id), expected<int, E>>);
+    assert(*id == 7);
+
+    // and_then passes the reference on, and may return a reference or fail
+    auto same = found.and_then([](Record& r) { return expected<int&, E>{r.id}; });
+    static_assert(std::is_same_v<decltype(same), expected<int&, E>>);
+    assert(&*same == &rec.id);
+    const E err = error;
+    auto fails = found.and_then([err](Record&) -> expected<int&, E> { return unexpected(err); });
+    assert(!fails.has_value() && fails.error() == error);
+
+    // an error is carried along and recovered with another reference
+    expected<Record&, E> missing{unexpect, error};
+    auto missing_name = missing.transform([](Record& r) -> std::string& { return r.name; });
+    assert(!missing_name.has_value() && missing_name.error() == error);
+    Record fallback{0, "fallback"};
+    auto recovered = missing.or_else([&fallback](const E&) { return expected<Record&, E>{fallback}; });
+    assert(&*recovered == &fallback);
+    auto kept = found.or_else([&fallback](const E&) { return expected<Record&, E>{fallback}; });
+    assert(&*kept == &rec);
+    auto renamed = missing.transform_error([](const E&) { return 5L; });
+    static_assert(std::is_same_v<decltype(renamed), expected<Record&, long>>);
+    assert(renamed.error() == 5L);
+
+    // comparisons look at the referenced values
+    int other_ten = 10;
+    assert((Ref{a} == Ref{other_ten}));
+    assert(Ref{a} == 10);
+    assert(missing == unexpected(error));
+}
+
+int main() {
+    check(Missing{});
+    check(42);
+}
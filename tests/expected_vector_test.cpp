@@ -0,0 +1,157 @@
+// expected_vector against a vector<expected> model: push_back, pop_back and set across the 64-bit words of the
+// error bitmap, find_first_error from every position, and count_errors/all_ok after pops, which must clear the
+// bits past the end. Built once with the SSE2/AVX2 scanning the target allows and once without
+// (_USE_EXPECTED_VECTOR_ALGORITHMS=0).
+
+#include <cassert>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cpp20_expected/expected_vector.h"
+
+using std::experimental::expected;
+using std::experimental::expected_vector;
+using std::experimental::unexpected;
+
+using Result = expected<std::string, int>;
+
+struct Checked {
+    expected_vector<std::string, int> vec;
+    std::vector<Result> model;
+
+    void check() const {
+        assert(vec.size() == model.size());
+        std::size_t errors = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            assert(vec.has_value(i) == model[i].has_value());
+            assert(vec.get(i) == model[i]);
+            errors += !model[i].has_value();
+        }
+        assert(vec.count_errors() == errors);
+        assert(vec.all_ok() == (errors == 0));
+
+        // from every position, including the middle of each word and one past the end
+        std::size_t next = model.size();
+        for (std::size_t first = model.size() + 1; first-- > 0;) {
+            if (first < model.size() && !model[first].has_value()) {
+                next = first;
+            }
+            assert(vec.find_first_error(first) == next);
+        }
+        assert(vec.find_first_error(model.size() + 200) == model.size());
+    }
+
+    void push(const Result& r) {
+        vec.push_back(r);
+        model.push_back(r);
+    }
+
+    void pop() {
+        vec.pop_back();
+        model.pop_back();
+    }
+
+    void set(std::size_t i, const Result& r) {
+        vec.set(i, r);
+        model[i] = r;
+    }
+};
+
+Result value_at(std::size_t i) {
+    return std::string(i % 3 == 0 ? 40 : 3, static_cast<char>('a' + i % 26));
+}
+
+Result error_at(std::size_t i) {
+    return unexpected(static_cast<int>(i));
+}
+
+int main() {
+    // sizes around the word boundary, with the last element an error or a value
+    for (const std::size_t size : {63u, 64u, 65u, 127u, 128u, 129u}) {
+        for (const bool last_error : {false, true}) {
+            Checked c;
+            for (std::size_t i = 0; i < size; ++i) {
+                c.push(i + 1 == size && last_error ? error_at(i) : value_at(i));
+            }
+            c.check();
+            c.pop();
+            c.check();
+            c.push(value_at(size));
+            c.check();
+        }
+    }
+
+    // errors in every word, then pops down across word boundaries: the bits of popped errors must not linger
+    {
+        Checked c;
+        for (std::size_t i = 0; i < 300; ++i) {
+            c.push(i % 7 == 3 || i == 63 || i == 64 || i == 255 ? error_at(i) : value_at(i));
+        }
+        c.check();
+        for (const std::size_t size : {256u, 255u, 129u, 65u, 64u, 63u, 3u, 0u}) {
+            while (c.model.size() > size) {
+                c.pop();
+            }
+            c.check();
+        }
+
+        // regrowing with values only leaves no stale error bits behind
+        for (std::size_t i = 0; i < 200; ++i) {
+            c.push(value_at(i));
+        }
+        c.check();
+        assert(c.vec.all_ok() && c.vec.count_errors() == 0);
+    }
+
+    // set switching alternatives on both sides of the word boundaries
+    {
+        Checked c;
+        for (std::size_t i = 0; i < 260; ++i) {
+            c.push(value_at(i));
+        }
+        for (const std::size_t i : {0u, 62u, 63u, 64u, 65u, 127u, 128u, 200u, 259u}) {
+            c.set(i, error_at(i + 1000));
+        }
+        c.check();
+        c.set(64, value_at(1));
+        c.set(63, error_at(7)); // an error replaced by another error
+        c.set(259, value_at(2));
+        c.check();
+        assert(c.vec.find_first_error(1) == 62);
+        assert(c.vec.find_first_error(66) == 127);
+        assert(c.vec.find_first_error(129) == 200);
+        assert(c.vec.find_first_error(201) == 260);
+    }
+
+    // random operations, checked after each step
+    {
+        std::mt19937 rng(7);
+        Checked c;
+        for (int step = 0; step < 3000; ++step) {
+            const unsigned op = rng() % 10;
+            if (op < 5 || c.model.empty()) {
+                const std::size_t i = c.model.size();
+                c.push(rng() % 4 == 0 ? error_at(i) : value_at(i));
+            } else if (op < 7) {
+                c.pop();
+            } else {
+                const std::size_t i = rng() % c.model.size();
+                c.set(i, rng() % 2 == 0 ? error_at(i) : value_at(i));
+            }
+            if (step % 16 == 0) {
+                c.check();
+            }
+        }
+        c.check();
+
+        // copies keep the bitmap and both arrays
+        Checked copy{c.vec, c.model};
+        copy.check();
+        c.vec.clear();
+        c.model.clear();
+        c.check();
+        copy.check();
+    }
+}
@@ -0,0 +1,202 @@
+// [expected.niche]: expected keeps its discriminant in a never-null pointer at a non-zero offset of the error or of
+// the value (pointer_niche_traits), and in an unused enumerator value (value_niche_traits). Each layout is driven
+// through construction, assignment, swap, emplace, the monadic operations and value_or, in both states.
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::pointer_niche_traits;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+using std::experimental::value_niche_traits;
+
+// where an error was raised; the file name is never null
+struct Rec {
+    long id;
+    int line;
+    const char* file;
+
+    friend bool operator==(const Rec&, const Rec&) = default;
+};
+
+// the same, after more bytes than a std::string takes
+struct Wide {
+    std::string message;
+    const char* file;
+
+    friend bool operator==(const Wide&, const Wide&) = default;
+};
+
+enum class Fault { disk = 1, network = 2 };
+
+template <>
+struct std::experimental::niche_traits<Rec> : pointer_niche_traits<Rec, offsetof(Rec, file)> {};
+
+template <>
+struct std::experimental::niche_traits<Wide> : pointer_niche_traits<Wide, offsetof(Wide, file)> {};
+
+template <>
+struct std::experimental::niche_traits<Fault> : value_niche_traits<Fault, Fault{-1}> {};
+
+static_assert(offsetof(Rec, file) != 0);
+static_assert(sizeof(expected<int, Rec>) == sizeof(Rec));
+static_assert(sizeof(expected<long long, Rec>) == sizeof(Rec));
+static_assert(sizeof(expected<Rec, int>) == sizeof(Rec));
+static_assert(sizeof(expected<std::string, Wide>) == sizeof(Wide));
+static_assert(sizeof(expected<void, Rec>) == sizeof(Rec));
+static_assert(sizeof(expected<void, Fault>) == sizeof(Fault));
+
+// a value as large as the bytes before the pointer still fits; a larger one does not
+struct Prefix {
+    char bytes[offsetof(Rec, file)];
+
+    friend bool operator==(const Prefix&, const Prefix&) = default;
+};
+struct Overlap {
+    char bytes[offsetof(Rec, file) + 1];
+};
+static_assert(sizeof(expected<Prefix, Rec>) == sizeof(Rec));
+static_assert(sizeof(expected<Overlap, Rec>) > sizeof(Rec));
+
+// a niche at offset 0 serves only expected<void, E>, since any value would overlap it
+static_assert(sizeof(expected<short, Fault>) > sizeof(Fault));
+
+template <class T, class E>
+void drive(const T& v1, const T& v2, const E& e1, const E& e2) {
+    using X = expected<T, E>;
+
+    const X value{v1};
+    const X error{unexpect, e1};
+    assert(value.has_value() && *value == v1);
+    assert(!error.has_value() && error.error() == e1);
+
+    // assignment in each of the four directions
+    X target{value};
+    target = error;
+    assert(!target.has_value() && target.error() == e1);
+    target = X{unexpect, e2};
+    assert(!target.has_value() && target.error() == e2);
+    target = value;
+    assert(target.has_value() && *target == v1);
+    target = X{v2};
+    assert(target.has_value() && *target == v2);
+    target = unexpected(e1);
+    assert(!target.has_value() && target.error() == e1);
+    target = v1;
+    assert(target.has_value() && *target == v1);
+
+    // swap between and within the states
+    X left{v1};
+    X right{unexpect, e2};
+    swap(left, right);
+    assert(!left.has_value() && left.error() == e2);
+    assert(right.has_value() && *right == v1);
+    left.swap(right);
+    assert(left.has_value() && *left == v1);
+    assert(!right.has_value() && right.error() == e2);
+    X other_value{v2};
+    swap(left, other_value);
+    assert(*left == v2 && *other_value == v1);
+    X other_error{unexpect, e1};
+    swap(right, other_error);
+    assert(right.error() == e1 && other_error.error() == e2);
+
+    // emplace over an error and over a value
+    X emplaced{unexpect, e1};
+    emplaced.emplace(T{v2});
+    assert(emplaced.has_value() && *emplaced == v2);
+    emplaced.emplace(T{v1});
+    assert(emplaced.has_value() && *emplaced == v1);
+
+    assert(value.value_or(v2) == v1);
+    assert(error.value_or(v2) == v2);
+    assert(X{v1}.value_or(v2) == v1);
+    assert((X{unexpect, e1}.value_or(v2) == v2));
+    assert(value.error_or(e2) == e2);
+    assert(error.error_or(e2) == e1);
+
+    const auto same = [](const T& val) { return val; };
+    assert(value.transform(same) == value);
+    assert(error.transform(same) == error);
+    assert(value.transform([](const T&) { return 1; }).value() == 1);
+    assert(error.transform([](const T&) { return 1; }).error() == e1);
+    assert(value.transform_error([](const E&) { return 2; }).value() == v1);
+    assert(error.transform_error([](const E&) { return 2; }).error() == 2);
+    assert(value.and_then([&](const T&) { return X{unexpect, e2}; }).error() == e2);
+    assert(error.and_then([&](const T&) { return X{v2}; }).error() == e1);
+    assert(value.or_else([&](const E&) { return X{v2}; }).value() == v1);
+    assert(error.or_else([&](const E&) { return X{v2}; }).value() == v2);
+
+    assert(value == v1 && value != v2);
+    assert(error == unexpected(e1) && error != unexpected(e2));
+    assert(value != error);
+}
+
+template <class E>
+void drive_void(const E& e1, const E& e2) {
+    using X = expected<void, E>;
+
+    const X value;
+    const X error{unexpect, e1};
+    assert(value.has_value());
+    assert(!error.has_value() && error.error() == e1);
+
+    X target{value};
+    target = error;
+    assert(!target.has_value() && target.error() == e1);
+    target = X{unexpect, e2};
+    assert(target.error() == e2);
+    target = value;
+    assert(target.has_value());
+    target = unexpected(e1);
+    assert(target.error() == e1);
+
+    X left;
+    X right{unexpect, e2};
+    swap(left, right);
+    assert(!left.has_value() && left.error() == e2 && right.has_value());
+    X other_error{unexpect, e1};
+    swap(left, other_error);
+    assert(left.error() == e1 && other_error.error() == e2);
+
+    X emplaced{unexpect, e1};
+    emplaced.emplace();
+    assert(emplaced.has_value());
+    emplaced.emplace();
+    assert(emplaced.has_value());
+
+    assert(value.transform([] { return 3; }).value_or(0) == 3);
+    assert(error.transform([] { return 3; }).value_or(0) == 0);
+    assert(error.transform([] { return 3; }).error() == e1);
+    assert(value.error_or(e2) == e2);
+    assert(error.error_or(e2) == e1);
+    assert(value.and_then([&] { return X{unexpect, e2}; }).error() == e2);
+    assert(error.or_else([](const E&) { return X{}; }).has_value());
+
+    assert(value != error);
+    assert(error == unexpected(e1));
+}
+
+int main() {
+    const Rec disk{7, 12, "disk.cpp"};
+    const Rec net{-1, 40, "net.cpp"};
+
+    // a niche in the error, with a value that fills the bytes before it
+    drive<int>(-1, 42, disk, net);
+    drive<long long>(-1, 1LL << 40, disk, net);
+    drive<Prefix>(Prefix{{1, 2, 3}}, Prefix{{4, 5, 6}}, disk, net);
+
+    // a niche in the value, with an error that fills the bytes before it
+    drive<Rec, int>(disk, net, -1, 5);
+
+    // a niche after non-trivial members, with a non-trivial value
+    drive<std::string>(std::string(40, 'v'), "short", Wide{std::string(40, 'e'), "a.cpp"}, Wide{"", "b.cpp"});
+
+    drive_void(disk, net);
+    drive_void(Fault::disk, Fault::network);
+}
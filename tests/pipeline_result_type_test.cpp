@@ -0,0 +1,71 @@
+// The pipe and pipeline() give the result type of the member functions they stand for. A map stage returning U& on
+// a reference gives expected<U&, E>, as expected<T&, E>::transform does; on a value, where transform() rejects a
+// reference result, it gives expected<U, E>, a copy.
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#include "../cpp20_expected/expected.h"
+#include "../cpp20_expected/expected_pipeline.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+enum class EC { A = 1 };
+
+struct Pair {
+    int first;
+    int second;
+};
+
+constexpr auto first_of  = [](Pair& p) -> int& { return p.first; };
+constexpr auto copy_of   = [](const Pair& p) { return p.first; };
+constexpr auto ref_of    = [](Pair& p) { return expected<Pair&, EC>{std::in_place, p}; };
+constexpr auto plus_one  = [](int& v) { return v + 1; };
+constexpr auto recover_p = [](EC) -> expected<int&, EC> { return unexpected(EC::A); };
+
+template <class Expected, class Piped>
+void check_same_type(Expected&&, Piped&& piped) {
+    static_assert(std::is_same_v<std::remove_cvref_t<Expected>, decltype(std::forward<Piped>(piped).run())>);
+}
+
+int main() {
+    using std::experimental::and_then;
+    using std::experimental::or_else;
+    using std::experimental::pipeline;
+    using std::experimental::transform;
+
+    Pair pair{1, 2};
+    expected<Pair&, EC> ref{std::in_place, pair};
+    expected<Pair, EC> value{std::in_place, Pair{3, 4}};
+
+    // on a reference, U& stays a reference through the member function, pipeline() and the pipe
+    static_assert(std::is_same_v<decltype(ref.transform(first_of)), expected<int&, EC>>);
+    check_same_type(ref.transform(first_of), pipeline(ref).map(first_of));
+    check_same_type(ref.transform(first_of), ref | transform(first_of));
+    check_same_type(ref.transform(copy_of), ref | transform(copy_of));
+    check_same_type(ref.transform(first_of).transform(plus_one), ref | transform(first_of) | transform(plus_one));
+
+    // and_then and or_else keep the value type of F's result, a reference included
+    check_same_type(value.and_then(ref_of), value | and_then(ref_of));
+    check_same_type(value.and_then(ref_of).transform(first_of), value | and_then(ref_of) | transform(first_of));
+    check_same_type(ref.transform(first_of).or_else(recover_p), ref | transform(first_of) | or_else(recover_p));
+
+    // on a value, U& is copied
+    static_assert(std::is_same_v<decltype((value | transform(first_of)).run()), expected<int, EC>>);
+    check_same_type(value.transform(copy_of), value | transform(copy_of));
+
+    // the references refer to the original values
+    const expected<int&, EC> first = ref | transform(first_of);
+    assert(&*first == &pair.first);
+    const expected<int&, EC> after_then = value | and_then(ref_of) | transform(first_of);
+    assert(&*after_then == &value->first);
+    const expected<int, EC> copied = value | transform(first_of);
+    assert(*copied == 3 && &*copied != &value->first);
+    assert((ref | transform(first_of) | transform(plus_one)).run().value() == 2);
+
+    const expected<Pair&, EC> failed{std::experimental::unexpect, EC::A};
+    const expected<int&, EC> failed_ref = failed | transform(first_of);
+    assert(!failed_ref.has_value() && failed_ref.error() == EC::A);
+}
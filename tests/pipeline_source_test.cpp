@@ -0,0 +1,78 @@
+// A pipeline holds a source that is an rvalue, so it may be kept in a variable and run later, and refers to a
+// source that is an lvalue without copying it.
+
+#include <cassert>
+#include <string>
+#include <utility>
+
+#include "../cpp20_expected/expected.h"
+#include "../cpp20_expected/expected_pipeline.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+// counts the live objects and the copies
+struct Counted {
+    static inline int live   = 0;
+    static inline int copies = 0;
+
+    explicit Counted(int value) : value(value) {
+        ++live;
+    }
+    Counted(const Counted& other) : value(other.value) {
+        ++live;
+        ++copies;
+    }
+    Counted(Counted&& other) noexcept : value(other.value) {
+        ++live;
+    }
+    ~Counted() {
+        --live;
+    }
+
+    int value;
+};
+
+using Result = expected<Counted, std::string>;
+
+Result make_result(int value) {
+    return Result{std::in_place, value};
+}
+
+int main() {
+    using std::experimental::pipeline;
+    using std::experimental::transform;
+
+    // an rvalue source outlives the full-expression that built the pipeline
+    {
+        auto pipe = pipeline(make_result(20)).map([](const Counted& c) { return c.value + 1; });
+        assert(Counted::live == 1);
+        const expected<int, std::string> result = std::move(pipe).run();
+        assert(result.value() == 21);
+    }
+    assert(Counted::live == 0);
+
+    {
+        auto piped = make_result(3) | transform([](const Counted& c) { return c.value * 2; });
+        assert(Counted::live == 1);
+        assert(std::move(piped).run().value() == 6);
+    }
+    assert(Counted::live == 0);
+
+    // an lvalue source is referred to, not copied
+    {
+        const Result source = make_result(5);
+        const expected<int, std::string> result =
+            pipeline(source).map([](const Counted& c) { return c.value; }).map([](int v) { return v + 1; }).run();
+        assert(result.value() == 6);
+        assert(Counted::copies == 0);
+        assert(Counted::live == 1);
+    }
+
+    // an error from an rvalue source kept in a variable
+    {
+        auto pipe = pipeline(Result{unexpected(std::string(64, 'x'))}).map([](const Counted& c) { return c.value; });
+        assert(std::move(pipe).run().error() == std::string(64, 'x'));
+    }
+    assert(Counted::copies == 0);
+}
@@ -0,0 +1,231 @@
+// relocating_vector: growth, insert and erase with trivially and non-trivially relocatable elements, a copy that
+// throws in the middle of a constructor, and is_trivially_relocatable for expected and unexpected.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "../cpp20_expected/relocating_vector.h"
+
+using std::experimental::expected;
+using std::experimental::is_trivially_relocatable_v;
+using std::experimental::relocating_vector;
+using std::experimental::unexpected;
+
+// counts the blocks from operator new that are not freed yet
+static int live_blocks = 0;
+
+void* operator new(std::size_t size) {
+    if (void* const ptr = std::malloc(size == 0 ? 1 : size)) {
+        ++live_blocks;
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) {
+        --live_blocks;
+        std::free(ptr);
+    }
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+// Points to itself: a relocation by memcpy would leave self pointing to the old storage
+struct SelfRef {
+    static inline int live = 0;
+
+    explicit SelfRef(int value) : self(this), value(value) {
+        ++live;
+    }
+    SelfRef(const SelfRef& other) : self(this), value(other.value) {
+        ++live;
+    }
+    SelfRef(SelfRef&& other) noexcept : self(this), value(other.value) {
+        ++live;
+    }
+    SelfRef& operator=(const SelfRef& other) {
+        value = other.value;
+        return *this;
+    }
+    ~SelfRef() {
+        assert(self == this);
+        --live;
+    }
+
+    SelfRef* self;
+    int value;
+};
+
+// Not trivially copyable, but declared trivially relocatable: growth must not run its move constructor
+struct Relocatable {
+    static inline int moves = 0;
+
+    explicit Relocatable(int value) : value(value) {}
+    Relocatable(const Relocatable&) = default;
+    Relocatable(Relocatable&& other) noexcept : value(other.value) {
+        ++moves;
+    }
+    Relocatable& operator=(const Relocatable&) = default;
+    ~Relocatable() {}
+
+    int value;
+};
+
+template <>
+struct std::experimental::is_trivially_relocatable<Relocatable> : std::true_type {};
+
+// The third copy throws
+struct ThrowingCopy {
+    static inline int copies = 0;
+    static inline int live   = 0;
+
+    explicit ThrowingCopy(int value) : value(value) {
+        ++live;
+    }
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+        if (++copies == 3) {
+            throw std::runtime_error("third copy");
+        }
+        ++live;
+    }
+    ~ThrowingCopy() {
+        --live;
+    }
+
+    int value;
+};
+
+static_assert(is_trivially_relocatable_v<expected<int, int>>);
+static_assert(is_trivially_relocatable_v<expected<void, int>>);
+static_assert(is_trivially_relocatable_v<expected<int&, int>>);
+static_assert(is_trivially_relocatable_v<expected<Relocatable, Relocatable>>);
+static_assert(is_trivially_relocatable_v<expected<void, Relocatable>>);
+static_assert(is_trivially_relocatable_v<unexpected<Relocatable>>);
+static_assert(!is_trivially_relocatable_v<SelfRef>);
+static_assert(!is_trivially_relocatable_v<expected<SelfRef, int>>);
+static_assert(!is_trivially_relocatable_v<expected<int, SelfRef>>);
+static_assert(!is_trivially_relocatable_v<expected<void, SelfRef>>);
+static_assert(!is_trivially_relocatable_v<unexpected<SelfRef>>);
+
+template <class Vector>
+void check_values(const Vector& vec, std::initializer_list<int> values) {
+    assert(vec.size() == values.size());
+    std::size_t i = 0;
+    for (const int value : values) {
+        assert(vec[i++].value == value);
+    }
+}
+
+// push_back across several reallocations, then insert and erase at the front, middle and end
+template <class T>
+void grow_insert_erase() {
+    relocating_vector<T> vec;
+    for (int i = 0; i < 100; ++i) {
+        vec.push_back(T{i});
+    }
+    assert(vec.size() == 100 && vec.capacity() >= 100);
+    for (int i = 0; i < 100; ++i) {
+        assert(vec[static_cast<std::size_t>(i)].value == i);
+    }
+
+    vec.erase(vec.begin() + 3, vec.end());
+    check_values(vec, {0, 1, 2});
+    vec.shrink_to_fit();
+    assert(vec.capacity() == 3);
+
+    vec.insert(vec.begin(), T{-1}); // reallocates
+    vec.reserve(10);
+    vec.insert(vec.begin() + 2, T{10});
+    vec.insert(vec.end(), T{20});
+    vec.emplace(vec.begin() + 1, 30);
+    check_values(vec, {-1, 30, 0, 10, 1, 2, 20});
+
+    vec.insert(vec.begin(), vec[3]); // an element of the vector itself
+    check_values(vec, {10, -1, 30, 0, 10, 1, 2, 20});
+
+    vec.erase(vec.begin());
+    vec.erase(vec.begin() + 2);
+    vec.erase(vec.end() - 1);
+    check_values(vec, {-1, 30, 10, 1, 2});
+
+    relocating_vector<T> copy = vec;
+    vec.clear();
+    assert(vec.empty());
+    check_values(copy, {-1, 30, 10, 1, 2});
+}
+
+struct Int {
+    int value;
+};
+
+int main() {
+    const int blocks = live_blocks;
+
+    grow_insert_erase<Int>();
+    grow_insert_erase<SelfRef>();
+    assert(SelfRef::live == 0);
+
+    grow_insert_erase<Relocatable>();
+    {
+        relocating_vector<Relocatable> vec;
+        vec.reserve(1);
+        vec.emplace_back(1);
+        Relocatable::moves = 0;
+        for (int i = 0; i < 64; ++i) {
+            vec.emplace_back(i);
+        }
+        vec.erase(vec.begin());
+        vec.emplace(vec.begin(), 7);
+        assert(Relocatable::moves == 0);
+    }
+
+    {
+        relocating_vector<expected<int, std::string>> results;
+        for (int i = 0; i < 50; ++i) {
+            if (i % 3 == 0) {
+                results.push_back(unexpected(std::string(32, static_cast<char>('a' + i % 26))));
+            } else {
+                results.push_back(i);
+            }
+        }
+        results.erase(results.begin(), results.begin() + 10);
+        assert(results.size() == 40);
+        assert(!results[2].has_value() && results[2].error() == std::string(32, 'm'));
+        assert(results[3].value() == 13);
+    }
+
+    // a copy that throws in a constructor frees the buffer and destroys the copies made
+    {
+        const relocating_vector<ThrowingCopy> source{ThrowingCopy{1}, ThrowingCopy{2}};
+        assert(ThrowingCopy::copies == 2 && ThrowingCopy::live == 2);
+        ThrowingCopy::copies = 0;
+        bool thrown          = false;
+        try {
+            relocating_vector<ThrowingCopy> copy{ThrowingCopy{1}, ThrowingCopy{2}, ThrowingCopy{3}};
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(ThrowingCopy::live == 2);
+
+        ThrowingCopy::copies = 1;
+        thrown               = false;
+        try {
+            relocating_vector<ThrowingCopy> copy = source;
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(ThrowingCopy::live == 2);
+    }
+    assert(ThrowingCopy::live == 0);
+
+    assert(live_blocks == blocks);
+}
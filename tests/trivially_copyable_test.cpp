@@ -0,0 +1,61 @@
+// expected whose alternatives are trivially copyable is itself trivially copyable, so that std::copy and vector
+// reallocation use memmove (check_copy_codegen.sh checks the generated code); other alternatives keep the
+// user-provided operations.
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "../cpp20_expected/expected.h"
+
+using std::experimental::expected;
+using std::experimental::unexpected;
+
+struct Point {
+    int x;
+    int y;
+};
+
+struct Assigning { // trivially copy constructible, but not trivially copy assignable
+    Assigning& operator=(const Assigning&) {
+        return *this;
+    }
+    int value;
+};
+
+template <class T>
+constexpr bool trivially_copyable_all = std::is_trivially_copyable_v<T> && std::is_trivially_copy_constructible_v<T>
+                                     && std::is_trivially_move_constructible_v<T>
+                                     && std::is_trivially_copy_assignable_v<T>
+                                     && std::is_trivially_move_assignable_v<T> && std::is_trivially_destructible_v<T>;
+
+static_assert(trivially_copyable_all<expected<int, int>>);
+static_assert(trivially_copyable_all<expected<Point, long>>);
+static_assert(trivially_copyable_all<expected<void, int>>);
+static_assert(trivially_copyable_all<expected<void, std::error_code>>);
+static_assert(trivially_copyable_all<unexpected<int>>);
+
+static_assert(!std::is_trivially_copy_assignable_v<expected<Assigning, int>>);
+static_assert(!std::is_trivially_copy_assignable_v<expected<int, Assigning>>);
+static_assert(!std::is_trivially_copy_assignable_v<expected<void, Assigning>>);
+static_assert(std::is_copy_assignable_v<expected<Assigning, int>>);
+static_assert(!std::is_trivially_copyable_v<expected<std::string, int>>);
+static_assert(!std::is_trivially_copyable_v<expected<int, std::string>>);
+
+int main() {
+    // copies through the defaulted assignments keep both states
+    const expected<Point, long> source[] = {Point{1, 2}, unexpected(3L), Point{4, 5}};
+    expected<Point, long> target[3]      = {unexpected(9L), Point{7, 8}, unexpected(9L)};
+    std::copy(std::begin(source), std::end(source), std::begin(target));
+    assert(target[0].has_value() && target[0]->x == 1 && target[0]->y == 2);
+    assert(!target[1].has_value() && target[1].error() == 3);
+    assert(target[2].has_value() && target[2]->x == 4);
+
+    expected<void, int> empty = unexpected(1);
+    empty                     = expected<void, int>{};
+    assert(empty.has_value());
+    empty = unexpected(2);
+    assert(!empty.has_value() && empty.error() == 2);
+}
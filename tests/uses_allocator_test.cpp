@@ -0,0 +1,151 @@
+// [expected.alloc]: values and errors built through the allocator_arg_t constructors, copied and moved onto another
+// resource, and placed by pmr::vector, all use the allocator they were given. The default resource is null, so any
+// string that misses its allocator throws.
+
+#include <cassert>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../cpp20_expected/expected.h"
+
+using std::allocator_arg;
+using std::experimental::expected;
+using std::experimental::unexpect;
+using std::experimental::unexpected;
+
+using String = std::pmr::string;
+using Alloc  = std::pmr::polymorphic_allocator<char>;
+
+static_assert(std::uses_allocator_v<expected<int, String>, Alloc>);
+static_assert(std::uses_allocator_v<expected<String, int>, Alloc>);
+static_assert(std::uses_allocator_v<expected<void, String>, Alloc>);
+static_assert(std::uses_allocator_v<expected<int, String>, std::pmr::polymorphic_allocator<expected<int, String>>>);
+static_assert(!std::uses_allocator_v<expected<int, long>, Alloc>);
+static_assert(!std::uses_allocator_v<expected<String&, int>, Alloc>);
+static_assert(!std::uses_allocator_v<expected<int, String>, std::allocator<char>>);
+
+// longer than any small-string buffer, so that each string allocates
+constexpr const char* value_text = "a value that does not fit in the string object";
+constexpr const char* error_text = "an error that does not fit in the string object";
+
+bool uses(const String& str, std::pmr::memory_resource& resource) {
+    return str.get_allocator().resource() == &resource;
+}
+
+void test_construct(std::pmr::memory_resource& arena) {
+    const Alloc alloc{&arena};
+
+    const expected<String, String> empty{allocator_arg, alloc};
+    assert(empty.has_value() && empty->empty() && uses(*empty, arena));
+
+    const expected<String, String> value{allocator_arg, alloc, value_text};
+    assert(value.has_value() && *value == value_text && uses(*value, arena));
+
+    const expected<String, String> filled{allocator_arg, alloc, std::in_place, 40, 'x'};
+    assert(filled.has_value() && filled->size() == 40 && uses(*filled, arena));
+
+    const expected<int, String> error{allocator_arg, alloc, unexpect, error_text};
+    assert(!error.has_value() && error.error() == error_text && uses(error.error(), arena));
+
+    const unexpected<const char*> unex{error_text};
+    const expected<String, String> from_lvalue{allocator_arg, alloc, unex};
+    assert(!from_lvalue.has_value() && uses(from_lvalue.error(), arena));
+
+    const expected<int, String> from_rvalue{allocator_arg, alloc, unexpected<const char*>{error_text}};
+    assert(!from_rvalue.has_value() && uses(from_rvalue.error(), arena));
+
+    const unexpected<String> boxed{allocator_arg, alloc, std::in_place, error_text};
+    assert(uses(boxed.error(), arena));
+
+    // a payload that does not use the allocator ignores it
+    const expected<int, String> plain{allocator_arg, alloc, 42};
+    assert(plain.value() == 42);
+
+    const expected<void, String> ok{allocator_arg, alloc};
+    assert(ok.has_value());
+    const expected<void, String> ok_in_place{allocator_arg, alloc, std::in_place};
+    assert(ok_in_place.has_value());
+    const expected<void, String> failed{allocator_arg, alloc, unexpect, error_text};
+    assert(!failed.has_value() && uses(failed.error(), arena));
+}
+
+// copying or moving with an allocator rebuilds the active alternative on the new resource
+void test_copy_and_move(std::pmr::memory_resource& arena, std::pmr::memory_resource& other) {
+    const Alloc alloc{&arena};
+    const Alloc other_alloc{&other};
+
+    const expected<String, String> value{allocator_arg, alloc, value_text};
+    const expected<String, String> error{allocator_arg, alloc, unexpect, error_text};
+
+    const expected<String, String> value_copy{allocator_arg, other_alloc, value};
+    assert(value_copy.has_value() && *value_copy == value_text && uses(*value_copy, other));
+    const expected<String, String> error_copy{allocator_arg, other_alloc, error};
+    assert(!error_copy.has_value() && error_copy.error() == error_text && uses(error_copy.error(), other));
+
+    expected<String, String> value_source{allocator_arg, alloc, value};
+    const expected<String, String> value_moved{allocator_arg, other_alloc, std::move(value_source)};
+    assert(value_moved.has_value() && *value_moved == value_text && uses(*value_moved, other));
+    expected<String, String> error_source{allocator_arg, alloc, error};
+    const expected<String, String> error_moved{allocator_arg, other_alloc, std::move(error_source)};
+    assert(!error_moved.has_value() && error_moved.error() == error_text && uses(error_moved.error(), other));
+
+    const expected<void, String> ok{allocator_arg, alloc};
+    const expected<void, String> ok_copy{allocator_arg, other_alloc, ok};
+    assert(ok_copy.has_value());
+    expected<void, String> ok_source{allocator_arg, alloc, ok};
+    const expected<void, String> ok_moved{allocator_arg, other_alloc, std::move(ok_source)};
+    assert(ok_moved.has_value());
+
+    const expected<void, String> failed{allocator_arg, alloc, unexpect, error_text};
+    const expected<void, String> failed_copy{allocator_arg, other_alloc, failed};
+    assert(!failed_copy.has_value() && failed_copy.error() == error_text && uses(failed_copy.error(), other));
+    expected<void, String> failed_source{allocator_arg, alloc, failed};
+    const expected<void, String> failed_moved{allocator_arg, other_alloc, std::move(failed_source)};
+    assert(!failed_moved.has_value() && failed_moved.error() == error_text && uses(failed_moved.error(), other));
+}
+
+// pmr::vector hands its allocator to each element, including the ones it relocates as it grows
+void test_vector(std::pmr::memory_resource& arena, std::pmr::memory_resource& other) {
+    std::pmr::vector<expected<int, String>> results{&arena};
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0) {
+            results.emplace_back(unexpect, error_text);
+        }
+        else {
+            results.emplace_back(i);
+        }
+    }
+
+    const expected<int, String> elsewhere{allocator_arg, Alloc{&other}, unexpect, error_text};
+    results.push_back(elsewhere);
+
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0) {
+            assert(!results[i].has_value() && results[i].error() == error_text && uses(results[i].error(), arena));
+        }
+        else {
+            assert(results[i].value() == i);
+        }
+    }
+    assert(uses(results.back().error(), arena));
+
+    std::pmr::vector<expected<void, String>> outcomes{&arena};
+    outcomes.emplace_back();
+    outcomes.emplace_back(unexpect, error_text);
+    assert(outcomes[0].has_value());
+    assert(!outcomes[1].has_value() && uses(outcomes[1].error(), arena));
+}
+
+int main() {
+    std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+    std::pmr::monotonic_buffer_resource arena{std::pmr::new_delete_resource()};
+    std::pmr::monotonic_buffer_resource other{std::pmr::new_delete_resource()};
+
+    test_construct(arena);
+    test_copy_and_move(arena, other);
+    test_vector(arena, other);
+}